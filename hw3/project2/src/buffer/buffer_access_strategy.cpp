@@ -0,0 +1,37 @@
+/**
+ * buffer_access_strategy.cpp
+ */
+
+#include "buffer/buffer_access_strategy.h"
+
+namespace scudb {
+
+BufferAccessStrategy::BufferAccessStrategy(size_t ring_size)
+    : ring_(ring_size == 0 ? 1 : ring_size), current_(ring_.size() - 1) {}
+
+/*
+ * Slots are used round robin. With a partitioned buffer pool each slot keeps
+ * the instance of its frame, a slot whose frame belongs to another instance
+ * than the one asking is given a new frame.
+ */
+bool BufferAccessStrategy::Next(BufferPoolManager *owner, size_t &frame_id,
+                                page_id_t &page_id) {
+  current_ = (current_ + 1) % ring_.size();
+  const Slot &slot = ring_[current_];
+  if (slot.owner != owner || slot.page_id == INVALID_PAGE_ID) {
+    return false;
+  }
+  frame_id = slot.frame_id;
+  page_id = slot.page_id;
+  return true;
+}
+
+void BufferAccessStrategy::Set(BufferPoolManager *owner, size_t frame_id,
+                               page_id_t page_id) {
+  Slot &slot = ring_[current_];
+  slot.owner = owner;
+  slot.frame_id = frame_id;
+  slot.page_id = page_id;
+}
+
+} // namespace scudb
@@ -1,172 +1,197 @@
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
 #include "buffer/buffer_pool_manager.h"
 
 namespace scudb {
 
 /*
- * BufferPoolManager Constructor
- * When log_manager is nullptr, logging is disabled (for test purpose)
- * WARNING: Do Not Edit This Function
+ * A warm state dump is WARM_STATE_MAGIC and the number of page ids, followed
+ * by the page ids, all in host byte order. It is written to a temporary file
+ * renamed over the old dump, so a crash in the middle keeps the old one.
  */
-BufferPoolManager::BufferPoolManager(size_t pool_size,
-                                                 DiskManager *disk_manager,
-                                                 LogManager *log_manager)
-    : pool_size_(pool_size), disk_manager_(disk_manager),
-      log_manager_(log_manager) {
-  // a consecutive memory space for buffer pool
-  pages_ = new Page[pool_size_];
-  page_table_ = new ExtendibleHash<page_id_t, Page *>(BUCKET_SIZE);
-  replacer_ = new LRUReplacer<Page *>;
-  free_list_ = new std::list<Page *>;
-
-  // put all the pages into free list
-  for (size_t i = 0; i < pool_size_; ++i) {
-    free_list_->push_back(&pages_[i]);
+static const uint32_t WARM_STATE_MAGIC = 0x5357524d;
+
+static bool WriteWarmState(const std::string &file_name,
+                           const std::vector<page_id_t> &page_ids) {
+  std::string tmp_file_name = file_name + ".tmp";
+  std::ofstream out(tmp_file_name,
+                    std::ios::binary | std::ios::out | std::ios::trunc);
+  uint32_t count = page_ids.size();
+  out.write(reinterpret_cast<const char *>(&WARM_STATE_MAGIC),
+            sizeof(WARM_STATE_MAGIC));
+  out.write(reinterpret_cast<const char *>(&count), sizeof(count));
+  out.write(reinterpret_cast<const char *>(page_ids.data()),
+            count * sizeof(page_id_t));
+  out.close();
+  if(!out) {
+    remove(tmp_file_name.c_str());
+    return false;
   }
+  return rename(tmp_file_name.c_str(), file_name.c_str()) == 0;
 }
 
+static bool ReadWarmState(const std::string &file_name,
+                          std::vector<page_id_t> &page_ids) {
+  std::ifstream in(file_name, std::ios::binary | std::ios::in);
+  uint32_t magic = 0;
+  uint32_t count = 0;
+  in.read(reinterpret_cast<char *>(&magic), sizeof(magic));
+  in.read(reinterpret_cast<char *>(&count), sizeof(count));
+  if(!in || magic != WARM_STATE_MAGIC) {
+    return false;
+  }
+  page_ids.resize(count);
+  in.read(reinterpret_cast<char *>(page_ids.data()),
+          count * sizeof(page_id_t));
+  if(!in) {
+    page_ids.clear();
+    return false;
+  }
+  return true;
+}
+
+BufferPoolManager::BufferPoolManager(size_t page_size)
+    : page_size_(page_size), warm_state_thread_(nullptr),
+      warm_state_running_(false), warm_state_interval_(0) {}
+
 /*
- * BufferPoolManager Deconstructor
- * WARNING: Do Not Edit This Function
+ * The warm state thread is stopped by the implementation already, its last
+ * dump calls CollectWarmPages()
  */
 BufferPoolManager::~BufferPoolManager() {
-  delete[] pages_;
-  delete page_table_;
-  delete replacer_;
-  delete free_list_;
+  assert(warm_state_thread_ == nullptr);
 }
 
-/**
- * 1. search hash table.
- *  1.1 if exist, pin the page and return immediately
- *  1.2 if no exist, find a replacement entry from either free list or lru
- *      replacer. (NOTE: always find from free list first)
- * 2. If the entry chosen for replacement is dirty, write it back to disk.
- * 3. Delete the entry for the old page from the hash table and insert an
- * entry for the new page.
- * 4. Update page metadata, read page content from disk file and return page
- * pointer
- */
-Page *BufferPoolManager::FetchPage(page_id_t page_id) {
-  std::lock_guard<std::mutex> lck(latch_);
-  Page* ptr = nullptr;
-  if(page_table_->Find(page_id, ptr)) {
-    // std::cout << "FetchPage: find and increase the pin count" << std::endl;
-    ptr->pin_count_++;
-    return ptr;
+BasicPageGuard BufferPoolManager::FetchPageBasic(
+    page_id_t page_id, BufferAccessStrategy *strategy) {
+  Page *page = FetchPage(page_id, strategy);
+  if(page == nullptr) {
+    return BasicPageGuard();
   }
-  else {
-    if(free_list_->size() > 0){
-      // std::cout << "FetchPage: from free list get a page" << std::endl;
-      ptr = free_list_->front();
-      free_list_->pop_front();
-    } else {
-      if(replacer_->Size() == 0) {
-        // std::cout << "FetchPage: no replace page" << std::endl;
-        return nullptr;
-      }
-      // std::cout << "FetchPage: find replace page" << std::endl;
-      replacer_->Victim(ptr);
-      if(ptr->is_dirty_) {
-        // std::cout << "FetchPage: replace page is dirty" << std::endl;
-        disk_manager_->WritePage(ptr->GetPageId(), ptr->data_);
-      }
-    }
-    page_table_->Remove(ptr->GetPageId());
-    disk_manager_->ReadPage(page_id, ptr->data_);
-    page_table_->Insert(page_id, ptr);
-    ptr->is_dirty_ = false;
-    ptr->page_id_ = page_id;
-    ptr->pin_count_ = 1;
-    // std::cout << "FetchPage: finish" << std::endl;
-    return ptr;
+  return BasicPageGuard(this, page);
+}
+
+ReadPageGuard BufferPoolManager::FetchPageRead(page_id_t page_id,
+                                               BufferAccessStrategy *strategy) {
+  Page *page = FetchPage(page_id, strategy);
+  if(page == nullptr) {
+    return ReadPageGuard();
+  }
+  page->RLatch();
+  return ReadPageGuard(this, page);
+}
+
+WritePageGuard BufferPoolManager::FetchPageWrite(
+    page_id_t page_id, BufferAccessStrategy *strategy) {
+  Page *page = FetchPage(page_id, strategy);
+  if(page == nullptr) {
+    return WritePageGuard();
   }
+  page->WLatch();
+  return WritePageGuard(this, page);
+}
+
+WritePageGuard BufferPoolManager::NewPageGuarded(
+    page_id_t &page_id, BufferAccessStrategy *strategy) {
+  Page *page = NewPage(page_id, strategy);
+  if(page == nullptr) {
+    return WritePageGuard();
+  }
+  page->WLatch();
+  return WritePageGuard(this, page);
 }
 
 /*
- * Implementation of unpin page
- * if pin_count>0, decrement it and if it becomes zero, put it back to
- * replacer if pin_count<=0 before this call, return false. is_dirty: set the
- * dirty flag of this page
+ * Snapshot dump, one "name value" pair per line
  */
-bool BufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty) {
-  std::lock_guard<std::mutex> lck(latch_);
-  Page* ptr;
-  if(page_table_->Find(page_id, ptr)){
-    ptr->is_dirty_ = is_dirty;
-    if(ptr->GetPinCount() > 0) {
-      ptr->pin_count_--;
-      if(ptr->GetPinCount() == 0){
-        replacer_->Insert(ptr);
-      }
-      return true;
-    } 
-  }
-  return false;
+std::string BufferPoolStats::ToString() const {
+  std::ostringstream os;
+  os << "pool_size " << pool_size << "\n"
+     << "free_frames " << free_frames << "\n"
+     << "pinned_frames " << pinned_frames << "\n"
+     << "dirty_frames " << dirty_frames << "\n"
+     << "hits " << hits << "\n"
+     << "misses " << misses << "\n"
+     << "hit_ratio " << (hits + misses == 0 ? 0.0
+                         : static_cast<double>(hits) / (hits + misses))
+     << "\n"
+     << "evictions " << evictions << "\n"
+     << "write_backs " << write_backs << "\n"
+     << "latch_waits " << latch_waits << "\n"
+     << "latch_wait_us " << latch_wait_us << "\n"
+     << "ring_reuses " << ring_reuses << "\n"
+     << "disk_reads " << disk_reads.ToString() << "\n"
+     << "disk_writes " << disk_writes.ToString() << "\n";
+  return os.str();
+}
+
+/*
+ * Collect the resident pages and write them, see WriteWarmState(). Only page
+ * ids are kept, a dump of a large pool is still small.
+ */
+bool BufferPoolManager::DumpWarmState(const std::string &file_name) {
+  std::vector<page_id_t> page_ids;
+  CollectWarmPages(page_ids);
+  return WriteWarmState(file_name, page_ids);
 }
 
 /*
- * Used to flush a particular page of the buffer pool to disk. Should call the
- * write_page method of the disk manager
- * if page is not found in page table, return false
- * NOTE: make sure page_id != INVALID_PAGE_ID
+ * Read a dump and hand it to StartWarmRestore(). A missing or broken dump
+ * restores nothing.
  */
-bool BufferPoolManager::FlushPage(page_id_t page_id) {
-  std::lock_guard<std::mutex> lck(latch_);
-  Page* ptr;
-  if(page_table_->Find(page_id, ptr) && page_id != INVALID_PAGE_ID){
-    disk_manager_->WritePage(page_id, ptr->GetData());
+size_t BufferPoolManager::RestoreWarmState(const std::string &file_name) {
+  std::vector<page_id_t> page_ids;
+  if(!ReadWarmState(file_name, page_ids)) {
+    return 0;
   }
-  return false;
+  return StartWarmRestore(page_ids);
 }
 
-/**
- * User should call this method for deleting a page. This routine will call
- * disk manager to deallocate the page. First, if page is found within page
- * table, buffer pool manager should be reponsible for removing this entry out
- * of page table, reseting page metadata and adding back to free list. Second,
- * call disk manager's DeallocatePage() method to delete from disk file. If
- * the page is found within page table, but pin_count != 0, return false
+/*
+ * Start the warm state thread, see WarmStateLoop()
  */
-bool BufferPoolManager::DeletePage(page_id_t page_id) {
-  std::lock_guard<std::mutex> lck(latch_);
-  Page* ptr;
-  if(page_table_->Find(page_id, ptr) ) {
-    if(ptr->pin_count_ != 0){
-      page_table_->Remove(page_id);
-      free_list_->push_back(ptr);
-      disk_manager_->DeallocatePage(page_id);
-    } else return false;
+void BufferPoolManager::RunWarmStateThread(const std::string &file_name,
+                                           std::chrono::milliseconds interval) {
+  std::lock_guard<std::mutex> lck(warm_state_latch_);
+  if(warm_state_thread_ != nullptr) {
+    return;
   }
-  return false;
+  warm_state_file_ = file_name;
+  warm_state_interval_ = interval;
+  warm_state_running_ = true;
+  warm_state_thread_ =
+      new std::thread(&BufferPoolManager::WarmStateLoop, this);
 }
 
-/**
- * User should call this method if needs to create a new page. This routine
- * will call disk manager to allocate a page.
- * Buffer pool manager should be responsible to choose a victim page either
- * from free list or lru replacer(NOTE: always choose from free list first),
- * update new page's metadata, zero out memory and add corresponding entry
- * into page table. return nullptr if all the pages in pool are pinned
+/*
+ * Stop and join the warm state thread, then take the last dump
  */
-Page *BufferPoolManager::NewPage(page_id_t &page_id) {
-  std::lock_guard<std::mutex> lck(latch_);
-  Page* ptr = nullptr;
-  if(free_list_->size() > 0){
-    ptr = free_list_->front();
-    free_list_->pop_front();
-  } else {
-    if(replacer_->Size() == 0) return nullptr;
-    replacer_->Victim(ptr);
-    if(ptr->is_dirty_){
-      disk_manager_->WritePage(ptr->GetPageId(), ptr->GetData());
+void BufferPoolManager::StopWarmStateThread() {
+  {
+    std::lock_guard<std::mutex> lck(warm_state_latch_);
+    if(warm_state_thread_ == nullptr) {
+      return;
     }
-    page_table_->Remove(ptr->GetPageId());
+    warm_state_running_ = false;
+    warm_state_cv_.notify_one();
   }
-  page_id = disk_manager_->AllocatePage();
-  page_table_->Insert(page_id, ptr);
-  ptr->is_dirty_ = false;
-  ptr->page_id_ = page_id;
-  ptr->pin_count_ = 1;
-  return ptr;
+  warm_state_thread_->join();
+  delete warm_state_thread_;
+  warm_state_thread_ = nullptr;
+  DumpWarmState(warm_state_file_);
 }
+
+void BufferPoolManager::WarmStateLoop() {
+  std::unique_lock<std::mutex> lck(warm_state_latch_);
+  while(!warm_state_cv_.wait_for(lck, warm_state_interval_,
+                                 [this] { return !warm_state_running_; })) {
+    lck.unlock();
+    DumpWarmState(warm_state_file_);
+    lck.lock();
+  }
+}
+
 } // namespace scudb
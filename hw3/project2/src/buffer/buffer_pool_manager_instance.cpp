@@ -0,0 +1,1205 @@
+#include <algorithm>
+#include <cassert>
+#include <sys/mman.h>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "common/logger.h"
+
+namespace scudb {
+
+/*
+ * Memory for the content of a chunk of frames. It is mapped from the OS, so
+ * every frame is aligned as O_DIRECT requires. A chunk of at least a huge
+ * page is aligned to HUGE_PAGE_SIZE and advised to be backed by transparent
+ * huge pages, which saves TLB misses on large pools.
+ */
+static size_t FrameDataSize(size_t size) {
+  if(size < HUGE_PAGE_SIZE) {
+    return size;
+  }
+  return (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+}
+
+static char *AllocateFrameData(size_t size) {
+  size_t mapped_size = FrameDataSize(size);
+  size_t extra = size < HUGE_PAGE_SIZE ? 0 : HUGE_PAGE_SIZE;
+  void *mapped = mmap(nullptr, mapped_size + extra, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if(mapped == MAP_FAILED) {
+    throw std::bad_alloc();
+  }
+  char *data = static_cast<char *>(mapped);
+  if(extra != 0) {
+    // trim the mapping to a huge page boundary on both sides
+    size_t head = (HUGE_PAGE_SIZE -
+                   reinterpret_cast<uintptr_t>(data) % HUGE_PAGE_SIZE) %
+                  HUGE_PAGE_SIZE;
+    if(head != 0) {
+      munmap(data, head);
+    }
+    if(extra - head != 0) {
+      munmap(data + head + mapped_size, extra - head);
+    }
+    data += head;
+#ifdef MADV_HUGEPAGE
+    madvise(data, mapped_size, MADV_HUGEPAGE);
+#endif
+  }
+  return data;
+}
+
+static void FreeFrameData(char *data, size_t size) {
+  munmap(data, FrameDataSize(size));
+}
+
+/*
+ * BufferPoolManagerInstance Constructor
+ * When log_manager is nullptr, logging is disabled (for test purpose)
+ * replacer_type selects the replacement policy
+ */
+BufferPoolManagerInstance::BufferPoolManagerInstance(
+    size_t pool_size, DiskManager *disk_manager, LogManager *log_manager,
+    ReplacerType replacer_type)
+    : BufferPoolManager(disk_manager->GetPageSize()), pool_size_(pool_size),
+      disk_manager_(disk_manager),
+      log_manager_(log_manager), cleaner_thread_(nullptr),
+      cleaner_running_(false), cleaning_(false), low_watermark_(0),
+      high_watermark_(0), max_pages_per_sec_(0), prefetch_thread_(nullptr),
+      prefetch_running_(false), restore_thread_(nullptr),
+      restore_running_(false) {
+  page_table_ = new LinearProbeHashTable<page_id_t, Page *>(pool_size_);
+  switch (replacer_type) {
+  case ReplacerType::CLOCK:
+    // frames are indexed by their frame id
+    replacer_ = new ClockReplacer<Page *>(
+        pool_size_, [](Page *const &page) { return page->frame_id_; });
+    break;
+  case ReplacerType::LRU_K:
+    replacer_ =
+        new LRUKReplacer<Page *>(LRUK_REPLACER_K, LRUK_CORRELATED_PERIOD);
+    break;
+  default:
+    replacer_ = new LRUReplacer<Page *>;
+    break;
+  }
+  free_list_ = new std::list<Page *>;
+
+  // put all the pages into free list
+  AddFrames(pool_size_);
+}
+
+/*
+ * BufferPoolManagerInstance Deconstructor
+ * stop the background threads (warm state, restore, cleaner, prefetch)
+ * before freeing the frames they work on
+ */
+BufferPoolManagerInstance::~BufferPoolManagerInstance() {
+#ifndef NDEBUG
+  CheckPinLeaks();
+#endif
+  StopWarmStateThread();
+  {
+    std::lock_guard<std::mutex> lck(latch_);
+    restore_running_ = false;
+  }
+  WaitForWarmRestore();
+  StopCleanerThread();
+  if(prefetch_thread_ != nullptr) {
+    {
+      std::lock_guard<std::mutex> lck(latch_);
+      prefetch_running_ = false;
+      prefetch_cv_.notify_one();
+    }
+    prefetch_thread_->join();
+    delete prefetch_thread_;
+  }
+  for (auto &chunk : chunks_) {
+    delete[] chunk.pages;
+    FreeFrameData(chunk.data, chunk.size * page_size_);
+  }
+  delete page_table_;
+  delete replacer_;
+  delete free_list_;
+}
+
+/**
+ * 1. search hash table.
+ *  1.1 if exist, pin the page and return immediately
+ *  1.2 if no exist, find a replacement entry from either free list or lru
+ *      replacer. (NOTE: always find from free list first)
+ * 2. If the entry chosen for replacement is dirty, write it back to disk.
+ * 3. Delete the entry for the old page from the hash table and insert an
+ * entry for the new page.
+ * 4. Update page metadata, read page content from disk file and return page
+ * pointer
+ * Disk I/O of step 2 and 4 is done without holding latch_. Both the old and
+ * the new page id are recorded in in_flight_ meanwhile, other threads asking
+ * for either of them wait on io_cv_ instead of issuing their own read.
+ * With a strategy the frame of step 1.2 comes from its ring, and a page read
+ * ahead for the operation joins the ring on its first fetch.
+ */
+Page *BufferPoolManagerInstance::FetchPage(page_id_t page_id,
+                                           BufferAccessStrategy *strategy) {
+  std::unique_lock<std::mutex> lck = AcquireLatch();
+  WaitForIO(page_id, lck);
+  Page* ptr = nullptr;
+  if(page_table_->Find(page_id, ptr)) {
+    stats_.Add(HITS);
+    if(ptr->pin_count_++ == 0) {
+      replacer_->Erase(ptr);
+    }
+    if(ptr->prefetched_ && strategy != nullptr) {
+      // the frame it replaces in the ring is given back, if clean
+      Page *old = GetRingFrame(strategy, true);
+      if(old != nullptr) {
+        old->page_id_ = INVALID_PAGE_ID;
+        free_list_->push_back(old);
+      }
+      strategy->Set(this, ptr->frame_id_, page_id);
+    }
+    ptr->prefetched_ = false;
+    return ptr;
+  }
+  stats_.Add(MISSES);
+  ptr = GetVictimPage(strategy);
+  if(ptr == nullptr) {
+    return nullptr;
+  }
+  if(strategy != nullptr) {
+    strategy->Set(this, ptr->frame_id_, page_id);
+  }
+  page_id_t old_page_id = ptr->page_id_;
+  bool write_back = ptr->is_dirty_;
+  lsn_t write_lsn = GetWriteLSN(ptr);
+  page_table_->Insert(page_id, ptr);
+  ptr->SetClean();
+  ptr->prefetched_ = false;
+  ptr->page_id_ = page_id;
+  ptr->pin_count_ = 1;
+  in_flight_.insert(page_id);
+  if(write_back) {
+    in_flight_.insert(old_page_id);
+    stats_.Add(WRITE_BACKS);
+  }
+  lck.unlock();
+
+  // the frame is pinned and not reachable through page table until
+  // in_flight_ is cleared, nobody else touches its content
+  if(write_back) {
+    FlushLogTo(write_lsn);
+    disk_manager_->WritePage(old_page_id, ptr->data_);
+  }
+  disk_manager_->ReadPage(page_id, ptr->data_);
+
+  lck.lock();
+  in_flight_.erase(page_id);
+  if(write_back) {
+    in_flight_.erase(old_page_id);
+  }
+  io_cv_.notify_all();
+  return ptr;
+}
+
+/*
+ * Implementation of unpin page
+ * if pin_count>0, decrement it and if it becomes zero, put it back to
+ * replacer if pin_count<=0 before this call, return false. is_dirty: set the
+ * dirty flag of this page
+ */
+bool BufferPoolManagerInstance::UnpinPage(page_id_t page_id, bool is_dirty) {
+  std::unique_lock<std::mutex> lck = AcquireLatch();
+  Page* ptr;
+  if(page_table_->Find(page_id, ptr)){
+    return Unpin(ptr, is_dirty);
+  }
+  return false;
+}
+
+/*
+ * The caller holds a pin of page, so page is mapped in this pool and its
+ * frame can not change
+ */
+bool BufferPoolManagerInstance::UnpinFrame(Page *page, bool is_dirty) {
+  std::unique_lock<std::mutex> lck = AcquireLatch();
+  assert(page->frame_id_ < frames_.size() && frames_[page->frame_id_] == page);
+  return Unpin(page, is_dirty);
+}
+
+bool BufferPoolManagerInstance::Unpin(Page *ptr, bool is_dirty) {
+  // a clean unpin must not hide an earlier dirty one
+  ptr->is_dirty_ = ptr->is_dirty_ || is_dirty;
+  if(ptr->pin_count_ <= 0) {
+    return false;
+  }
+  if(--ptr->pin_count_ == 0) {
+    MakeEvictable(ptr);
+  }
+  return true;
+}
+
+/*
+ * Pages still pinned are reported with their pin count
+ */
+size_t BufferPoolManagerInstance::CheckPinLeaks() {
+  std::lock_guard<std::mutex> lck(latch_);
+  size_t num_pinned = 0;
+  for(auto ptr : frames_) {
+    if(ptr->pin_count_ > 0) {
+      LOG_WARN("page %d is still pinned %d times", ptr->page_id_,
+               ptr->pin_count_);
+      num_pinned++;
+    }
+  }
+  return num_pinned;
+}
+
+/*
+ * Used to flush a particular page of the buffer pool to disk. Should call the
+ * write_page method of the disk manager
+ * if page is not found in page table, return false
+ * NOTE: make sure page_id != INVALID_PAGE_ID
+ * The page is pinned while it is written so that it can not be evicted, the
+ * write itself is done without holding latch_ but under the read latch of
+ * the page, so that a writer can not tear the image. Its recLSN is only
+ * dropped once the write is done, and only if nobody may have changed it
+ * meanwhile, see GetDirtyPageTable().
+ */
+bool BufferPoolManagerInstance::FlushPage(page_id_t page_id) {
+  if(page_id == INVALID_PAGE_ID) {
+    return false;
+  }
+  std::unique_lock<std::mutex> lck = AcquireLatch();
+  WaitForIO(page_id, lck);
+  Page* ptr;
+  if(!page_table_->Find(page_id, ptr)) {
+    return false;
+  }
+  if(ptr->pin_count_++ == 0) {
+    replacer_->Erase(ptr);
+  }
+  stats_.Add(WRITE_BACKS);
+  lck.unlock();
+
+  // page latches are taken before latch_
+  ptr->RLatch();
+  lck.lock();
+  ptr->is_dirty_ = false;
+  lsn_t write_lsn = GetWriteLSN(ptr);
+  lck.unlock();
+  FlushLogTo(write_lsn);
+  disk_manager_->WritePage(page_id, ptr->GetData());
+  ptr->RUnlatch();
+
+  lck.lock();
+  if(ptr->pin_count_ == 1 && !ptr->is_dirty_) {
+    ptr->SetClean();
+  }
+  if(--ptr->pin_count_ == 0) {
+    MakeEvictable(ptr);
+  }
+  return true;
+}
+
+/*
+ * Pin every dirty page and write them in batches of CLEANER_BATCH_SIZE with
+ * DiskManager::WritePages(), which coalesces adjacent page ids. Pages are
+ * pinned the same way as in FlushPage(), and each one is copied under its
+ * read latch.
+ */
+void BufferPoolManagerInstance::FlushAllPages() {
+  std::vector<Page *> dirty_pages;
+  std::vector<std::pair<page_id_t, const char *>> batch;
+  std::unique_lock<std::mutex> lck = AcquireLatch();
+  for(auto ptr : frames_) {
+    if(ptr->page_id_ == INVALID_PAGE_ID || !ptr->is_dirty_ ||
+       in_flight_.count(ptr->page_id_) != 0) {
+      continue;
+    }
+    if(ptr->pin_count_++ == 0) {
+      replacer_->Erase(ptr);
+    }
+    dirty_pages.push_back(ptr);
+  }
+  stats_.Add(WRITE_BACKS, dirty_pages.size());
+  lck.unlock();
+
+  std::vector<char> buffer(CLEANER_BATCH_SIZE * page_size_);
+  for(size_t i = 0; i < dirty_pages.size(); i += batch.size()) {
+    lsn_t write_lsn = INVALID_LSN;
+    batch.clear();
+    while(batch.size() < CLEANER_BATCH_SIZE &&
+          i + batch.size() < dirty_pages.size()) {
+      Page *ptr = dirty_pages[i + batch.size()];
+      char *copy = buffer.data() + batch.size() * page_size_;
+      ptr->RLatch();
+      memcpy(copy, ptr->data_, page_size_);
+      lck.lock();
+      ptr->is_dirty_ = false;
+      write_lsn = std::max(write_lsn, GetWriteLSN(ptr));
+      lck.unlock();
+      ptr->RUnlatch();
+      batch.emplace_back(ptr->page_id_, copy);
+    }
+    FlushLogTo(write_lsn);
+    disk_manager_->WritePages(batch);
+  }
+
+  lck.lock();
+  for(auto ptr : dirty_pages) {
+    if(ptr->pin_count_ == 1 && !ptr->is_dirty_) {
+      ptr->SetClean();
+    }
+    if(--ptr->pin_count_ == 0) {
+      MakeEvictable(ptr);
+    }
+  }
+}
+
+/**
+ * User should call this method for deleting a page. This routine will call
+ * disk manager to deallocate the page. First, if page is found within page
+ * table, buffer pool manager should be reponsible for removing this entry out
+ * of page table, reseting page metadata and adding back to free list. Second,
+ * call disk manager's DeallocatePage() method to delete from disk file. If
+ * the page is found within page table, but pin_count != 0, return false
+ */
+bool BufferPoolManagerInstance::DeletePage(page_id_t page_id) {
+  std::unique_lock<std::mutex> lck = AcquireLatch();
+  WaitForIO(page_id, lck);
+  Page* ptr;
+  if(page_table_->Find(page_id, ptr) ) {
+    if(ptr->pin_count_ != 0) {
+      return false;
+    }
+    replacer_->Remove(ptr);
+    page_table_->Remove(page_id);
+    ptr->ResetMemory();
+    ptr->page_id_ = INVALID_PAGE_ID;
+    ptr->SetClean();
+    if(ptr->frame_id_ < pool_size_) {
+      free_list_->push_back(ptr);
+    } else {
+      io_cv_.notify_all();
+    }
+  }
+  disk_manager_->DeallocatePage(page_id);
+  return true;
+}
+
+/**
+ * User should call this method if needs to create a new page. This routine
+ * will call disk manager to allocate a page.
+ * Buffer pool manager should be responsible to choose a victim page either
+ * from free list or lru replacer(NOTE: always choose from free list first),
+ * update new page's metadata, zero out memory and add corresponding entry
+ * into page table. return nullptr if all the pages in pool are pinned
+ * With a strategy the frame comes from its ring, see FetchPage().
+ */
+Page *BufferPoolManagerInstance::NewPage(page_id_t &page_id,
+                                         BufferAccessStrategy *strategy) {
+  std::unique_lock<std::mutex> lck = AcquireLatch();
+  Page* ptr = GetVictimPage(strategy);
+  if(ptr == nullptr) {
+    return nullptr;
+  }
+  page_id = disk_manager_->AllocatePage();
+  if(strategy != nullptr) {
+    strategy->Set(this, ptr->frame_id_, page_id);
+  }
+  InstallNewPage(ptr, page_id, lck);
+  return ptr;
+}
+
+/*
+ * Same as NewPage(), except that the page id has already been allocated from
+ * the disk manager by the caller. Used by ParallelBufferPoolManager, which must
+ * know the page id before it can pick the instance that owns the page.
+ */
+Page *BufferPoolManagerInstance::NewPageWithId(page_id_t page_id,
+                                               BufferAccessStrategy *strategy) {
+  std::unique_lock<std::mutex> lck = AcquireLatch();
+  Page* ptr = GetVictimPage(strategy);
+  if(ptr == nullptr) {
+    return nullptr;
+  }
+  if(strategy != nullptr) {
+    strategy->Set(this, ptr->frame_id_, page_id);
+  }
+  InstallNewPage(ptr, page_id, lck);
+  return ptr;
+}
+
+/*
+ * Pick a frame for replacement, always from free list first, then from
+ * replacer. An operation with a strategy reuses the frames of its ring before
+ * anything else. The old entry of the victim is removed from page table, its
+ * page_id_ and is_dirty_ are left untouched so that the caller can write it
+ * back.
+ * NOTE: caller must hold latch_
+ * @return: nullptr if all the pages in pool are pinned
+ */
+Page *BufferPoolManagerInstance::GetVictimPage(BufferAccessStrategy *strategy) {
+  Page* ptr = nullptr;
+  if(strategy != nullptr && (ptr = GetRingFrame(strategy)) != nullptr) {
+    stats_.Add(RING_REUSES);
+    return ptr;
+  }
+  if(!free_list_->empty()) {
+    ptr = free_list_->front();
+    free_list_->pop_front();
+    return ptr;
+  }
+  if(!replacer_->Victim(ptr)) {
+    return nullptr;
+  }
+  stats_.Add(EVICTIONS);
+  if(ptr->is_dirty_) {
+    // the cleaner did not keep up
+    cleaner_cv_.notify_one();
+  }
+  page_table_->Remove(ptr->GetPageId());
+  return ptr;
+}
+
+/*
+ * Move the ring of strategy to its next slot and take its frame, provided the
+ * frame still holds the page the ring put there and nobody uses it. A dirty
+ * one is written back by the caller like any victim, unless clean_only is
+ * set. Frames released by Resize() are not taken.
+ * NOTE: caller must hold latch_
+ * @return: nullptr if the slot has no frame to give
+ */
+Page *BufferPoolManagerInstance::GetRingFrame(BufferAccessStrategy *strategy,
+                                              bool clean_only) {
+  size_t frame_id;
+  page_id_t page_id;
+  if(!strategy->Next(this, frame_id, page_id) || frame_id >= pool_size_) {
+    return nullptr;
+  }
+  Page *ptr = frames_[frame_id];
+  if(ptr->page_id_ != page_id || ptr->pin_count_ > 0 ||
+     (clean_only && ptr->is_dirty_) || in_flight_.count(page_id) != 0 ||
+     !replacer_->Erase(ptr)) {
+    return nullptr;
+  }
+  replacer_->Remove(ptr);
+  stats_.Add(EVICTIONS);
+  page_table_->Remove(page_id);
+  return ptr;
+}
+
+/*
+ * Map a victim frame to a freshly allocated page and zero it out. A dirty
+ * victim is written back with latch_ released, see FetchPage().
+ * NOTE: lck must hold latch_, it is held again on return
+ */
+void BufferPoolManagerInstance::InstallNewPage(
+    Page *ptr, page_id_t page_id, std::unique_lock<std::mutex> &lck) {
+  page_id_t old_page_id = ptr->page_id_;
+  bool write_back = ptr->is_dirty_;
+  lsn_t write_lsn = GetWriteLSN(ptr);
+  page_table_->Insert(page_id, ptr);
+  ptr->SetClean();
+  ptr->prefetched_ = false;
+  ptr->page_id_ = page_id;
+  ptr->pin_count_ = 1;
+  if(!write_back) {
+    ptr->ResetMemory();
+    return;
+  }
+
+  in_flight_.insert(page_id);
+  in_flight_.insert(old_page_id);
+  stats_.Add(WRITE_BACKS);
+  lck.unlock();
+  FlushLogTo(write_lsn);
+  disk_manager_->WritePage(old_page_id, ptr->data_);
+  ptr->ResetMemory();
+  lck.lock();
+  in_flight_.erase(page_id);
+  in_flight_.erase(old_page_id);
+  io_cv_.notify_all();
+}
+
+/*
+ * Start the background cleaner, see CleanerLoop()
+ */
+void BufferPoolManagerInstance::RunCleanerThread(size_t low_watermark,
+                                                 size_t high_watermark,
+                                                 size_t max_pages_per_sec) {
+  std::lock_guard<std::mutex> lck(latch_);
+  if(cleaner_thread_ != nullptr) {
+    return;
+  }
+  low_watermark_ = low_watermark;
+  high_watermark_ = std::max(low_watermark, high_watermark);
+  max_pages_per_sec_ = max_pages_per_sec;
+  cleaning_ = false;
+  cleaner_running_ = true;
+  cleaner_thread_ =
+      new std::thread(&BufferPoolManagerInstance::CleanerLoop, this);
+}
+
+/*
+ * Stop and join the cleaner thread
+ */
+void BufferPoolManagerInstance::StopCleanerThread() {
+  {
+    std::lock_guard<std::mutex> lck(latch_);
+    if(cleaner_thread_ == nullptr) {
+      return;
+    }
+    cleaner_running_ = false;
+    cleaner_cv_.notify_one();
+  }
+  cleaner_thread_->join();
+  delete cleaner_thread_;
+  cleaner_thread_ = nullptr;
+}
+
+/*
+ * The cleaner wakes up every CLEANER_TIMEOUT, or when an eviction had to
+ * write back a dirty victim. Up to CLEANER_BATCH_SIZE pages are copied and
+ * marked clean under latch_, then written as one batch with their page ids in
+ * in_flight_, so that a fetch of a page waits until the write is done even if
+ * the frame was evicted meanwhile. Taking the copy does not touch replacer,
+ * the pages keep their place at the cold end.
+ */
+void BufferPoolManagerInstance::CleanerLoop() {
+  std::vector<char> buffer(CLEANER_BATCH_SIZE * page_size_);
+  std::vector<std::pair<page_id_t, const char *>> batch;
+  auto interval = std::chrono::steady_clock::duration::zero();
+  if(max_pages_per_sec_ > 0) {
+    interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::seconds(1)) / max_pages_per_sec_;
+  }
+  auto next_write = std::chrono::steady_clock::now();
+
+  std::unique_lock<std::mutex> lck(latch_);
+  while(cleaner_running_) {
+    Page *ptr = GetPageToClean();
+    if(ptr == nullptr) {
+      cleaner_cv_.wait_for(lck, CLEANER_TIMEOUT);
+      continue;
+    }
+    auto now = std::chrono::steady_clock::now();
+    if(now < next_write) {
+      // rate limit, the page to clean may have changed when we wake up
+      cleaner_cv_.wait_until(lck, next_write);
+      continue;
+    }
+
+    while(ptr != nullptr && batch.size() < CLEANER_BATCH_SIZE) {
+      char *copy = buffer.data() + batch.size() * page_size_;
+      memcpy(copy, ptr->data_, page_size_);
+      ptr->SetClean();
+      in_flight_.insert(ptr->page_id_);
+      batch.emplace_back(ptr->page_id_, copy);
+      ptr = GetPageToClean();
+    }
+    next_write = now + interval * batch.size();
+    stats_.Add(WRITE_BACKS, batch.size());
+    lck.unlock();
+    disk_manager_->WritePages(batch);
+    lck.lock();
+    for(auto &entry : batch) {
+      in_flight_.erase(entry.first);
+    }
+    io_cv_.notify_all();
+    batch.clear();
+  }
+}
+
+/*
+ * Look at the first high_watermark_ victims of replacer. Cleaning starts once
+ * fewer than low_watermark_ frames are free or clean, and goes on until
+ * high_watermark_ of them are. A page whose LSN is not yet persistent in the
+ * log is skipped (WAL).
+ * NOTE: caller must hold latch_
+ */
+Page *BufferPoolManagerInstance::GetPageToClean() {
+  std::vector<Page *> candidates;
+  replacer_->PeekVictims(candidates, high_watermark_);
+  size_t num_clean = free_list_->size();
+  Page *to_clean = nullptr;
+  for(auto ptr : candidates) {
+    if(!ptr->is_dirty_) {
+      num_clean++;
+    } else if(to_clean == nullptr && in_flight_.count(ptr->page_id_) == 0 &&
+              (GetWriteLSN(ptr) == INVALID_LSN ||
+               GetWriteLSN(ptr) <= log_manager_->GetPersistentLSN())) {
+      to_clean = ptr;
+    }
+  }
+  if(num_clean >= high_watermark_) {
+    cleaning_ = false;
+  } else if(num_clean < low_watermark_) {
+    cleaning_ = true;
+  }
+  return cleaning_ ? to_clean : nullptr;
+}
+
+/*
+ * Queue pages for the prefetch thread. Pages that are resident already are
+ * skipped by the thread. At most a quarter of the pool is queued at a time so
+ * that readahead can not push the whole working set out.
+ */
+size_t BufferPoolManagerInstance::PrefetchPages(page_id_t first_page_id,
+                                                size_t count) {
+  if(first_page_id == INVALID_PAGE_ID) {
+    return 0;
+  }
+  page_id_t num_pages = disk_manager_->GetNumPages();
+  std::unique_lock<std::mutex> lck = AcquireLatch();
+  if(pool_size_ == 0) {
+    return 0;
+  }
+  size_t limit = std::max<size_t>(pool_size_ / 4, 1);
+  size_t queued = 0;
+  while(queued < count && prefetch_queue_.size() < limit &&
+        first_page_id + static_cast<page_id_t>(queued) < num_pages) {
+    prefetch_queue_.push_back(first_page_id + queued);
+    queued++;
+  }
+  if(queued == 0) {
+    return 0;
+  }
+  if(prefetch_thread_ == nullptr) {
+    prefetch_running_ = true;
+    prefetch_thread_ =
+        new std::thread(&BufferPoolManagerInstance::PrefetchLoop, this);
+  }
+  prefetch_cv_.notify_one();
+  return queued;
+}
+
+/*
+ * Take every queued page, claim a frame for each and read them all with
+ * async I/O, so that the whole batch is in flight at once. A page is mapped
+ * in page table with pin_count 0 and kept in in_flight_ during the read, a
+ * fetch of it waits for the read instead of issuing its own. Once read, the
+ * page goes to replacer like any unpinned page. When no frame can be taken
+ * without a write back the rest of the queue is dropped, the pool is busy
+ * enough.
+ */
+void BufferPoolManagerInstance::PrefetchLoop() {
+  std::vector<Page *> batch;
+  std::vector<std::future<void>> reads;
+  std::unique_lock<std::mutex> lck(latch_);
+  while(true) {
+    prefetch_cv_.wait(lck, [this] {
+      return !prefetch_running_ || !prefetch_queue_.empty();
+    });
+    if(!prefetch_running_) {
+      break;
+    }
+    while(!prefetch_queue_.empty()) {
+      page_id_t page_id = prefetch_queue_.front();
+      prefetch_queue_.pop_front();
+      Page *ptr = nullptr;
+      if(in_flight_.count(page_id) != 0 || page_table_->Find(page_id, ptr)) {
+        continue;
+      }
+      ptr = GetPrefetchFrame();
+      if(ptr == nullptr) {
+        prefetch_queue_.clear();
+        break;
+      }
+      page_table_->Insert(page_id, ptr);
+      ptr->page_id_ = page_id;
+      ptr->SetClean();
+      ptr->prefetched_ = true;
+      ptr->pin_count_ = 0;
+      in_flight_.insert(page_id);
+      batch.push_back(ptr);
+    }
+    lck.unlock();
+
+    for(auto ptr : batch) {
+      reads.push_back(disk_manager_->ReadPageAsync(ptr->page_id_, ptr->data_));
+    }
+    for(auto &read : reads) {
+      read.wait();
+    }
+
+    lck.lock();
+    for(auto ptr : batch) {
+      in_flight_.erase(ptr->page_id_);
+      if(ptr->pin_count_ == 0) {
+        MakeEvictable(ptr);
+      }
+    }
+    io_cv_.notify_all();
+    batch.clear();
+    reads.clear();
+  }
+}
+
+/*
+ * Take a free frame, or the next victim of replacer if it is clean. Dirty
+ * victims are left to eviction and the cleaner.
+ * NOTE: caller must hold latch_
+ */
+Page *BufferPoolManagerInstance::GetPrefetchFrame() {
+  Page *ptr = nullptr;
+  if(!free_list_->empty()) {
+    ptr = free_list_->front();
+    free_list_->pop_front();
+    return ptr;
+  }
+  std::vector<Page *> candidates;
+  if(replacer_->PeekVictims(candidates, 1) == 0) {
+    return nullptr;
+  }
+  ptr = candidates[0];
+  if(ptr->is_dirty_ || in_flight_.count(ptr->page_id_) != 0) {
+    return nullptr;
+  }
+  replacer_->Remove(ptr);
+  page_table_->Remove(ptr->page_id_);
+  stats_.Add(EVICTIONS);
+  return ptr;
+}
+
+/*
+ * Change the number of frames to new_pool_size.
+ * Growing first takes back frames released by an earlier shrink whose chunk
+ * is still allocated, then allocates a new chunk for the rest. All of them go
+ * to free list.
+ * Shrinking releases the frames with the highest frame ids, see ShrinkPool().
+ * Concurrent calls are serialized by resize_latch_, other operations go on
+ * while a shrink waits, and GetResizeProgress() can be polled meanwhile.
+ */
+void BufferPoolManagerInstance::Resize(size_t new_pool_size) {
+  std::lock_guard<std::mutex> resize_lck(resize_latch_);
+  std::unique_lock<std::mutex> lck(latch_);
+  resize_progress_ = ResizeProgress();
+  resize_progress_.in_progress = true;
+  resize_progress_.target_pool_size = new_pool_size;
+  if(new_pool_size < pool_size_) {
+    ShrinkPool(new_pool_size, lck);
+  } else {
+    for(size_t i = pool_size_; i < std::min(new_pool_size, frames_.size());
+        ++i) {
+      frames_[i]->ResetMemory();
+      free_list_->push_back(frames_[i]);
+    }
+    if(new_pool_size > frames_.size()) {
+      AddFrames(new_pool_size - frames_.size());
+    }
+    pool_size_ = new_pool_size;
+  }
+  resize_progress_.in_progress = false;
+}
+
+ResizeProgress BufferPoolManagerInstance::GetResizeProgress() {
+  std::lock_guard<std::mutex> lck(latch_);
+  return resize_progress_;
+}
+
+size_t BufferPoolManagerInstance::GetPoolSize() {
+  std::lock_guard<std::mutex> lck(latch_);
+  return pool_size_;
+}
+
+/*
+ * Allocate a chunk of count frames with consecutive frame ids after the
+ * existing ones, and put them into free list.
+ * NOTE: caller must hold latch_, or be the constructor
+ */
+void BufferPoolManagerInstance::AddFrames(size_t count) {
+  if(count == 0) {
+    return;
+  }
+  FrameChunk chunk;
+  chunk.pages = new Page[count];
+  chunk.data = AllocateFrameData(count * page_size_);
+  chunk.size = count;
+  for(size_t i = 0; i < count; ++i) {
+    Page *ptr = &chunk.pages[i];
+    ptr->data_ = chunk.data + i * page_size_;
+    ptr->page_size_ = page_size_;
+    ptr->frame_id_ = frames_.size();
+    ptr->ResetMemory();
+    frames_.push_back(ptr);
+    free_list_->push_back(ptr);
+  }
+  chunks_.push_back(chunk);
+  replacer_->Resize(frames_.size());
+
+  // every frame may hold a mapped page, keep the load factor at most 0.5
+  if(frames_.size() * 2 > page_table_->GetCapacity()) {
+    auto page_table =
+        new LinearProbeHashTable<page_id_t, Page *>(frames_.size());
+    for(auto ptr : frames_) {
+      Page *mapped;
+      if(ptr->page_id_ != INVALID_PAGE_ID &&
+         page_table_->Find(ptr->page_id_, mapped) && mapped == ptr) {
+        page_table->Insert(ptr->page_id_, ptr);
+      }
+    }
+    delete page_table_;
+    page_table_ = page_table;
+  }
+}
+
+/*
+ * Lowering pool_size_ makes every frame with a frame id >= new_pool_size a
+ * released one. They are taken out of free list and replacer at once, so no
+ * victim is picked among them any more, then emptied one by one with
+ * ReleaseFrame(). A frame whose page is pinned or in the middle of I/O is
+ * retried after io_cv_ is notified, MakeEvictable() does so when its last pin
+ * is gone. Chunks holding released frames only are freed at the end, a chunk
+ * straddling the new size is kept for a later growth.
+ * NOTE: lck must hold latch_, it is held again on return
+ */
+void BufferPoolManagerInstance::ShrinkPool(size_t new_pool_size,
+                                           std::unique_lock<std::mutex> &lck) {
+  resize_progress_.frames_to_release = pool_size_ - new_pool_size;
+  std::list<Page *> released(frames_.begin() + new_pool_size,
+                             frames_.begin() + pool_size_);
+  pool_size_ = new_pool_size;
+  free_list_->remove_if(
+      [this](Page *ptr) { return ptr->frame_id_ >= pool_size_; });
+  for(auto ptr : released) {
+    replacer_->Remove(ptr);
+  }
+
+  while(!released.empty()) {
+    size_t num_written = resize_progress_.pages_written;
+    for(auto it = released.begin(); it != released.end();) {
+      if(ReleaseFrame(*it, lck)) {
+        it = released.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    // a write back released latch_, frames checked before may be ready
+    if(!released.empty() && num_written == resize_progress_.pages_written) {
+      io_cv_.wait(lck);
+    }
+  }
+
+  while(!chunks_.empty() &&
+        frames_.size() - chunks_.back().size >= pool_size_) {
+    frames_.resize(frames_.size() - chunks_.back().size);
+    delete[] chunks_.back().pages;
+    FreeFrameData(chunks_.back().data, chunks_.back().size * page_size_);
+    chunks_.pop_back();
+  }
+  replacer_->Resize(frames_.size());
+}
+
+/*
+ * A resident clean page is moved to a frame from free list when there is
+ * one, so that shrinking keeps as much of the cache as possible, otherwise it
+ * is evicted. A dirty page is written back first, pinned the same way as in
+ * FlushPage(), and the frame is retried as the page may have been fetched
+ * meanwhile.
+ * NOTE: lck must hold latch_, it is held again on return
+ * @return: true if the frame holds no page any more
+ */
+bool BufferPoolManagerInstance::ReleaseFrame(
+    Page *ptr, std::unique_lock<std::mutex> &lck) {
+  page_id_t page_id = ptr->page_id_;
+  if(page_id != INVALID_PAGE_ID) {
+    if(ptr->pin_count_ > 0 || in_flight_.count(page_id) != 0) {
+      return false;
+    }
+    if(ptr->is_dirty_) {
+      ptr->pin_count_++;
+      lsn_t write_lsn = GetWriteLSN(ptr);
+      ptr->SetClean();
+      lck.unlock();
+      FlushLogTo(write_lsn);
+      disk_manager_->WritePage(page_id, ptr->data_);
+      lck.lock();
+      ptr->pin_count_--;
+      resize_progress_.pages_written++;
+      stats_.Add(WRITE_BACKS);
+      return false;
+    }
+    if(!free_list_->empty()) {
+      Page *target = free_list_->front();
+      free_list_->pop_front();
+      memcpy(target->data_, ptr->data_, page_size_);
+      target->page_id_ = page_id;
+      target->SetClean();
+      target->prefetched_ = ptr->prefetched_;
+      target->pin_count_ = 0;
+      page_table_->Insert(page_id, target);
+      replacer_->Insert(target);
+      resize_progress_.pages_relocated++;
+    } else {
+      page_table_->Remove(page_id);
+      resize_progress_.pages_evicted++;
+      stats_.Add(EVICTIONS);
+    }
+  }
+  ptr->page_id_ = INVALID_PAGE_ID;
+  ptr->SetClean();
+  resize_progress_.frames_released++;
+  return true;
+}
+
+/*
+ * The last pin of ptr is gone, make it a candidate for replacement. A frame
+ * released by Resize() is left to it instead.
+ * NOTE: caller must hold latch_
+ */
+void BufferPoolManagerInstance::MakeEvictable(Page *ptr) {
+  if(ptr->frame_id_ >= pool_size_) {
+    io_cv_.notify_all();
+    return;
+  }
+  replacer_->Insert(ptr);
+}
+
+/*
+ * Dirty page table of a fuzzy checkpoint, the caller has already logged its
+ * begin record B. Every frame that is pinned or holds a logged change is
+ * pinned, then its recLSN is read under the page read latch, which waits for
+ * a writer that took an LSN below B but has not stamped the page yet. Pages
+ * left out are clean as of B, or their write back was in flight, which is
+ * waited for. Writers are never blocked for longer than one page latch.
+ */
+std::vector<std::pair<page_id_t, lsn_t>>
+BufferPoolManagerInstance::GetDirtyPageTable() {
+  std::vector<std::pair<page_id_t, lsn_t>> dirty_pages;
+  std::vector<Page *> pages;
+  std::unique_lock<std::mutex> lck = AcquireLatch();
+  std::vector<page_id_t> writing(in_flight_.begin(), in_flight_.end());
+  for(auto ptr : frames_) {
+    if(ptr->page_id_ == INVALID_PAGE_ID ||
+       in_flight_.count(ptr->page_id_) != 0 ||
+       (ptr->pin_count_ == 0 && ptr->GetRecLSN() == INVALID_LSN)) {
+      continue;
+    }
+    if(ptr->pin_count_++ == 0) {
+      replacer_->Erase(ptr);
+    }
+    pages.push_back(ptr);
+  }
+  lck.unlock();
+
+  for(auto ptr : pages) {
+    ptr->RLatch();
+    lsn_t rec_lsn = ptr->GetRecLSN();
+    if(rec_lsn != INVALID_LSN) {
+      dirty_pages.emplace_back(ptr->GetPageId(), rec_lsn);
+    }
+    ptr->RUnlatch();
+  }
+
+  lck.lock();
+  for(auto ptr : pages) {
+    if(--ptr->pin_count_ == 0) {
+      MakeEvictable(ptr);
+    }
+  }
+  for(auto page_id : writing) {
+    WaitForIO(page_id, lck);
+  }
+  return dirty_pages;
+}
+
+/*
+ * Counters are summed over their shards, the gauges are taken under latch_
+ * and the latencies come from the disk manager
+ */
+BufferPoolStats BufferPoolManagerInstance::GetStats() {
+  BufferPoolStats stats;
+  stats.hits = stats_.Get(HITS);
+  stats.misses = stats_.Get(MISSES);
+  stats.evictions = stats_.Get(EVICTIONS);
+  stats.write_backs = stats_.Get(WRITE_BACKS);
+  stats.latch_waits = stats_.Get(LATCH_WAITS);
+  stats.latch_wait_us = stats_.Get(LATCH_WAIT_NS) / 1000;
+  stats.ring_reuses = stats_.Get(RING_REUSES);
+  {
+    std::lock_guard<std::mutex> lck(latch_);
+    stats.pool_size = pool_size_;
+    stats.free_frames = free_list_->size();
+    for(auto ptr : frames_) {
+      if(ptr->pin_count_ > 0) {
+        stats.pinned_frames++;
+      }
+      if(ptr->page_id_ != INVALID_PAGE_ID && ptr->is_dirty_) {
+        stats.dirty_frames++;
+      }
+    }
+  }
+  stats.disk_reads = disk_manager_->GetReadLatency();
+  stats.disk_writes = disk_manager_->GetWriteLatency();
+  return stats;
+}
+
+void BufferPoolManagerInstance::WaitForWarmRestore() {
+  if(restore_thread_ != nullptr) {
+    restore_thread_->join();
+    delete restore_thread_;
+    restore_thread_ = nullptr;
+  }
+}
+
+/*
+ * Unpinned pages in replacer order, from the next victim on, followed by the
+ * pinned pages, which are the hottest of all. Pages being prefetched are not
+ * resident yet and left out.
+ */
+void BufferPoolManagerInstance::CollectWarmPages(
+    std::vector<page_id_t> &page_ids) {
+  std::vector<Page *> pages;
+  std::lock_guard<std::mutex> lck(latch_);
+  replacer_->PeekVictims(pages, replacer_->Size());
+  for(auto ptr : frames_) {
+    if(ptr->page_id_ != INVALID_PAGE_ID && ptr->pin_count_ > 0) {
+      pages.push_back(ptr);
+    }
+  }
+  for(auto ptr : pages) {
+    page_ids.push_back(ptr->page_id_);
+  }
+}
+
+/*
+ * Keep the hottest pages that fit into the pool and start the restore
+ * thread. A restore still running is waited for first.
+ */
+size_t BufferPoolManagerInstance::StartWarmRestore(
+    std::vector<page_id_t> &page_ids) {
+  WaitForWarmRestore();
+  std::lock_guard<std::mutex> lck(latch_);
+  if(page_ids.size() > pool_size_) {
+    page_ids.erase(page_ids.begin(), page_ids.end() - pool_size_);
+  }
+  if(page_ids.empty()) {
+    return 0;
+  }
+  restore_running_ = true;
+  restore_thread_ =
+      new std::thread(&BufferPoolManagerInstance::WarmRestoreLoop, this,
+                      page_ids);
+  return page_ids.size();
+}
+
+/*
+ * Load the dumped pages from the cold end on, WARM_RESTORE_BATCH_SIZE pages
+ * at a time. Frames are claimed and pages mapped the same way as in
+ * PrefetchLoop(), so requests are served meanwhile and a fetch of a page
+ * being restored waits for its read. The reads of a batch are issued sorted
+ * by page id so that neighbouring pages reach the disk together, while the
+ * pages go to replacer in dump order, which rebuilds the replacer order of
+ * the dump. Only free frames are used: the restore stops once requests have
+ * taken the rest of the pool, their pages are hotter than any dumped one.
+ * Pages resident already or deallocated since the dump are skipped.
+ */
+void BufferPoolManagerInstance::WarmRestoreLoop(
+    std::vector<page_id_t> page_ids) {
+  page_id_t num_pages = disk_manager_->GetNumPages();
+  std::vector<Page *> batch;
+  std::vector<Page *> sorted;
+  std::vector<std::future<void>> reads;
+  size_t next = 0;
+  std::unique_lock<std::mutex> lck(latch_);
+  while(next < page_ids.size() && restore_running_) {
+    for(; next < page_ids.size() && batch.size() < WARM_RESTORE_BATCH_SIZE;
+        ++next) {
+      page_id_t page_id = page_ids[next];
+      Page *ptr = nullptr;
+      if(page_id < 0 || page_id >= num_pages ||
+         in_flight_.count(page_id) != 0 || page_table_->Find(page_id, ptr) ||
+         !disk_manager_->IsAllocated(page_id)) {
+        continue;
+      }
+      if(free_list_->empty()) {
+        next = page_ids.size();
+        break;
+      }
+      ptr = free_list_->front();
+      free_list_->pop_front();
+      page_table_->Insert(page_id, ptr);
+      ptr->page_id_ = page_id;
+      ptr->SetClean();
+      ptr->prefetched_ = false;
+      ptr->pin_count_ = 0;
+      in_flight_.insert(page_id);
+      batch.push_back(ptr);
+    }
+    lck.unlock();
+
+    sorted = batch;
+    std::sort(sorted.begin(), sorted.end(), [](Page *a, Page *b) {
+      return a->page_id_ < b->page_id_;
+    });
+    for(auto ptr : sorted) {
+      reads.push_back(disk_manager_->ReadPageAsync(ptr->page_id_, ptr->data_));
+    }
+    for(auto &read : reads) {
+      read.wait();
+    }
+
+    lck.lock();
+    for(auto ptr : batch) {
+      in_flight_.erase(ptr->page_id_);
+      if(ptr->pin_count_ == 0) {
+        MakeEvictable(ptr);
+      }
+    }
+    io_cv_.notify_all();
+    batch.clear();
+    reads.clear();
+  }
+}
+
+/*
+ * Lock latch_ on behalf of a caller of the public interface. Only a latch
+ * that is already held costs a clock read, the time spent waiting for it is
+ * counted.
+ */
+std::unique_lock<std::mutex> BufferPoolManagerInstance::AcquireLatch() {
+  std::unique_lock<std::mutex> lck(latch_, std::try_to_lock);
+  if(!lck.owns_lock()) {
+    auto start = std::chrono::steady_clock::now();
+    lck.lock();
+    stats_.Add(LATCH_WAITS);
+    stats_.Add(LATCH_WAIT_NS,
+               std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now() - start).count());
+  }
+  return lck;
+}
+
+/*
+ * Block until no read or write back of page_id is in progress
+ * NOTE: lck must hold latch_
+ */
+void BufferPoolManagerInstance::WaitForIO(page_id_t page_id,
+                                          std::unique_lock<std::mutex> &lck) {
+  io_cv_.wait(lck, [&] { return in_flight_.count(page_id) == 0; });
+}
+
+/*
+ * Only a page changed through Page::SetLSN() since it was last written has a
+ * real lsn in its header, the others (b+ tree, header page) are not logged.
+ * That includes the pages of recovery, which runs with logging off.
+ * NOTE: caller must hold latch_, before the page is set clean
+ */
+lsn_t BufferPoolManagerInstance::GetWriteLSN(Page *ptr) {
+  if(log_manager_ == nullptr ||
+     ptr->GetRecLSN() == INVALID_LSN) {
+    return INVALID_LSN;
+  }
+  return ptr->GetLSN();
+}
+
+/*
+ * Write-ahead rule: the log records of a page reach disk before the page.
+ * Called right before every write of the pool, see GetWriteLSN()
+ */
+void BufferPoolManagerInstance::FlushLogTo(lsn_t lsn) {
+  if(lsn != INVALID_LSN && log_manager_ != nullptr) {
+    log_manager_->WaitForFlush(lsn);
+  }
+}
+} // namespace scudb
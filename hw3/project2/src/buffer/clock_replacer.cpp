@@ -0,0 +1,125 @@
+/**
+ * CLOCK implementation
+ */
+#include <cassert>
+
+#include "buffer/clock_replacer.h"
+#include "page/page.h"
+
+namespace scudb {
+
+template <typename T>
+ClockReplacer<T>::ClockReplacer(size_t num_frames,
+                                std::function<size_t(const T &)> frame_of)
+    : num_frames_(num_frames), frame_of_(frame_of),
+      states_(new std::atomic<uint8_t>[num_frames]), values_(num_frames),
+      size_(0), hand_(0) {
+  for (size_t i = 0; i < num_frames_; ++i) {
+    states_[i].store(0);
+  }
+}
+
+template <typename T> ClockReplacer<T>::~ClockReplacer() {}
+
+/*
+ * Make value evictable and give it a second chance
+ */
+template <typename T> void ClockReplacer<T>::Insert(const T &value) {
+  size_t frame = frame_of_(value);
+  assert(frame < num_frames_);
+  values_[frame] = value;
+  uint8_t old = states_[frame].fetch_or(EVICTABLE | REFERENCED);
+  if (!(old & EVICTABLE)) {
+    size_++;
+  }
+}
+
+/* Sweep the clock hand, clearing reference bits, until an evictable frame
+ * without reference bit is found. Return false if nothing is evictable
+ */
+template <typename T> bool ClockReplacer<T>::Victim(T &value) {
+  std::lock_guard<std::mutex> lck(latch);
+  while (size_.load() > 0) {
+    size_t frame = hand_;
+    hand_ = (hand_ + 1) % num_frames_;
+    uint8_t state = states_[frame].load();
+    if (!(state & EVICTABLE)) {
+      continue;
+    }
+    if (state & REFERENCED) {
+      states_[frame].fetch_and(static_cast<uint8_t>(~REFERENCED));
+      continue;
+    }
+    // lose the race against a concurrent Insert/Erase, try next frame
+    if (states_[frame].compare_exchange_strong(state, 0)) {
+      size_--;
+      value = values_[frame];
+      return true;
+    }
+  }
+  return false;
+}
+
+/*
+ * Make value not evictable. Return false if it was not evictable
+ */
+template <typename T> bool ClockReplacer<T>::Erase(const T &value) {
+  size_t frame = frame_of_(value);
+  assert(frame < num_frames_);
+  uint8_t old = states_[frame].fetch_and(static_cast<uint8_t>(~EVICTABLE));
+  if (old & EVICTABLE) {
+    size_--;
+    return true;
+  }
+  return false;
+}
+
+template <typename T> size_t ClockReplacer<T>::Size() { return size_.load(); }
+
+/*
+ * Starting from the clock hand, frames without reference bit are chosen in
+ * the first sweep, the referenced ones in the second
+ */
+template <typename T>
+size_t ClockReplacer<T>::PeekVictims(std::vector<T> &values, size_t count) {
+  std::lock_guard<std::mutex> lck(latch);
+  size_t num = 0;
+  for (int pass = 0; pass < 2; ++pass) {
+    uint8_t wanted = pass == 0 ? EVICTABLE : (EVICTABLE | REFERENCED);
+    for (size_t i = 0; i < num_frames_ && num < count; ++i) {
+      size_t frame = (hand_ + i) % num_frames_;
+      if (states_[frame].load() == wanted) {
+        values.push_back(values_[frame]);
+        num++;
+      }
+    }
+  }
+  return num;
+}
+
+/*
+ * Reallocate the slots for num_frames frames
+ */
+template <typename T> void ClockReplacer<T>::Resize(size_t num_frames) {
+  std::lock_guard<std::mutex> lck(latch);
+  std::unique_ptr<std::atomic<uint8_t>[]> states(
+      new std::atomic<uint8_t>[num_frames]);
+  for (size_t i = 0; i < num_frames; ++i) {
+    states[i].store(i < num_frames_ ? states_[i].load() : 0);
+  }
+  for (size_t i = num_frames; i < num_frames_; ++i) {
+    assert(!(states_[i].load() & EVICTABLE));
+  }
+  states_.swap(states);
+  values_.resize(num_frames);
+  num_frames_ = num_frames;
+  if (hand_ >= num_frames_) {
+    hand_ = 0;
+  }
+}
+
+template class ClockReplacer<Page *>;
+// test only
+template class ClockReplacer<int>;
+
+} // namespace scudb
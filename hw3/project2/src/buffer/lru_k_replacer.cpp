@@ -0,0 +1,116 @@
+/**
+ * LRU-K implementation
+ */
+#include "buffer/lru_k_replacer.h"
+#include "page/page.h"
+
+namespace scudb {
+
+template <typename T>
+LRUKReplacer<T>::LRUKReplacer(size_t k, size_t correlated_period)
+    : k_(k == 0 ? 1 : k), correlated_period_(correlated_period),
+      current_timestamp_(0) {}
+
+template <typename T> LRUKReplacer<T>::~LRUKReplacer() {}
+
+/*
+ * Record a reference to value and make it evictable
+ */
+template <typename T> void LRUKReplacer<T>::Insert(const T &value) {
+  std::lock_guard<std::mutex> lck(latch);
+  size_t now = ++current_timestamp_;
+  frame_info &info = frames_[value];
+  if (info.evictable) {
+    evictable_.erase(info.key);
+  }
+  // a correlated reference does not count as a new one
+  if (info.history.empty() ||
+      now - info.history.front() > correlated_period_) {
+    info.history.push_front(now);
+    if (info.history.size() > k_) {
+      info.history.pop_back();
+    }
+  }
+  info.evictable = true;
+  info.key = MakeKey(value, info);
+  evictable_.insert(info.key);
+}
+
+/* If there is an evictable frame, pop the one with the largest backward
+ * K-distance to argument "value", and return true. Otherwise return false
+ */
+template <typename T> bool LRUKReplacer<T>::Victim(T &value) {
+  std::lock_guard<std::mutex> lck(latch);
+  if (evictable_.empty()) {
+    return false;
+  }
+  auto victim = evictable_.begin();
+  value = std::get<2>(*victim);
+  evictable_.erase(victim);
+  frames_.erase(value);
+  return true;
+}
+
+/*
+ * Make value not evictable, its reference history is kept. Return false if it
+ * was not evictable
+ */
+template <typename T> bool LRUKReplacer<T>::Erase(const T &value) {
+  std::lock_guard<std::mutex> lck(latch);
+  auto it = frames_.find(value);
+  if (it == frames_.end() || !it->second.evictable) {
+    return false;
+  }
+  evictable_.erase(it->second.key);
+  it->second.evictable = false;
+  return true;
+}
+
+/*
+ * Forget value, evictable or not, together with its reference history
+ */
+template <typename T> void LRUKReplacer<T>::Remove(const T &value) {
+  std::lock_guard<std::mutex> lck(latch);
+  auto it = frames_.find(value);
+  if (it == frames_.end()) {
+    return;
+  }
+  if (it->second.evictable) {
+    evictable_.erase(it->second.key);
+  }
+  frames_.erase(it);
+}
+
+template <typename T> size_t LRUKReplacer<T>::Size() {
+  std::lock_guard<std::mutex> lck(latch);
+  return evictable_.size();
+}
+
+template <typename T>
+size_t LRUKReplacer<T>::PeekVictims(std::vector<T> &values, size_t count) {
+  std::lock_guard<std::mutex> lck(latch);
+  size_t num = 0;
+  for (auto it = evictable_.begin(); it != evictable_.end() && num < count;
+       ++it) {
+    values.push_back(std::get<2>(*it));
+    num++;
+  }
+  return num;
+}
+
+/*
+ * Order frames with less than K references before the others, then by their
+ * oldest kept reference, which is the K-th most recent one once K references
+ * are recorded
+ */
+template <typename T>
+typename LRUKReplacer<T>::key_t
+LRUKReplacer<T>::MakeKey(const T &value, const frame_info &info) const {
+  return key_t(info.history.size() >= k_, info.history.back(), value);
+}
+
+template class LRUKReplacer<Page *>;
+// test only
+template class LRUKReplacer<int>;
+
+} // namespace scudb
@@ -78,6 +78,20 @@ template <typename T> size_t LRUReplacer<T>::Size() {
   return hashmap.size(); 
 }
 
+/*
+ * Walk from the least recently used end
+ */
+template <typename T>
+size_t LRUReplacer<T>::PeekVictims(std::vector<T> &values, size_t count) {
+  std::lock_guard<std::mutex> lck(latch);
+  size_t num = 0;
+  for (auto cur = tail->pre; cur != head && num < count; cur = cur->pre) {
+    values.push_back(cur->value);
+    num++;
+  }
+  return num;
+}
+
 template class LRUReplacer<Page *>;
 // test only
 template class LRUReplacer<int>;
@@ -0,0 +1,79 @@
+/**
+ * page_guard.cpp
+ */
+
+#include <utility>
+
+#include "buffer/page_guard.h"
+#include "buffer/buffer_pool_manager.h"
+
+namespace scudb {
+
+BasicPageGuard::BasicPageGuard(BufferPoolManager *buffer_pool_manager,
+                               Page *page)
+    : buffer_pool_manager_(buffer_pool_manager), page_(page) {}
+
+BasicPageGuard::BasicPageGuard(BasicPageGuard &&that) noexcept
+    : buffer_pool_manager_(that.buffer_pool_manager_), page_(that.page_),
+      is_dirty_(that.is_dirty_) {
+  that.page_ = nullptr;
+}
+
+BasicPageGuard &BasicPageGuard::operator=(BasicPageGuard &&that) noexcept {
+  if (this != &that) {
+    Drop();
+    buffer_pool_manager_ = that.buffer_pool_manager_;
+    page_ = that.page_;
+    is_dirty_ = that.is_dirty_;
+    that.page_ = nullptr;
+  }
+  return *this;
+}
+
+void BasicPageGuard::Drop() {
+  if (page_ != nullptr) {
+    buffer_pool_manager_->UnpinFrame(page_, is_dirty_);
+    page_ = nullptr;
+    is_dirty_ = false;
+  }
+}
+
+ReadPageGuard::ReadPageGuard(BufferPoolManager *buffer_pool_manager,
+                             Page *page)
+    : guard_(buffer_pool_manager, page) {}
+
+ReadPageGuard &ReadPageGuard::operator=(ReadPageGuard &&that) noexcept {
+  if (this != &that) {
+    Drop();
+    guard_ = std::move(that.guard_);
+  }
+  return *this;
+}
+
+void ReadPageGuard::Drop() {
+  if (guard_) {
+    guard_.GetPage()->RUnlatch();
+    guard_.Drop();
+  }
+}
+
+WritePageGuard::WritePageGuard(BufferPoolManager *buffer_pool_manager,
+                               Page *page)
+    : guard_(buffer_pool_manager, page) {}
+
+WritePageGuard &WritePageGuard::operator=(WritePageGuard &&that) noexcept {
+  if (this != &that) {
+    Drop();
+    guard_ = std::move(that.guard_);
+  }
+  return *this;
+}
+
+void WritePageGuard::Drop() {
+  if (guard_) {
+    guard_.GetPage()->WUnlatch();
+    guard_.Drop();
+  }
+}
+
+} // namespace scudb
@@ -0,0 +1,227 @@
+#include <cassert>
+
+#include "buffer/parallel_buffer_pool_manager.h"
+
+namespace scudb {
+
+/*
+ * ParallelBufferPoolManager Constructor
+ * All the frames live in the instances. The remainder of
+ * pool_size / num_instances is spread over the first instances.
+ */
+ParallelBufferPoolManager::ParallelBufferPoolManager(size_t num_instances,
+                                                     size_t pool_size,
+                                                     DiskManager *disk_manager,
+                                                     LogManager *log_manager,
+                                                     ReplacerType replacer_type)
+    : BufferPoolManager(disk_manager->GetPageSize()),
+      disk_manager_(disk_manager) {
+  assert(num_instances > 0);
+  for (size_t i = 0; i < num_instances; ++i) {
+    size_t instance_size =
+        pool_size / num_instances + (i < pool_size % num_instances ? 1 : 0);
+    instances_.push_back(
+        new BufferPoolManagerInstance(instance_size, disk_manager,
+                                      log_manager, replacer_type));
+  }
+}
+
+ParallelBufferPoolManager::~ParallelBufferPoolManager() {
+  // the last dump needs the instances
+  StopWarmStateThread();
+  for (auto instance : instances_) {
+    delete instance;
+  }
+}
+
+Page *ParallelBufferPoolManager::FetchPage(page_id_t page_id,
+                                           BufferAccessStrategy *strategy) {
+  return GetInstance(page_id)->FetchPage(page_id, strategy);
+}
+
+bool ParallelBufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty) {
+  return GetInstance(page_id)->UnpinPage(page_id, is_dirty);
+}
+
+bool ParallelBufferPoolManager::UnpinFrame(Page *page, bool is_dirty) {
+  return GetInstance(page->GetPageId())->UnpinFrame(page, is_dirty);
+}
+
+size_t ParallelBufferPoolManager::CheckPinLeaks() {
+  size_t num_pinned = 0;
+  for (auto instance : instances_) {
+    num_pinned += instance->CheckPinLeaks();
+  }
+  return num_pinned;
+}
+
+bool ParallelBufferPoolManager::FlushPage(page_id_t page_id) {
+  if (page_id == INVALID_PAGE_ID) {
+    return false;
+  }
+  return GetInstance(page_id)->FlushPage(page_id);
+}
+
+void ParallelBufferPoolManager::FlushAllPages() {
+  for (auto instance : instances_) {
+    instance->FlushAllPages();
+  }
+}
+
+bool ParallelBufferPoolManager::DeletePage(page_id_t page_id) {
+  return GetInstance(page_id)->DeletePage(page_id);
+}
+
+void ParallelBufferPoolManager::RunCleanerThread(size_t low_watermark,
+                                                 size_t high_watermark,
+                                                 size_t max_pages_per_sec) {
+  size_t n = instances_.size();
+  size_t rate = max_pages_per_sec == 0 ? 0 : (max_pages_per_sec + n - 1) / n;
+  for (auto instance : instances_) {
+    instance->RunCleanerThread((low_watermark + n - 1) / n,
+                               (high_watermark + n - 1) / n, rate);
+  }
+}
+
+void ParallelBufferPoolManager::StopCleanerThread() {
+  for (auto instance : instances_) {
+    instance->StopCleanerThread();
+  }
+}
+
+size_t ParallelBufferPoolManager::PrefetchPages(page_id_t first_page_id,
+                                                size_t count) {
+  if (first_page_id == INVALID_PAGE_ID) {
+    return 0;
+  }
+  size_t queued = 0;
+  while (queued < count) {
+    page_id_t page_id = first_page_id + queued;
+    if (GetInstance(page_id)->PrefetchPages(page_id, 1) == 0) {
+      break;
+    }
+    queued++;
+  }
+  return queued;
+}
+
+/*
+ * Instances are resized one after another, new_pool_size is split the same
+ * way as in the constructor
+ */
+void ParallelBufferPoolManager::Resize(size_t new_pool_size) {
+  size_t n = instances_.size();
+  for (size_t i = 0; i < n; ++i) {
+    instances_[i]->Resize(new_pool_size / n +
+                          (i < new_pool_size % n ? 1 : 0));
+  }
+}
+
+/*
+ * Sum of the progress of every instance
+ */
+ResizeProgress ParallelBufferPoolManager::GetResizeProgress() {
+  ResizeProgress progress;
+  for (auto instance : instances_) {
+    ResizeProgress part = instance->GetResizeProgress();
+    progress.in_progress = progress.in_progress || part.in_progress;
+    progress.target_pool_size += part.target_pool_size;
+    progress.frames_to_release += part.frames_to_release;
+    progress.frames_released += part.frames_released;
+    progress.pages_relocated += part.pages_relocated;
+    progress.pages_evicted += part.pages_evicted;
+    progress.pages_written += part.pages_written;
+  }
+  return progress;
+}
+
+size_t ParallelBufferPoolManager::GetPoolSize() {
+  size_t pool_size = 0;
+  for (auto instance : instances_) {
+    pool_size += instance->GetPoolSize();
+  }
+  return pool_size;
+}
+
+BufferPoolStats ParallelBufferPoolManager::GetStats() {
+  BufferPoolStats stats;
+  for (auto instance : instances_) {
+    BufferPoolStats part = instance->GetStats();
+    stats.hits += part.hits;
+    stats.misses += part.misses;
+    stats.evictions += part.evictions;
+    stats.write_backs += part.write_backs;
+    stats.latch_waits += part.latch_waits;
+    stats.latch_wait_us += part.latch_wait_us;
+    stats.ring_reuses += part.ring_reuses;
+    stats.pool_size += part.pool_size;
+    stats.free_frames += part.free_frames;
+    stats.pinned_frames += part.pinned_frames;
+    stats.dirty_frames += part.dirty_frames;
+  }
+  stats.disk_reads = disk_manager_->GetReadLatency();
+  stats.disk_writes = disk_manager_->GetWriteLatency();
+  return stats;
+}
+
+std::vector<std::pair<page_id_t, lsn_t>>
+ParallelBufferPoolManager::GetDirtyPageTable() {
+  std::vector<std::pair<page_id_t, lsn_t>> dirty_pages;
+  for (auto instance : instances_) {
+    auto part = instance->GetDirtyPageTable();
+    dirty_pages.insert(dirty_pages.end(), part.begin(), part.end());
+  }
+  return dirty_pages;
+}
+
+void ParallelBufferPoolManager::WaitForWarmRestore() {
+  for (auto instance : instances_) {
+    instance->WaitForWarmRestore();
+  }
+}
+
+void ParallelBufferPoolManager::CollectWarmPages(
+    std::vector<page_id_t> &page_ids) {
+  for (auto instance : instances_) {
+    instance->CollectWarmPages(page_ids);
+  }
+}
+
+/*
+ * A dump taken with a different number of instances works as well, pages
+ * keep their relative order within the instance they belong to now
+ */
+size_t ParallelBufferPoolManager::StartWarmRestore(
+    std::vector<page_id_t> &page_ids) {
+  std::vector<std::vector<page_id_t>> parts(instances_.size());
+  for (auto page_id : page_ids) {
+    if (page_id >= 0) {
+      parts[static_cast<size_t>(page_id) % instances_.size()].push_back(
+          page_id);
+    }
+  }
+  size_t restored = 0;
+  for (size_t i = 0; i < instances_.size(); ++i) {
+    restored += instances_[i]->StartWarmRestore(parts[i]);
+  }
+  return restored;
+}
+
+/*
+ * The page id decides which instance owns the new page, so it is allocated
+ * first. If that instance has every frame pinned the page id is given back to
+ * the disk manager and nullptr is returned, same as a single instance would.
+ */
+Page *ParallelBufferPoolManager::NewPage(page_id_t &page_id,
+                                         BufferAccessStrategy *strategy) {
+  page_id_t new_page_id = disk_manager_->AllocatePage();
+  Page *page = GetInstance(new_page_id)->NewPageWithId(new_page_id, strategy);
+  if (page == nullptr) {
+    disk_manager_->DeallocatePage(new_page_id);
+    return nullptr;
+  }
+  page_id = new_page_id;
+  return page;
+}
+
+} // namespace scudb
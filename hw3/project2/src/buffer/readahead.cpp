@@ -0,0 +1,39 @@
+/**
+ * readahead.cpp
+ */
+
+#include <algorithm>
+
+#include "buffer/readahead.h"
+
+namespace scudb {
+
+Readahead::Readahead(BufferPoolManager *buffer_pool_manager)
+    : buffer_pool_manager_(buffer_pool_manager), window_(0),
+      prefetched_until_(INVALID_PAGE_ID) {}
+
+void Readahead::Advance(page_id_t prev_page_id, page_id_t page_id) {
+  if (prev_page_id == INVALID_PAGE_ID || page_id != prev_page_id + 1) {
+    window_ = 0;
+    prefetched_until_ = INVALID_PAGE_ID;
+    return;
+  }
+  if (window_ == 0) {
+    window_ = READAHEAD_MIN_PAGES;
+  } else if (prefetched_until_ - page_id >
+             static_cast<page_id_t>(window_ / 2)) {
+    // enough is on its way
+    return;
+  } else {
+    window_ = std::min<size_t>(window_ * 2, READAHEAD_MAX_PAGES);
+  }
+  // page_id itself is read by the scan
+  prefetched_until_ = std::max(prefetched_until_, page_id + 1);
+  page_id_t end = page_id + 1 + window_;
+  if (end > prefetched_until_) {
+    prefetched_until_ += buffer_pool_manager_->PrefetchPages(
+        prefetched_until_, end - prefetched_until_);
+  }
+}
+
+} // namespace scudb
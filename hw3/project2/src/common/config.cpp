@@ -4,4 +4,12 @@ namespace scudb {
   std::atomic<bool> ENABLE_LOGGING(false);  // for virtual table
   std::chrono::duration<long long int> LOG_TIMEOUT =
    std::chrono::seconds(1);
+  std::chrono::milliseconds CLEANER_TIMEOUT =
+   std::chrono::milliseconds(10);
+  std::chrono::milliseconds SYNC_INTERVAL =
+   std::chrono::milliseconds(1000);
+  std::chrono::milliseconds WARM_STATE_INTERVAL =
+   std::chrono::milliseconds(60000);
+  std::chrono::milliseconds ASYNC_COMMIT_LAG =
+   std::chrono::milliseconds(10);
 }
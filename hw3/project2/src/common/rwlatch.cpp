@@ -0,0 +1,148 @@
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "common/rwlatch.h"
+
+namespace scudb {
+
+namespace {
+// rounds of spinning before a waiter parks
+const int SPIN_ROUNDS = 64;
+const size_t PARKING_BUCKETS = 64;
+
+// parked threads of all latches share these, by latch address
+struct ParkingBucket {
+  std::mutex mutex;
+  std::condition_variable cond;
+};
+
+ParkingBucket &GetParkingBucket(const void *latch) {
+  static ParkingBucket buckets[PARKING_BUCKETS];
+  return buckets[std::hash<const void *>{}(latch) % PARKING_BUCKETS];
+}
+} // namespace
+
+/*
+ * The PARKED bit is only set under the bucket mutex, and Unpark() clears it
+ * under the same mutex, so a waiter cannot miss the wake up of a state
+ * change it has not seen yet
+ */
+template <typename Blocked> void RWLatch::Wait(Blocked blocked) {
+  for (int i = 0; i < SPIN_ROUNDS; ++i) {
+    if (!blocked(state_.load(std::memory_order_relaxed))) {
+      return;
+    }
+    std::this_thread::yield();
+  }
+
+  ParkingBucket &bucket = GetParkingBucket(this);
+  std::unique_lock<std::mutex> lck(bucket.mutex);
+  uint64_t state = state_.load(std::memory_order_relaxed);
+  while (blocked(state)) {
+    if (state & PARKED ||
+        state_.compare_exchange_weak(state, state | PARKED,
+                                     std::memory_order_relaxed)) {
+      bucket.cond.wait(lck);
+      return;
+    }
+  }
+}
+
+void RWLatch::Unpark() {
+  ParkingBucket &bucket = GetParkingBucket(this);
+  {
+    std::lock_guard<std::mutex> lck(bucket.mutex);
+    state_.fetch_and(~PARKED, std::memory_order_relaxed);
+  }
+  bucket.cond.notify_all();
+}
+
+/*
+ * A waiting writer keeps WRITER_WAITING set, which holds new readers back.
+ * Several writers may wait, the one getting in clears the bit and the
+ * others set it again.
+ */
+void RWLatch::WLockSlow() {
+  while (true) {
+    uint64_t state = state_.load(std::memory_order_relaxed);
+    if ((state & (WRITER | UPGRADING | READERS)) == 0) {
+      if (state_.compare_exchange_weak(state,
+                                       (state & ~WRITER_WAITING) | WRITER,
+                                       std::memory_order_acquire)) {
+        return;
+      }
+      continue;
+    }
+    if (!(state & WRITER_WAITING) &&
+        !state_.compare_exchange_weak(state, state | WRITER_WAITING,
+                                      std::memory_order_relaxed)) {
+      continue;
+    }
+    Wait([](uint64_t state) {
+      return (state & (WRITER | UPGRADING | READERS)) != 0;
+    });
+  }
+}
+
+void RWLatch::RLockSlow() {
+  while (!TryRLock()) {
+    Wait([](uint64_t state) {
+      return (state & (WRITER | WRITER_WAITING | UPGRADING)) != 0;
+    });
+  }
+}
+
+bool RWLatch::TryUpgrade() {
+  uint64_t state = state_.load(std::memory_order_relaxed);
+  while ((state & (UPGRADING | READERS)) == READER) {
+    if (state_.compare_exchange_weak(state,
+                                     ((state - READER) & ~WRITER_WAITING) |
+                                         WRITER,
+                                     std::memory_order_acquire)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/*
+ * UPGRADING keeps new readers and writers out while the other readers leave
+ */
+bool RWLatch::Upgrade() {
+  uint64_t state = state_.load(std::memory_order_relaxed);
+  do {
+    if (state & UPGRADING) {
+      return false;
+    }
+  } while (!state_.compare_exchange_weak(state, state | UPGRADING,
+                                         std::memory_order_relaxed));
+
+  while (true) {
+    state = state_.load(std::memory_order_relaxed);
+    if ((state & READERS) == READER) {
+      if (state_.compare_exchange_weak(
+              state,
+              ((state - READER) & ~(UPGRADING | WRITER_WAITING)) | WRITER,
+              std::memory_order_acquire)) {
+        return true;
+      }
+      continue;
+    }
+    Wait([](uint64_t state) { return (state & READERS) != READER; });
+  }
+}
+
+/*
+ * Readers and writers waiting behind the writer are woken, the readers get
+ * in along with this one unless a writer waits
+ */
+void RWLatch::Downgrade() {
+  uint64_t state = state_.fetch_add(READER - WRITER, std::memory_order_release);
+  if (state & PARKED) {
+    Unpark();
+  }
+}
+
+} // namespace scudb
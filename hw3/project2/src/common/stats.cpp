@@ -0,0 +1,52 @@
+#include <sstream>
+
+#include "common/stats.h"
+
+namespace scudb {
+
+uint64_t LatencyHistogram::Percentile(double p) const {
+  uint64_t target = static_cast<uint64_t>(p * count + 0.5);
+  uint64_t seen = 0;
+  for (size_t i = 0; i < NUM_BUCKETS; ++i) {
+    seen += buckets[i];
+    if (seen >= target && seen > 0) {
+      return uint64_t(1) << i;
+    }
+  }
+  return 0;
+}
+
+std::string LatencyHistogram::ToString() const {
+  std::ostringstream os;
+  os << "count " << count << " avg " << (count == 0 ? 0 : total_us / count)
+     << "us p50 " << Percentile(0.5) << "us p99 " << Percentile(0.99)
+     << "us p999 " << Percentile(0.999) << "us";
+  return os.str();
+}
+
+/*
+ * Bucket of a latency is the number of significant bits of it in us
+ */
+void LatencyRecorder::Record(std::chrono::steady_clock::duration latency) {
+  uint64_t us =
+      std::chrono::duration_cast<std::chrono::microseconds>(latency).count();
+  size_t bucket = 0;
+  while (bucket + 1 < LatencyHistogram::NUM_BUCKETS && (us >> bucket) != 0) {
+    bucket++;
+  }
+  counters_.Add(bucket);
+  counters_.Add(LatencyHistogram::NUM_BUCKETS);
+  counters_.Add(LatencyHistogram::NUM_BUCKETS + 1, us);
+}
+
+LatencyHistogram LatencyRecorder::GetHistogram() const {
+  LatencyHistogram histogram;
+  for (size_t i = 0; i < LatencyHistogram::NUM_BUCKETS; ++i) {
+    histogram.buckets[i] = counters_.Get(i);
+  }
+  histogram.count = counters_.Get(LatencyHistogram::NUM_BUCKETS);
+  histogram.total_us = counters_.Get(LatencyHistogram::NUM_BUCKETS + 1);
+  return histogram;
+}
+
+} // namespace scudb
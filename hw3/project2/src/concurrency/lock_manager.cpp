@@ -7,18 +7,138 @@
 namespace scudb {
 
 bool LockManager::LockShared(Transaction *txn, const RID &rid) {
-  return false;
+  return Lock(txn, rid, false);
 }
 
 bool LockManager::LockExclusive(Transaction *txn, const RID &rid) {
-  return false;
+  return Lock(txn, rid, true);
 }
 
+/*
+ * The shared request is dropped and an exclusive one queued right after the
+ * granted requests, so that it is the next to be granted. Only one upgrade
+ * may wait on a rid, a second one would deadlock with it
+ */
 bool LockManager::LockUpgrade(Transaction *txn, const RID &rid) {
-  return false;
+  std::unique_lock<std::mutex> lck(latch_);
+  if (txn->GetState() != TransactionState::GROWING) {
+    return Die(txn);
+  }
+  RequestQueue &queue = lock_table_[rid];
+  if (queue.upgrading) {
+    return Die(txn);
+  }
+  auto it = queue.requests.begin();
+  while (it != queue.requests.end() && it->txn_id != txn->GetTransactionId()) {
+    ++it;
+  }
+  if (it == queue.requests.end() || it->exclusive) {
+    return Die(txn);
+  }
+  queue.requests.erase(it);
+  txn->GetSharedLockSet()->erase(rid);
+  queue.cv.notify_all();
+  for (auto &request : queue.requests) {
+    if (request.txn_id < txn->GetTransactionId()) {
+      return Die(txn);
+    }
+  }
+
+  it = queue.requests.begin();
+  while (it != queue.requests.end() && IsGrantable(queue, it->txn_id)) {
+    ++it;
+  }
+  queue.requests.insert(it, {txn->GetTransactionId(), true});
+  queue.upgrading = true;
+  queue.cv.wait(lck, [&] {
+    return IsGrantable(queue, txn->GetTransactionId());
+  });
+  queue.upgrading = false;
+  txn->GetExclusiveLockSet()->emplace(rid);
+  return true;
 }
 
+/*
+ * With strict 2PL locks are only released once the transaction is done,
+ * otherwise the first release ends its growing phase
+ */
 bool LockManager::Unlock(Transaction *txn, const RID &rid) {
+  std::lock_guard<std::mutex> lck(latch_);
+  if (strict_2PL_) {
+    if (txn->GetState() != TransactionState::COMMITTED &&
+        txn->GetState() != TransactionState::ABORTED) {
+      txn->SetState(TransactionState::ABORTED);
+      return false;
+    }
+  } else if (txn->GetState() == TransactionState::GROWING) {
+    txn->SetState(TransactionState::SHRINKING);
+  }
+  auto entry = lock_table_.find(rid);
+  if (entry == lock_table_.end()) {
+    return false;
+  }
+  RequestQueue &queue = entry->second;
+  auto it = queue.requests.begin();
+  while (it != queue.requests.end() && it->txn_id != txn->GetTransactionId()) {
+    ++it;
+  }
+  if (it == queue.requests.end()) {
+    return false;
+  }
+  queue.requests.erase(it);
+  txn->GetSharedLockSet()->erase(rid);
+  txn->GetExclusiveLockSet()->erase(rid);
+  if (queue.requests.empty()) {
+    lock_table_.erase(entry);
+  } else {
+    queue.cv.notify_all();
+  }
+  return true;
+}
+
+/*
+ * Wait-die: a transaction only waits for younger ones, those with a larger
+ * id, so no cycle of waiting transactions can form
+ */
+bool LockManager::Lock(Transaction *txn, const RID &rid, bool exclusive) {
+  std::unique_lock<std::mutex> lck(latch_);
+  if (txn->GetState() != TransactionState::GROWING) {
+    return Die(txn);
+  }
+  RequestQueue &queue = lock_table_[rid];
+  for (auto &request : queue.requests) {
+    if ((exclusive || request.exclusive) &&
+        request.txn_id < txn->GetTransactionId()) {
+      return Die(txn);
+    }
+  }
+
+  queue.requests.push_back({txn->GetTransactionId(), exclusive});
+  queue.cv.wait(lck, [&] {
+    return IsGrantable(queue, txn->GetTransactionId());
+  });
+  if (exclusive) {
+    txn->GetExclusiveLockSet()->emplace(rid);
+  } else {
+    txn->GetSharedLockSet()->emplace(rid);
+  }
+  return true;
+}
+
+bool LockManager::IsGrantable(RequestQueue &queue, txn_id_t txn_id) {
+  bool exclusive_ahead = false;
+  for (auto &request : queue.requests) {
+    if (request.txn_id == txn_id) {
+      return request.exclusive ? &request == &queue.requests.front()
+                               : !exclusive_ahead;
+    }
+    exclusive_ahead = exclusive_ahead || request.exclusive;
+  }
+  return false;
+}
+
+bool LockManager::Die(Transaction *txn) {
+  txn->SetState(TransactionState::ABORTED);
   return false;
 }
 
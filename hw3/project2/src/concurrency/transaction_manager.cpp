@@ -10,14 +10,52 @@ namespace scudb {
 
 Transaction *TransactionManager::Begin() {
   Transaction *txn = new Transaction(next_txn_id_++);
+  txn->SetAsyncCommit(async_commit_);
 
   if (ENABLE_LOGGING) {
-    // TODO: write log and update transaction's prev_lsn here
+    // under latch_, a checkpoint sees every transaction begun before it
+    std::lock_guard<std::mutex> lck(latch_);
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(),
+                         LogRecordType::BEGIN);
+    txn->SetPrevLSN(log_manager_->AppendLogRecord(log_record));
+    active_txns_[txn->GetTransactionId()] = {txn, txn->GetPrevLSN()};
   }
 
   return txn;
 }
 
+void TransactionManager::AppendEndRecord(Transaction *txn,
+                                         LogRecordType log_record_type) {
+  std::lock_guard<std::mutex> lck(latch_);
+  LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(),
+                       log_record_type);
+  txn->SetPrevLSN(log_manager_->AppendLogRecord(log_record));
+  active_txns_.erase(txn->GetTransactionId());
+}
+
+/*
+ * The table is read together with logging the begin record, so that the
+ * transactions it lists are exactly those begun and not ended before it
+ */
+lsn_t TransactionManager::BeginCheckpoint(
+    std::vector<std::pair<txn_id_t, lsn_t>> &active_txns,
+    lsn_t &oldest_begin_lsn) {
+  std::lock_guard<std::mutex> lck(latch_);
+  LogRecord log_record(INVALID_TXN_ID, INVALID_LSN,
+                       LogRecordType::BEGIN_CHECKPOINT);
+  lsn_t begin_lsn = log_manager_->AppendLogRecord(log_record);
+  active_txns.clear();
+  oldest_begin_lsn = INVALID_LSN;
+  for (auto &entry : active_txns_) {
+    active_txns.emplace_back(entry.first, entry.second.first->GetPrevLSN());
+    if (oldest_begin_lsn == INVALID_LSN ||
+        entry.second.second < oldest_begin_lsn) {
+      oldest_begin_lsn = entry.second.second;
+    }
+  }
+  return begin_lsn;
+}
+
 void TransactionManager::Commit(Transaction *txn) {
   txn->SetState(TransactionState::COMMITTED);
   // truly delete before commit
@@ -34,7 +72,15 @@ void TransactionManager::Commit(Transaction *txn) {
   write_set->clear();
 
   if (ENABLE_LOGGING) {
-    // TODO: write log and update transaction's prev_lsn here
+    // the commit is durable once its record is, committers waiting at the
+    // same time share one log write. an async commit only bounds how long
+    // its record stays in the buffer
+    AppendEndRecord(txn, LogRecordType::COMMIT);
+    if (txn->IsAsyncCommit()) {
+      log_manager_->ScheduleFlush();
+    } else {
+      log_manager_->WaitForFlush(txn->GetPrevLSN());
+    }
   }
 
   // release all the lock
@@ -71,7 +117,7 @@ void TransactionManager::Abort(Transaction *txn) {
   write_set->clear();
 
   if (ENABLE_LOGGING) {
-    // TODO: write log and update transaction's prev_lsn here
+    AppendEndRecord(txn, LogRecordType::ABORT);
   }
 
   // release all the lock
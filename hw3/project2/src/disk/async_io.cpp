@@ -0,0 +1,291 @@
+/**
+ * async_io.cpp
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+
+#include "common/logger.h"
+#include "disk/async_io.h"
+
+#ifdef SCUDB_HAVE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+namespace scudb {
+
+AsyncIO *AsyncIO::Create(AsyncIOType type, size_t queue_depth) {
+#ifdef SCUDB_HAVE_IO_URING
+  if (type == AsyncIOType::IO_URING) {
+    AsyncIO *io = IOUringIO::Create(queue_depth);
+    if (io != nullptr) {
+      return io;
+    }
+    LOG_DEBUG("io_uring not available, fall back to thread pool");
+  }
+#endif
+  return new ThreadPoolIO(std::max<size_t>(
+      1, std::min<size_t>(queue_depth, std::thread::hardware_concurrency())));
+}
+
+/*****************************************************************************
+ * ThreadPoolIO
+ *****************************************************************************/
+ThreadPoolIO::ThreadPoolIO(size_t num_threads) : running_(true) {
+  for (size_t i = 0; i < num_threads; ++i) {
+    workers_.push_back(std::thread(&ThreadPoolIO::WorkerLoop, this));
+  }
+}
+
+ThreadPoolIO::~ThreadPoolIO() {
+  {
+    std::lock_guard<std::mutex> lck(latch_);
+    running_ = false;
+    cv_.notify_all();
+  }
+  for (auto &worker : workers_) {
+    worker.join();
+  }
+}
+
+void ThreadPoolIO::Read(int fd, char *buf, size_t len, off_t offset,
+                        Callback done) {
+  std::lock_guard<std::mutex> lck(latch_);
+  queue_.push_back([=] {
+    ssize_t rc;
+    do {
+      rc = pread(fd, buf, len, offset);
+    } while (rc < 0 && errno == EINTR);
+    done(rc < 0 ? -errno : rc);
+  });
+  cv_.notify_one();
+}
+
+void ThreadPoolIO::Write(int fd, const char *buf, size_t len, off_t offset,
+                         Callback done) {
+  std::lock_guard<std::mutex> lck(latch_);
+  queue_.push_back([=] {
+    ssize_t rc;
+    do {
+      rc = pwrite(fd, buf, len, offset);
+    } while (rc < 0 && errno == EINTR);
+    done(rc < 0 ? -errno : rc);
+  });
+  cv_.notify_one();
+}
+
+/*
+ * Workers drain the queue before they exit, so that no callback is lost
+ */
+void ThreadPoolIO::WorkerLoop() {
+  std::unique_lock<std::mutex> lck(latch_);
+  while (true) {
+    cv_.wait(lck, [this] { return !running_ || !queue_.empty(); });
+    if (queue_.empty()) {
+      return;
+    }
+    std::function<void()> task = std::move(queue_.front());
+    queue_.pop_front();
+    lck.unlock();
+    task();
+    lck.lock();
+  }
+}
+
+#ifdef SCUDB_HAVE_IO_URING
+/*****************************************************************************
+ * IOUringIO
+ * The ring is driven with raw syscalls, no liburing needed. The layout of
+ * the shared rings follows io_uring_setup(2).
+ *****************************************************************************/
+IOUringIO::IOUringIO()
+    : ring_fd_(-1), sq_ptr_(MAP_FAILED), sq_size_(0), cq_ptr_(MAP_FAILED),
+      cq_size_(0), sqes_ptr_(MAP_FAILED), sqes_size_(0), sq_entries_(0),
+      in_flight_(0), running_(true), reaper_thread_(nullptr) {}
+
+IOUringIO *IOUringIO::Create(size_t queue_depth) {
+  IOUringIO *io = new IOUringIO;
+  if (!io->Setup(queue_depth)) {
+    delete io;
+    return nullptr;
+  }
+  io->reaper_thread_ = new std::thread(&IOUringIO::ReaperLoop, io);
+  return io;
+}
+
+bool IOUringIO::Setup(size_t queue_depth) {
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  ring_fd_ = syscall(__NR_io_uring_setup, queue_depth, &params);
+  if (ring_fd_ < 0) {
+    return false;
+  }
+  sq_entries_ = params.sq_entries;
+  sq_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cq_size_ =
+      params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  bool single_mmap = false;
+#ifdef IORING_FEAT_SINGLE_MMAP
+  single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+#endif
+  if (single_mmap) {
+    sq_size_ = cq_size_ = std::max(sq_size_, cq_size_);
+  }
+  sq_ptr_ = mmap(nullptr, sq_size_, PROT_READ | PROT_WRITE,
+                 MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+  if (sq_ptr_ == MAP_FAILED) {
+    return false;
+  }
+  if (single_mmap) {
+    cq_ptr_ = sq_ptr_;
+  } else {
+    cq_ptr_ = mmap(nullptr, cq_size_, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_CQ_RING);
+    if (cq_ptr_ == MAP_FAILED) {
+      return false;
+    }
+  }
+  sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+  sqes_ptr_ = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+  if (sqes_ptr_ == MAP_FAILED) {
+    return false;
+  }
+
+  char *sq = static_cast<char *>(sq_ptr_);
+  sq_head_ = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+  sq_tail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+  sq_mask_ = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+  sq_array_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+  char *cq = static_cast<char *>(cq_ptr_);
+  cq_head_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+  cq_tail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+  cq_mask_ = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+  cqes_ = cq + params.cq_off.cqes;
+  return true;
+}
+
+/*
+ * Wait for every request, then wake the reaper with a nop so that it exits
+ */
+IOUringIO::~IOUringIO() {
+  if (reaper_thread_ != nullptr) {
+    {
+      std::unique_lock<std::mutex> lck(latch_);
+      cv_.wait(lck, [this] { return in_flight_ == 0; });
+      running_ = false;
+    }
+    Submit(IORING_OP_NOP, -1, nullptr, 0);
+    reaper_thread_->join();
+    delete reaper_thread_;
+  }
+  if (sqes_ptr_ != MAP_FAILED) {
+    munmap(sqes_ptr_, sqes_size_);
+  }
+  if (cq_ptr_ != MAP_FAILED && cq_ptr_ != sq_ptr_) {
+    munmap(cq_ptr_, cq_size_);
+  }
+  if (sq_ptr_ != MAP_FAILED) {
+    munmap(sq_ptr_, sq_size_);
+  }
+  if (ring_fd_ >= 0) {
+    close(ring_fd_);
+  }
+}
+
+void IOUringIO::Read(int fd, char *buf, size_t len, off_t offset,
+                     Callback done) {
+  Request *request = new Request;
+  request->iov.iov_base = buf;
+  request->iov.iov_len = len;
+  request->done = std::move(done);
+  Submit(IORING_OP_READV, fd, request, offset);
+}
+
+void IOUringIO::Write(int fd, const char *buf, size_t len, off_t offset,
+                      Callback done) {
+  Request *request = new Request;
+  request->iov.iov_base = const_cast<char *>(buf);
+  request->iov.iov_len = len;
+  request->done = std::move(done);
+  Submit(IORING_OP_WRITEV, fd, request, offset);
+}
+
+/*
+ * The sqe is published under latch_, io_uring_enter() is called without it
+ * and asks the kernel for every sqe it has not consumed yet. When several
+ * threads submit at the same time, the first enter picks up the sqes of all
+ * of them and the others find nothing left to submit.
+ */
+void IOUringIO::Submit(int opcode, int fd, Request *request, off_t offset) {
+  unsigned to_submit;
+  {
+    std::unique_lock<std::mutex> lck(latch_);
+    cv_.wait(lck, [this] { return in_flight_ < sq_entries_; });
+    in_flight_++;
+    unsigned tail = *sq_tail_;
+    unsigned index = tail & *sq_mask_;
+    struct io_uring_sqe *sqe =
+        static_cast<struct io_uring_sqe *>(sqes_ptr_) + index;
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = opcode;
+    sqe->fd = fd;
+    sqe->off = offset;
+    if (request != nullptr) {
+      sqe->addr = reinterpret_cast<unsigned long>(&request->iov);
+      sqe->len = 1;
+    }
+    sqe->user_data = reinterpret_cast<unsigned long>(request);
+    sq_array_[index] = index;
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+    to_submit = tail + 1 - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+  }
+  int rc;
+  do {
+    rc = syscall(__NR_io_uring_enter, ring_fd_, to_submit, 0, 0, nullptr, 0);
+  } while (rc < 0 && errno == EINTR);
+}
+
+/*
+ * Block in io_uring_enter() for at least one completion, then run the
+ * callbacks of everything in cq. A nop (user_data 0) submitted by the
+ * destructor ends the loop.
+ */
+void IOUringIO::ReaperLoop() {
+  while (true) {
+    unsigned head = *cq_head_;
+    if (head == __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+      syscall(__NR_io_uring_enter, ring_fd_, 0, 1, IORING_ENTER_GETEVENTS,
+              nullptr, 0);
+      continue;
+    }
+    struct io_uring_cqe *cqe =
+        static_cast<struct io_uring_cqe *>(cqes_) + (head & *cq_mask_);
+    Request *request = reinterpret_cast<Request *>(cqe->user_data);
+    ssize_t res = cqe->res;
+    __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+    // taking latch_ also orders the callback after Submit() of the request
+    bool stop;
+    {
+      std::lock_guard<std::mutex> lck(latch_);
+      in_flight_--;
+      stop = request == nullptr && !running_;
+      cv_.notify_all();
+    }
+    if (request != nullptr) {
+      request->done(res);
+      delete request;
+    }
+    if (stop) {
+      return;
+    }
+  }
+}
+#endif
+
+} // namespace scudb
@@ -1,26 +1,61 @@
 /**
  * disk_manager.cpp
  */
+#include <algorithm>
 #include <assert.h>
+#include <cerrno>
+#include <climits>
 #include <cstring>
+#include <fcntl.h>
 #include <iostream>
+#include <memory>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <thread>
+#include <unistd.h>
 
+#include "common/exception.h"
 #include "common/logger.h"
 #include "disk/disk_manager.h"
 
 namespace scudb {
 
-static char *buffer_used = nullptr;
+// first page of db file, the rest of the page is zero
+struct FileHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t page_size;
+  uint32_t num_extents;
+};
+static const uint32_t DB_FILE_MAGIC = 0x53435544; // "SCUD"
+static const uint32_t DB_FILE_VERSION = 1;
+
+// buffer aligned for O_DIRECT, released with free()
+struct AlignedFree {
+  void operator()(char *data) const { free(data); }
+};
+typedef std::unique_ptr<char, AlignedFree> AlignedBuffer;
+
+static AlignedBuffer AllocateAligned(size_t size) {
+  void *data = nullptr;
+  if (posix_memalign(&data, DIRECT_IO_ALIGNMENT, size) != 0) {
+    throw std::bad_alloc();
+  }
+  return AlignedBuffer(static_cast<char *>(data));
+}
 
 /**
  * Constructor: open/create a single database file & log file
  * @input db_file: database file name
  */
-DiskManager::DiskManager(const std::string &db_file)
-    : file_name_(db_file), next_page_id_(0), num_flushes_(0), flush_log_(false),
-      flush_log_f_(nullptr) {
+DiskManager::DiskManager(const std::string &db_file, size_t page_size,
+                         AsyncIOType async_io_type, bool direct_io)
+    : log_fd_(-1), log_file_size_(0), db_fd_(-1), file_name_(db_file),
+      page_size_(page_size), pages_per_extent_(page_size * 8),
+      direct_io_(false), db_file_size_(0), async_io_type_(async_io_type), async_io_(nullptr),
+      sync_policy_(SyncPolicy::PER_COMMIT), sync_thread_(nullptr),
+      num_extents_(0), next_free_(0), num_flushes_(0), num_syncs_(0),
+      flush_log_(false), flush_log_f_(nullptr), last_log_data_(nullptr) {
   std::string::size_type n = file_name_.find(".");
   if (n == std::string::npos) {
     LOG_DEBUG("wrong file format");
@@ -28,75 +63,330 @@ DiskManager::DiskManager(const std::string &db_file)
   }
   log_name_ = file_name_.substr(0, n) + ".log";
 
-  log_io_.open(log_name_,
-               std::ios::binary | std::ios::in | std::ios::app | std::ios::out);
-  // directory or file does not exist
-  if (!log_io_.is_open()) {
-    log_io_.clear();
-    // create a new file
-    log_io_.open(log_name_, std::ios::binary | std::ios::trunc | std::ios::app |
-                                std::ios::out);
-    log_io_.close();
-    // reopen with original mode
-    log_io_.open(log_name_, std::ios::binary | std::ios::in | std::ios::app |
-                                std::ios::out);
-  }
-
-  db_io_.open(db_file,
-              std::ios::binary | std::ios::in | std::ios::out | std::ios::out);
-  // directory or file does not exist
-  if (!db_io_.is_open()) {
-    db_io_.clear();
-    // create a new file
-    db_io_.open(db_file, std::ios::binary | std::ios::trunc | std::ios::out);
-    db_io_.close();
-    // reopen with original mode
-    db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
+  // create the files if they do not exist, log is only appended to
+  struct stat stat_buf;
+  log_fd_ = open(log_name_.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+  if (log_fd_ < 0) {
+    LOG_DEBUG("can't open log file");
+  } else if (fstat(log_fd_, &stat_buf) == 0) {
+    log_file_size_ = stat_buf.st_size;
+  }
+
+  db_fd_ = open(db_file.c_str(), O_RDWR | O_CREAT, 0644);
+  if (db_fd_ < 0) {
+    LOG_DEBUG("can't open db file");
+    return;
+  }
+  if (fstat(db_fd_, &stat_buf) == 0) {
+    db_file_size_ = stat_buf.st_size;
+  }
+  // page size of an existing file is taken from its header. a file without
+  // one is not opened, writing a header would overwrite its first page
+  if (db_file_size_ != 0 && !LoadBitmap()) {
+    close(db_fd_);
+    db_fd_ = -1;
+    if (log_fd_ >= 0) {
+      close(log_fd_);
+    }
+    throw Exception(file_name_ + " has no valid header, it may be of an "
+                                 "older format");
+  }
+  if (db_file_size_ == 0) {
+    if (!IsValidPageSize(page_size_)) {
+      LOG_DEBUG("invalid page size %zu, use %d", page_size_, DEFAULT_PAGE_SIZE);
+      page_size_ = DEFAULT_PAGE_SIZE;
+    }
+    pages_per_extent_ = page_size_ * 8;
+    WriteFileHeader();
+  }
+  if (direct_io) {
+    EnableDirectIO();
   }
 }
 
 DiskManager::~DiskManager() {
-  db_io_.close();
-  log_io_.close();
+  // completes pending async I/O
+  delete async_io_;
+  SetSyncPolicy(SyncPolicy::PER_COMMIT);
+  if (db_fd_ >= 0) {
+    close(db_fd_);
+  }
+  if (log_fd_ >= 0) {
+    close(log_fd_);
+  }
 }
 
 /**
  * Write the contents of the specified page into disk file
  */
 void DiskManager::WritePage(page_id_t page_id, const char *page_data) {
-  size_t offset = page_id * PAGE_SIZE;
-  // set write cursor to offset
-  db_io_.seekp(offset);
-  db_io_.write(page_data, PAGE_SIZE);
-  // check for I/O error
-  if (db_io_.bad()) {
-    LOG_DEBUG("I/O error while writing");
-    return;
-  }
-  // needs to flush to keep disk file in sync
-  db_io_.flush();
+  auto start = std::chrono::steady_clock::now();
+  FinishWrite(GetPageOffset(page_id), page_data, 0);
+  write_latency_.Record(std::chrono::steady_clock::now() - start);
 }
 
 /**
  * Read the contents of the specified page into the given memory area
  */
 void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
-  int offset = page_id * PAGE_SIZE;
+  off_t offset = GetPageOffset(page_id);
   // check if read beyond file length
-  if (offset > GetFileSize(file_name_)) {
+  if (offset > db_file_size_.load()) {
     LOG_DEBUG("I/O error while reading");
     // std::cerr << "I/O error while reading" << std::endl;
+    // a page never written reads as zeros, like one at the end of file
+    memset(page_data, 0, page_size_);
   } else {
-    // set read cursor to offset
-    db_io_.seekp(offset);
-    db_io_.read(page_data, PAGE_SIZE);
-    // if file ends before reading PAGE_SIZE
-    int read_count = db_io_.gcount();
-    if (read_count < PAGE_SIZE) {
-      LOG_DEBUG("Read less than a page");
-      // std::cerr << "Read less than a page" << std::endl;
-      memset(page_data + read_count, 0, PAGE_SIZE - read_count);
+    auto start = std::chrono::steady_clock::now();
+    FinishRead(offset, page_data, 0);
+    read_latency_.Record(std::chrono::steady_clock::now() - start);
+  }
+}
+
+/**
+ * Write a batch of pages. Pages are sorted by page id and every run of
+ * adjacent page ids goes to disk with a single pwritev(). Under
+ * SyncPolicy::PER_BATCH the batch is followed by one fdatasync().
+ */
+void DiskManager::WritePages(
+    std::vector<std::pair<page_id_t, const char *>> &pages) {
+  std::sort(pages.begin(), pages.end());
+  std::vector<struct iovec> iov;
+  std::vector<AlignedBuffer> bounces;
+  size_t begin = 0;
+  while (begin < pages.size()) {
+    // page ids on both sides of a bitmap page are not adjacent in the file
+    size_t end = begin + 1;
+    while (end < pages.size() && end - begin < IOV_MAX &&
+           GetPageOffset(pages[end].first) ==
+               GetPageOffset(pages[end - 1].first) +
+                   static_cast<off_t>(page_size_)) {
+      end++;
+    }
+    iov.clear();
+    for (size_t i = begin; i < end; ++i) {
+      char *data = const_cast<char *>(pages[i].second);
+      if (NeedsBounce(data)) {
+        bounces.push_back(AllocateAligned(page_size_));
+        memcpy(bounces.back().get(), data, page_size_);
+        data = bounces.back().get();
+      }
+      iov.push_back({data, page_size_});
+    }
+    off_t offset = GetPageOffset(pages[begin].first);
+    auto start = std::chrono::steady_clock::now();
+    ssize_t rc;
+    do {
+      rc = pwritev(db_fd_, iov.data(), iov.size(), offset);
+    } while (rc < 0 && errno == EINTR);
+    // finish what is left of a short write page by page
+    size_t written = rc < 0 ? 0 : rc;
+    for (size_t i = begin; i < end; ++i) {
+      size_t done = std::min<size_t>(written, page_size_);
+      written -= done;
+      FinishWrite(GetPageOffset(pages[i].first),
+                  pages[i].second, done);
+    }
+    write_latency_.Record(std::chrono::steady_clock::now() - start);
+    begin = end;
+  }
+  if (sync_policy_ == SyncPolicy::PER_BATCH && !pages.empty()) {
+    SyncFile(db_fd_);
+  }
+}
+
+/**
+ * Make everything written so far durable, db file and log
+ */
+void DiskManager::Sync() {
+  SyncFile(db_fd_);
+  SyncFile(log_fd_);
+}
+
+/**
+ * Change sync policy, the periodic sync thread is started or stopped
+ * accordingly
+ */
+void DiskManager::SetSyncPolicy(SyncPolicy policy) {
+  std::thread *sync_thread = nullptr;
+  {
+    std::lock_guard<std::mutex> lck(sync_latch_);
+    sync_policy_ = policy;
+    if (policy == SyncPolicy::PERIODIC && sync_thread_ == nullptr) {
+      sync_thread_ = new std::thread(&DiskManager::SyncLoop, this);
+    } else if (policy != SyncPolicy::PERIODIC) {
+      std::swap(sync_thread, sync_thread_);
+      sync_cv_.notify_one();
+    }
+  }
+  if (sync_thread != nullptr) {
+    sync_thread->join();
+    delete sync_thread;
+  }
+}
+
+/**
+ * Body of the periodic sync thread, a last sync is done when it stops
+ */
+void DiskManager::SyncLoop() {
+  std::unique_lock<std::mutex> lck(sync_latch_);
+  while (sync_policy_ == SyncPolicy::PERIODIC) {
+    sync_cv_.wait_for(lck, SYNC_INTERVAL);
+    lck.unlock();
+    Sync();
+    lck.lock();
+  }
+}
+
+/**
+ * Private helper function to fdatasync one file
+ */
+void DiskManager::SyncFile(int fd) {
+  if (fd < 0) {
+    return;
+  }
+  if (fdatasync(fd) != 0) {
+    LOG_DEBUG("I/O error while syncing");
+  }
+  num_syncs_++;
+}
+
+/**
+ * Asynchronous WritePage(), page_data must stay untouched until the returned
+ * future is ready
+ */
+std::future<void> DiskManager::WritePageAsync(page_id_t page_id,
+                                              const char *page_data) {
+  off_t offset = GetPageOffset(page_id);
+  auto promise = std::make_shared<std::promise<void>>();
+  if (NeedsBounce(page_data)) {
+    WritePage(page_id, page_data);
+    promise->set_value();
+    return promise->get_future();
+  }
+  auto start = std::chrono::steady_clock::now();
+  GetAsyncIO()->Write(db_fd_, page_data, page_size_, offset,
+                      [this, promise, offset, page_data, start](ssize_t rc) {
+                        if (rc < 0) {
+                          LOG_DEBUG("I/O error while writing");
+                        } else {
+                          // short write, the rest is done synchronously
+                          FinishWrite(offset, page_data, rc);
+                        }
+                        write_latency_.Record(
+                            std::chrono::steady_clock::now() - start);
+                        promise->set_value();
+                      });
+  return promise->get_future();
+}
+
+/**
+ * Asynchronous ReadPage(), page_data must stay untouched until the returned
+ * future is ready
+ */
+std::future<void> DiskManager::ReadPageAsync(page_id_t page_id,
+                                             char *page_data) {
+  off_t offset = GetPageOffset(page_id);
+  auto promise = std::make_shared<std::promise<void>>();
+  if (offset > db_file_size_.load()) {
+    LOG_DEBUG("I/O error while reading");
+    memset(page_data, 0, page_size_);
+    promise->set_value();
+    return promise->get_future();
+  }
+  if (NeedsBounce(page_data)) {
+    ReadPage(page_id, page_data);
+    promise->set_value();
+    return promise->get_future();
+  }
+  auto start = std::chrono::steady_clock::now();
+  GetAsyncIO()->Read(db_fd_, page_data, page_size_, offset,
+                     [this, promise, offset, page_data, start](ssize_t rc) {
+                       if (rc < 0) {
+                         LOG_DEBUG("I/O error while reading");
+                         rc = 0;
+                       }
+                       FinishRead(offset, page_data, rc);
+                       read_latency_.Record(
+                           std::chrono::steady_clock::now() - start);
+                       promise->set_value();
+                     });
+  return promise->get_future();
+}
+
+/**
+ * Private helper function to create the async I/O engine on first use
+ */
+AsyncIO *DiskManager::GetAsyncIO() {
+  std::call_once(async_io_once_, [this] {
+    async_io_ = AsyncIO::Create(async_io_type_, ASYNC_IO_QUEUE_DEPTH);
+  });
+  return async_io_;
+}
+
+/**
+ * Private helper function to write the page from written bytes on
+ */
+void DiskManager::FinishWrite(off_t offset, const char *page_data,
+                              size_t written) {
+  if (NeedsBounce(page_data)) {
+    AlignedBuffer bounce = AllocateAligned(page_size_);
+    memcpy(bounce.get(), page_data, page_size_);
+    FinishWrite(offset, bounce.get(), written);
+    return;
+  }
+  while (written < page_size_) {
+    ssize_t rc = pwrite(db_fd_, page_data + written, page_size_ - written,
+                        offset + written);
+    if (rc < 0 && errno == EINTR) {
+      continue;
+    }
+    // check for I/O error
+    if (rc <= 0) {
+      LOG_DEBUG("I/O error while writing");
+      return;
     }
+    written += rc;
+  }
+  // grow the file size if the page was written past the end
+  off_t end = offset + page_size_;
+  off_t size = db_file_size_.load();
+  while (size < end && !db_file_size_.compare_exchange_weak(size, end)) {
+  }
+}
+
+/**
+ * Private helper function to read the page from read_count bytes on, the
+ * part after end of file is zeroed
+ */
+void DiskManager::FinishRead(off_t offset, char *page_data,
+                             size_t read_count) {
+  if (NeedsBounce(page_data)) {
+    AlignedBuffer bounce = AllocateAligned(page_size_);
+    memcpy(bounce.get(), page_data, read_count);
+    FinishRead(offset, bounce.get(), read_count);
+    memcpy(page_data, bounce.get(), page_size_);
+    return;
+  }
+  while (read_count < page_size_) {
+    ssize_t rc = pread(db_fd_, page_data + read_count, page_size_ - read_count,
+                       offset + read_count);
+    if (rc < 0 && errno == EINTR) {
+      continue;
+    }
+    if (rc < 0) {
+      LOG_DEBUG("I/O error while reading");
+    }
+    if (rc <= 0) {
+      break;
+    }
+    read_count += rc;
+  }
+  // if file ends before reading a page
+  if (read_count < page_size_) {
+    LOG_DEBUG("Read less than a page");
+    // std::cerr << "Read less than a page" << std::endl;
+    memset(page_data + read_count, 0, page_size_ - read_count);
   }
 }
 
@@ -106,8 +396,8 @@ void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
  */
 void DiskManager::WriteLog(char *log_data, int size) {
   // enforce swap log buffer
-  assert(log_data != buffer_used);
-  buffer_used = log_data;
+  assert(log_data != last_log_data_);
+  last_log_data_ = log_data;
 
   if (size == 0) // no effect on num_flushes_ if log buffer is empty
     return;
@@ -120,16 +410,25 @@ void DiskManager::WriteLog(char *log_data, int size) {
            std::future_status::ready);
 
   num_flushes_ += 1;
-  // sequence write
-  log_io_.write(log_data, size);
-
-  // check for I/O error
-  if (log_io_.bad()) {
-    LOG_DEBUG("I/O error while writing log");
-    return;
+  // sequence write, log_fd_ is opened in append mode
+  int written = 0;
+  while (written < size) {
+    ssize_t rc = write(log_fd_, log_data + written, size - written);
+    if (rc < 0 && errno == EINTR) {
+      continue;
+    }
+    // check for I/O error
+    if (rc <= 0) {
+      LOG_DEBUG("I/O error while writing log");
+      return;
+    }
+    written += rc;
+  }
+  log_file_size_ += size;
+  // a periodic sync makes it durable later
+  if (sync_policy_ != SyncPolicy::PERIODIC) {
+    SyncFile(log_fd_);
   }
-  // needs to flush to keep disk file in sync
-  log_io_.flush();
   flush_log_ = false;
 }
 
@@ -138,36 +437,229 @@ void DiskManager::WriteLog(char *log_data, int size) {
  * Always read from the beginning and perform sequence read
  * @return: false means already reach the end
  */
-bool DiskManager::ReadLog(char *log_data, int size, int offset) {
-  if (offset >= GetFileSize(log_name_)) {
+bool DiskManager::ReadLog(char *log_data, int size, off_t offset) {
+  if (offset >= log_file_size_.load()) {
     // LOG_DEBUG("end of log file");
-    // LOG_DEBUG("file size is %d", GetFileSize(log_name_));
     return false;
   }
-  log_io_.seekp(offset);
-  log_io_.read(log_data, size);
+  int read_count = 0;
+  while (read_count < size) {
+    ssize_t rc =
+        pread(log_fd_, log_data + read_count, size - read_count,
+              offset + read_count);
+    if (rc < 0 && errno == EINTR) {
+      continue;
+    }
+    if (rc <= 0) {
+      break;
+    }
+    read_count += rc;
+  }
   // if log file ends before reading "size"
-  int read_count = log_io_.gcount();
   if (read_count < size) {
-    log_io_.clear();
     memset(log_data + read_count, 0, size - read_count);
   }
 
   return true;
 }
 
+/**
+ * The prefix is punched out of the file rather than cut off, so that the
+ * log keeps growing at the same offsets and nothing has to be moved
+ */
+void DiskManager::TruncateLog(off_t offset) {
+  offset = std::min(offset, log_file_size_.load());
+  if (offset <= 0) {
+    return;
+  }
+  if (fallocate(log_fd_, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, 0,
+                offset) != 0) {
+    LOG_DEBUG("log truncation not supported");
+  }
+}
+
 /**
  * Allocate new page (operations like create index/table)
- * For now just keep an increasing counter
+ * The lowest free page id is handed out, so that space of deallocated pages
+ * is reused before the file grows. The bitmap is scanned from next_free_ a
+ * byte at a time. When every extent is full a new one is added. The bitmap
+ * page is synced before the page id is handed out, a crash can not make a
+ * page in use look free.
  */
-page_id_t DiskManager::AllocatePage() { return next_page_id_++; }
+page_id_t DiskManager::AllocatePage() {
+  std::lock_guard<std::mutex> lck(alloc_latch_);
+  size_t byte = next_free_ / 8;
+  while (byte < bitmap_.size() &&
+         static_cast<unsigned char>(bitmap_[byte]) == 0xff) {
+    byte++;
+  }
+  if (byte == bitmap_.size()) {
+    AddExtent();
+  }
+  // pages below next_free_ are in use, so is every lower bit of this byte
+  size_t page_id = byte * 8;
+  while ((bitmap_[page_id / 8] & (1 << (page_id % 8))) != 0) {
+    page_id++;
+  }
+  bitmap_[page_id / 8] |= 1 << (page_id % 8);
+  next_free_ = page_id + 1;
+  WriteBitmapPage(page_id / pages_per_extent_);
+  SyncFile(db_fd_);
+  return page_id;
+}
 
 /**
  * Deallocate page (operations like drop index/table)
- * Need bitmap in header page for tracking pages
+ * The page is marked free in the bitmap of its extent. That is not synced, a
+ * crash can only leak the page
+ */
+void DiskManager::DeallocatePage(page_id_t page_id) {
+  std::lock_guard<std::mutex> lck(alloc_latch_);
+  if (page_id < 0 ||
+      static_cast<size_t>(page_id) >= num_extents_ * pages_per_extent_ ||
+      (bitmap_[page_id / 8] & (1 << (page_id % 8))) == 0) {
+    LOG_DEBUG("deallocate page %d that is not allocated", page_id);
+    return;
+  }
+  bitmap_[page_id / 8] &= ~(1 << (page_id % 8));
+  next_free_ = std::min<size_t>(next_free_, page_id);
+  WriteBitmapPage(page_id / pages_per_extent_);
+}
+
+/**
+ * Returns true if page_id is allocated
+ */
+bool DiskManager::IsAllocated(page_id_t page_id) {
+  std::lock_guard<std::mutex> lck(alloc_latch_);
+  return page_id >= 0 &&
+         static_cast<size_t>(page_id) < num_extents_ * pages_per_extent_ &&
+         (bitmap_[page_id / 8] & (1 << (page_id % 8))) != 0;
+}
+
+/**
+ * Returns number of page ids that lie within db file, pages after them were
+ * never written
+ */
+page_id_t DiskManager::GetNumPages() {
+  // skip the file header, then every extent is a bitmap page followed by
+  // pages_per_extent_ pages
+  off_t num_slots = db_file_size_.load() / page_size_;
+  if (num_slots <= 1) {
+    return 0;
+  }
+  off_t extent_slots = pages_per_extent_ + 1;
+  off_t full_extents = (num_slots - 1) / extent_slots;
+  off_t rest = (num_slots - 1) % extent_slots;
+  return full_extents * pages_per_extent_ + std::max<off_t>(rest - 1, 0);
+}
+
+/**
+ * Private helper function to check a page size against the supported range.
+ * TEST_PAGE_SIZE is let through so tests can build deep trees from few keys
  */
-void DiskManager::DeallocatePage(__attribute__((unused)) page_id_t page_id) {
-  return;
+bool DiskManager::IsValidPageSize(size_t page_size) {
+  if (page_size == TEST_PAGE_SIZE) {
+    return true;
+  }
+  return page_size >= MIN_PAGE_SIZE && page_size <= MAX_PAGE_SIZE &&
+         (page_size & (page_size - 1)) == 0;
+}
+
+/**
+ * Private helper function to map a page id to its offset in db file
+ * Layout: file header, then extents made of one bitmap page followed by the
+ * pages_per_extent_ pages it tracks.
+ */
+off_t DiskManager::GetPageOffset(page_id_t page_id) {
+  off_t extent = page_id / pages_per_extent_;
+  off_t slot = 1 + extent * (pages_per_extent_ + 1) + 1 +
+               page_id % pages_per_extent_;
+  return slot * page_size_;
+}
+
+/**
+ * Private helper function to map an extent to the offset of its bitmap page
+ */
+off_t DiskManager::GetBitmapOffset(size_t extent) {
+  return static_cast<off_t>(1 + extent * (pages_per_extent_ + 1)) * page_size_;
+}
+
+/**
+ * Private helper function to write the file header
+ */
+void DiskManager::WriteFileHeader() {
+  std::vector<char> data(page_size_, 0);
+  FileHeader *header = reinterpret_cast<FileHeader *>(data.data());
+  header->magic = DB_FILE_MAGIC;
+  header->version = DB_FILE_VERSION;
+  header->page_size = page_size_;
+  header->num_extents = num_extents_;
+  FinishWrite(0, data.data(), 0);
+}
+
+/**
+ * Private helper function to write the bitmap page of an extent
+ * NOTE: caller must hold alloc_latch_
+ */
+void DiskManager::WriteBitmapPage(size_t extent) {
+  FinishWrite(GetBitmapOffset(extent), bitmap_.data() + extent * page_size_, 0);
+}
+
+/**
+ * Private helper function to append an empty extent, its bitmap page is
+ * written before the file header that counts it
+ * NOTE: caller must hold alloc_latch_
+ */
+void DiskManager::AddExtent() {
+  size_t extent = num_extents_;
+  bitmap_.resize((extent + 1) * page_size_, 0);
+  WriteBitmapPage(extent);
+  num_extents_++;
+  WriteFileHeader();
+}
+
+/**
+ * Private helper function to restore page size and allocator state on
+ * reopen. Only the file header and one bitmap page per extent are read.
+ * @return: false if db file has no valid header
+ */
+bool DiskManager::LoadBitmap() {
+  FileHeader header;
+  if (pread(db_fd_, &header, sizeof(header), 0) != sizeof(header) ||
+      header.magic != DB_FILE_MAGIC || !IsValidPageSize(header.page_size)) {
+    LOG_DEBUG("db file has no valid header");
+    return false;
+  }
+  page_size_ = header.page_size;
+  pages_per_extent_ = page_size_ * 8;
+  num_extents_ = header.num_extents;
+  bitmap_.resize(num_extents_ * page_size_);
+  for (size_t extent = 0; extent < num_extents_; ++extent) {
+    FinishRead(GetBitmapOffset(extent), bitmap_.data() + extent * page_size_, 0);
+  }
+  next_free_ = 0;
+  return true;
+}
+
+/**
+ * Private helper function to switch db file to O_DIRECT once its page size
+ * is known. A direct read of the header page checks that the file system and
+ * device accept the page size, buffered I/O is kept otherwise.
+ */
+void DiskManager::EnableDirectIO() {
+  int flags = fcntl(db_fd_, F_GETFL);
+  if (flags < 0 || fcntl(db_fd_, F_SETFL, flags | O_DIRECT) < 0) {
+    LOG_DEBUG("O_DIRECT is not supported, keep buffered I/O");
+    return;
+  }
+  AlignedBuffer buffer = AllocateAligned(page_size_);
+  if (pread(db_fd_, buffer.get(), page_size_, 0) < 0) {
+    LOG_DEBUG("direct read of %zu bytes failed, keep buffered I/O",
+              page_size_);
+    fcntl(db_fd_, F_SETFL, flags);
+    return;
+  }
+  direct_io_ = true;
 }
 
 /**
@@ -176,17 +668,13 @@ void DiskManager::DeallocatePage(__attribute__((unused)) page_id_t page_id) {
 int DiskManager::GetNumFlushes() const { return num_flushes_; }
 
 /**
- * Returns true if the log is currently being flushed
+ * Returns number of fdatasync calls made so far, on both files
  */
-bool DiskManager::GetFlushState() const { return flush_log_; }
+int DiskManager::GetNumSyncs() const { return num_syncs_; }
 
 /**
- * Private helper function to get disk file size
+ * Returns true if the log is currently being flushed
  */
-int DiskManager::GetFileSize(const std::string &file_name) {
-  struct stat stat_buf;
-  int rc = stat(file_name.c_str(), &stat_buf);
-  return rc == 0 ? stat_buf.st_size : -1;
-}
+bool DiskManager::GetFlushState() const { return flush_log_; }
 
 } // namespace scudb
@@ -0,0 +1,191 @@
+#include <functional>
+#include <thread>
+
+#include "common/exception.h"
+#include "hash/linear_probe_hash_table.h"
+#include "page/page.h"
+
+namespace scudb {
+
+/*
+ * constructor
+ * num_entries: number of entries the table must hold, capacity is the next
+ * power of 2 of twice that
+ */
+template <typename K, typename V>
+LinearProbeHashTable<K, V>::LinearProbeHashTable(size_t num_entries)
+    : capacity_(8), shift_(61), size_(0), moves_(0) {
+  while (capacity_ < num_entries * 2) {
+    capacity_ *= 2;
+    shift_--;
+  }
+  mask_ = capacity_ - 1;
+  slots_.reset(new Slot[capacity_]);
+  for (size_t i = 0; i < capacity_; ++i) {
+    slots_[i].meta.store(0);
+    slots_[i].key.store(K());
+    slots_[i].value.store(V());
+  }
+}
+
+/*
+ * Fibonacci hashing on top of the STL hash, consecutive page ids are spread
+ * over the table
+ */
+template <typename K, typename V>
+size_t LinearProbeHashTable<K, V>::Home(const K &key) const {
+  uint64_t hash = std::hash<K>{}(key);
+  return (hash * 0x9E3779B97F4A7C15ULL) >> shift_;
+}
+
+/*
+ * Seqlock read of one slot: the version is read before and after key and
+ * value, a slot changed in between is read again
+ */
+template <typename K, typename V>
+bool LinearProbeHashTable<K, V>::ReadSlot(size_t index, K &key,
+                                          V &value) const {
+  const Slot &slot = slots_[index];
+  while (true) {
+    uint32_t meta = slot.meta.load(std::memory_order_acquire);
+    if (meta & BUSY) {
+      std::this_thread::yield();
+      continue;
+    }
+    if (!(meta & FULL)) {
+      return false;
+    }
+    key = slot.key.load(std::memory_order_relaxed);
+    value = slot.value.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.meta.load(std::memory_order_relaxed) == meta) {
+      return true;
+    }
+  }
+}
+
+template <typename K, typename V>
+void LinearProbeHashTable<K, V>::WriteSlot(size_t index, const K &key,
+                                           const V &value) {
+  Slot &slot = slots_[index];
+  uint32_t meta = slot.meta.load(std::memory_order_relaxed);
+  slot.meta.store(meta | BUSY, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.key.store(key, std::memory_order_relaxed);
+  slot.value.store(value, std::memory_order_relaxed);
+  slot.meta.store(((meta & ~(BUSY | FULL)) + VERSION) | FULL,
+                  std::memory_order_release);
+}
+
+/*
+ * Probe from the home slot until the key or an empty slot is found, without
+ * any lock. A miss is only trusted if no Remove() moved entries meanwhile,
+ * as the key may have been shifted behind the probe.
+ */
+template <typename K, typename V>
+bool LinearProbeHashTable<K, V>::Find(const K &key, V &value) {
+  while (true) {
+    uint64_t moves = moves_.load(std::memory_order_acquire);
+    if (moves & 1) {
+      std::this_thread::yield();
+      continue;
+    }
+    K slot_key;
+    V slot_value;
+    for (size_t i = Home(key), n = 0; n < capacity_; i = (i + 1) & mask_, ++n) {
+      if (!ReadSlot(i, slot_key, slot_value)) {
+        break;
+      }
+      if (slot_key == key) {
+        value = slot_value;
+        return true;
+      }
+    }
+    if (moves_.load(std::memory_order_acquire) == moves) {
+      return false;
+    }
+  }
+}
+
+/*
+ * Remove the entry and close the gap: every following entry of the cluster
+ * that may be stored at the gap without passing its home slot is moved
+ * there, which opens a new gap at its old place (backward shift deletion).
+ * No tombstone is left, so probe length does not grow with deletions.
+ */
+template <typename K, typename V>
+bool LinearProbeHashTable<K, V>::Remove(const K &key) {
+  std::lock_guard<std::mutex> lck(latch_);
+  K slot_key;
+  V slot_value;
+  size_t hole = Home(key);
+  while (true) {
+    if (!ReadSlot(hole, slot_key, slot_value)) {
+      return false;
+    }
+    if (slot_key == key) {
+      break;
+    }
+    hole = (hole + 1) & mask_;
+  }
+
+  uint64_t moves = moves_.load(std::memory_order_relaxed);
+  bool moving = false;
+  for (size_t i = (hole + 1) & mask_; ReadSlot(i, slot_key, slot_value);
+       i = (i + 1) & mask_) {
+    // distance from home must not shrink below the distance to the hole
+    if (((i - Home(slot_key)) & mask_) < ((i - hole) & mask_)) {
+      continue;
+    }
+    if (!moving) {
+      moving = true;
+      moves_.store(moves + 1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+    }
+    WriteSlot(hole, slot_key, slot_value);
+    hole = i;
+  }
+  Slot &slot = slots_[hole];
+  uint32_t meta = slot.meta.load(std::memory_order_relaxed);
+  slot.meta.store((meta & ~(BUSY | FULL)) + VERSION, std::memory_order_release);
+  if (moving) {
+    moves_.store(moves + 2, std::memory_order_release);
+  }
+  size_--;
+  return true;
+}
+
+/*
+ * Overwrite the value if key exists, otherwise take the first empty slot
+ * after the home slot. One slot is always kept empty so that probing ends.
+ */
+template <typename K, typename V>
+void LinearProbeHashTable<K, V>::Insert(const K &key, const V &value) {
+  std::lock_guard<std::mutex> lck(latch_);
+  K slot_key;
+  V slot_value;
+  size_t i = Home(key);
+  while (ReadSlot(i, slot_key, slot_value)) {
+    if (slot_key == key) {
+      WriteSlot(i, key, value);
+      return;
+    }
+    i = (i + 1) & mask_;
+  }
+  if (size_ + 1 >= capacity_) {
+    throw Exception(EXCEPTION_TYPE_OUT_OF_RANGE, "hash table is full");
+  }
+  WriteSlot(i, key, value);
+  size_++;
+}
+
+template <typename K, typename V>
+size_t LinearProbeHashTable<K, V>::GetSize() {
+  std::lock_guard<std::mutex> lck(latch_);
+  return size_;
+}
+
+template class LinearProbeHashTable<page_id_t, Page *>;
+// test purpose
+template class LinearProbeHashTable<int, int>;
+} // namespace scudb
@@ -0,0 +1,52 @@
+/**
+ * buffer_access_strategy.h
+ *
+ * Ring of frames for a large sequential operation, such as a full table scan
+ * or a bulk load. Once the ring is full, every page the operation has to read
+ * or create goes into the next frame of the ring instead of a victim of the
+ * whole pool, so the operation does not push the working set of everybody
+ * else out. A frame of the ring that is pinned, or no longer holds the page
+ * the ring put there, is replaced by a regular victim. Pages read ahead for
+ * the operation join the ring when the operation fetches them, a clean frame
+ * they push out of the ring is freed.
+ * A strategy is passed to FetchPage() and NewPage() of the buffer pool,
+ * usually through the Transaction of the operation. It must not be shared by
+ * threads.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "common/config.h"
+
+namespace scudb {
+
+class BufferPoolManager;
+
+class BufferAccessStrategy {
+  friend class BufferPoolManagerInstance;
+
+public:
+  // ring_size frames at most are used by the operation
+  BufferAccessStrategy(size_t ring_size);
+
+  inline size_t GetRingSize() const { return ring_.size(); }
+
+private:
+  struct Slot {
+    BufferPoolManager *owner = nullptr; // instance the frame belongs to
+    size_t frame_id = 0;
+    page_id_t page_id = INVALID_PAGE_ID;
+  };
+
+  // move to the next slot, true if it holds a frame of owner
+  bool Next(BufferPoolManager *owner, size_t &frame_id, page_id_t &page_id);
+  // remember a frame in the current slot
+  void Set(BufferPoolManager *owner, size_t frame_id, page_id_t page_id);
+
+  std::vector<Slot> ring_;
+  size_t current_;
+};
+
+} // namespace scudb
@@ -3,46 +3,164 @@
  *
  * Functionality: The simplified Buffer Manager interface allows a client to
  * new/delete pages on disk, to read a disk page into the buffer pool and pin
- * it, also to unpin a page in the buffer pool.
+ * it, also to unpin a page in the buffer pool. It is implemented by a single
+ * BufferPoolManagerInstance and by the partitioned ParallelBufferPoolManager.
  */
 
 #pragma once
-#include <list>
+#include <chrono>
+#include <condition_variable>
 #include <mutex>
-#include <iostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 
-#include "buffer/lru_replacer.h"
-#include "disk/disk_manager.h"
-#include "hash/extendible_hash.h"
-#include "logging/log_manager.h"
+#include "buffer/buffer_access_strategy.h"
+#include "buffer/page_guard.h"
+#include "common/stats.h"
 #include "page/page.h"
 
 namespace scudb {
+// progress of a BufferPoolManager::Resize() call
+struct ResizeProgress {
+  bool in_progress = false;
+  size_t target_pool_size = 0;
+  size_t frames_to_release = 0; // frames a shrink gives up
+  size_t frames_released = 0;
+  size_t pages_relocated = 0; // moved to a frame that is kept
+  size_t pages_evicted = 0;
+  size_t pages_written = 0; // dirty pages written back before release
+};
+
+// snapshot of the statistics of a buffer pool, counters start at
+// construction
+struct BufferPoolStats {
+  uint64_t hits = 0;        // FetchPage() of a resident page
+  uint64_t misses = 0;      // FetchPage() that had to read the page
+  uint64_t evictions = 0;   // resident pages replaced
+  uint64_t write_backs = 0; // pages written to disk by the pool
+  uint64_t latch_waits = 0; // acquisitions of the latch that had to wait
+  uint64_t latch_wait_us = 0;
+  uint64_t ring_reuses = 0; // victims taken from a BufferAccessStrategy ring
+  size_t pool_size = 0;
+  size_t free_frames = 0; // length of free list
+  size_t pinned_frames = 0;
+  size_t dirty_frames = 0;
+  LatencyHistogram disk_reads;
+  LatencyHistogram disk_writes;
+
+  std::string ToString() const;
+};
+
 class BufferPoolManager {
 public:
-  BufferPoolManager(size_t pool_size, DiskManager *disk_manager,
-                          LogManager *log_manager = nullptr);
+  virtual ~BufferPoolManager();
+
+  // with a strategy, a page that is not resident is read into a frame of
+  // its ring, see BufferAccessStrategy
+  virtual Page *FetchPage(page_id_t page_id,
+                          BufferAccessStrategy *strategy = nullptr) = 0;
+
+  virtual bool UnpinPage(page_id_t page_id, bool is_dirty) = 0;
+
+  virtual bool FlushPage(page_id_t page_id) = 0;
+
+  // write every dirty page as one batch, see DiskManager::WritePages()
+  virtual void FlushAllPages() = 0;
+
+  virtual Page *NewPage(page_id_t &page_id,
+                        BufferAccessStrategy *strategy = nullptr) = 0;
 
-  ~BufferPoolManager();
+  virtual bool DeletePage(page_id_t page_id) = 0;
 
-  Page *FetchPage(page_id_t page_id);
+  // fetch or create a page as a guard, see page_guard.h. the guard is empty
+  // if every frame is pinned
+  BasicPageGuard FetchPageBasic(page_id_t page_id,
+                                BufferAccessStrategy *strategy = nullptr);
+  ReadPageGuard FetchPageRead(page_id_t page_id,
+                              BufferAccessStrategy *strategy = nullptr);
+  WritePageGuard FetchPageWrite(page_id_t page_id,
+                                BufferAccessStrategy *strategy = nullptr);
+  WritePageGuard NewPageGuarded(page_id_t &page_id,
+                                BufferAccessStrategy *strategy = nullptr);
 
-  bool UnpinPage(page_id_t page_id, bool is_dirty);
+  // same as UnpinPage() for a page the caller holds, without the page table
+  // lookup
+  virtual bool UnpinFrame(Page *page, bool is_dirty) = 0;
 
-  bool FlushPage(page_id_t page_id);
+  // log every pinned frame, returns how many there are. once the users of
+  // the pool are done nothing should be pinned, debug builds check it at
+  // destruction
+  virtual size_t CheckPinLeaks() = 0;
 
-  Page *NewPage(page_id_t &page_id);
+  // size of every page, taken from the db file
+  inline size_t GetPageSize() const { return page_size_; }
 
-  bool DeletePage(page_id_t page_id);
+  // spawn a separate thread that writes back dirty pages at the cold end of
+  // replacer ahead of eviction. it starts when fewer than low_watermark
+  // frames are free or clean and stops at high_watermark, writing at most
+  // max_pages_per_sec pages (0 means unlimited)
+  virtual void RunCleanerThread(size_t low_watermark, size_t high_watermark,
+                                size_t max_pages_per_sec = 0) = 0;
+  virtual void StopCleanerThread() = 0;
+
+  // load count pages starting at first_page_id in the background, into free
+  // frames or clean frames at the cold end of replacer. pages are not pinned.
+  // returns how many of the pages were requested, it stops early at the end
+  // of db file or when too much readahead is already queued
+  virtual size_t PrefetchPages(page_id_t first_page_id, size_t count) = 0;
+
+  // change the number of frames while the pool is in use. a shrink waits
+  // for pinned pages in released frames to be unpinned, their readers are
+  // not disturbed. concurrent calls are serialized
+  virtual void Resize(size_t new_pool_size) = 0;
+  // progress of the running or last Resize() call
+  virtual ResizeProgress GetResizeProgress() = 0;
+  virtual size_t GetPoolSize() = 0;
+
+  // cheap enough to be polled while the pool is busy
+  virtual BufferPoolStats GetStats() = 0;
+
+  // (page id, recLSN) of every page that may hold a logged change not yet
+  // on disk, without stalling writers, see CheckpointManager
+  virtual std::vector<std::pair<page_id_t, lsn_t>> GetDirtyPageTable() = 0;
+
+  // write the ids of the resident pages to file_name, from the cold to the
+  // hot end of replacer, pinned pages last. false if it can not be written
+  bool DumpWarmState(const std::string &file_name);
+  // load the pages of a dump in the background while the pool is in use.
+  // returns how many pages are to be loaded
+  size_t RestoreWarmState(const std::string &file_name);
+  // block until the running restore is done
+  virtual void WaitForWarmRestore() = 0;
+  // spawn a separate thread that dumps every interval, the pool is dumped
+  // once more when the thread is stopped, at the latest at shutdown
+  void RunWarmStateThread(const std::string &file_name,
+                          std::chrono::milliseconds interval);
+  void StopWarmStateThread();
+
+protected:
+  explicit BufferPoolManager(size_t page_size);
+
+  // ids of the resident pages in the order they are dumped
+  virtual void CollectWarmPages(std::vector<page_id_t> &page_ids) = 0;
+  // start loading page_ids, in dump order
+  virtual size_t StartWarmRestore(std::vector<page_id_t> &page_ids) = 0;
+
+  size_t page_size_; // size of a page in byte
 
 private:
-  size_t pool_size_; // number of pages in buffer pool
-  Page *pages_;      // array of pages
-  DiskManager *disk_manager_;
-  LogManager *log_manager_;
-  HashTable<page_id_t, Page *> *page_table_; // to keep track of pages
-  Replacer<Page *> *replacer_;   // to find an unpinned page for replacement
-  std::list<Page *> *free_list_; // to find a free page for replacement
-  std::mutex latch_;             // to protect shared data structure
+  // body of the warm state thread
+  void WarmStateLoop();
+
+  // periodic warm state dump. the last dump needs the pages, so the
+  // destructor of an implementation stops the thread
+  std::mutex warm_state_latch_;
+  std::thread *warm_state_thread_;
+  bool warm_state_running_;
+  std::string warm_state_file_;
+  std::chrono::milliseconds warm_state_interval_;
+  std::condition_variable warm_state_cv_;
 };
 } // namespace scudb
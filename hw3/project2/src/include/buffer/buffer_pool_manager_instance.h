@@ -0,0 +1,174 @@
+/*
+ * buffer_pool_manager_instance.h
+ *
+ * Functionality: A single buffer pool with its own frames, page table,
+ * replacer, free list and latch, see BufferPoolManager for the interface.
+ */
+
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/clock_replacer.h"
+#include "buffer/lru_k_replacer.h"
+#include "buffer/lru_replacer.h"
+#include "disk/disk_manager.h"
+#include "hash/linear_probe_hash_table.h"
+#include "logging/log_manager.h"
+
+namespace scudb {
+class BufferPoolManagerInstance : public BufferPoolManager {
+  friend class ParallelBufferPoolManager;
+
+public:
+  BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager,
+                            LogManager *log_manager = nullptr,
+                            ReplacerType replacer_type = ReplacerType::LRU);
+
+  ~BufferPoolManagerInstance();
+
+  Page *FetchPage(page_id_t page_id,
+                  BufferAccessStrategy *strategy = nullptr) override;
+
+  bool UnpinPage(page_id_t page_id, bool is_dirty) override;
+
+  bool FlushPage(page_id_t page_id) override;
+
+  void FlushAllPages() override;
+
+  Page *NewPage(page_id_t &page_id,
+                BufferAccessStrategy *strategy = nullptr) override;
+
+  bool DeletePage(page_id_t page_id) override;
+
+  bool UnpinFrame(Page *page, bool is_dirty) override;
+
+  size_t CheckPinLeaks() override;
+
+  void RunCleanerThread(size_t low_watermark, size_t high_watermark,
+                        size_t max_pages_per_sec = 0) override;
+  void StopCleanerThread() override;
+
+  size_t PrefetchPages(page_id_t first_page_id, size_t count) override;
+
+  void Resize(size_t new_pool_size) override;
+  ResizeProgress GetResizeProgress() override;
+  size_t GetPoolSize() override;
+
+  BufferPoolStats GetStats() override;
+
+  std::vector<std::pair<page_id_t, lsn_t>> GetDirtyPageTable() override;
+
+  // see WarmRestoreLoop()
+  void WaitForWarmRestore() override;
+
+private:
+  enum Stat {
+    HITS = 0,
+    MISSES,
+    EVICTIONS,
+    WRITE_BACKS,
+    LATCH_WAITS,
+    LATCH_WAIT_NS,
+    RING_REUSES,
+    NUM_STATS
+  };
+
+  // lock latch_, counting contention
+  std::unique_lock<std::mutex> AcquireLatch();
+  // frames are allocated in chunks, one per growth of the pool
+  struct FrameChunk {
+    Page *pages;
+    char *data; // content of the pages, page_size_ bytes each, see
+                // AllocateFrameData()
+    size_t size;
+  };
+
+  // allocate count more frames and put them into free list
+  void AddFrames(size_t count);
+  // release the frames with frame id >= new_pool_size
+  void ShrinkPool(size_t new_pool_size, std::unique_lock<std::mutex> &lck);
+  // empty a frame given up by ShrinkPool(), false if it must be retried
+  bool ReleaseFrame(Page *ptr, std::unique_lock<std::mutex> &lck);
+  // drop one pin of ptr, NOTE: caller must hold latch_
+  bool Unpin(Page *ptr, bool is_dirty);
+  // the last pin of a frame is gone
+  void MakeEvictable(Page *ptr);
+  // create a page whose id is already allocated by the caller
+  Page *NewPageWithId(page_id_t page_id,
+                      BufferAccessStrategy *strategy = nullptr);
+  // pick a frame from the ring of strategy first, then from free list, then
+  // from replacer
+  Page *GetVictimPage(BufferAccessStrategy *strategy = nullptr);
+  // next frame of the ring of strategy, if it can be reused
+  Page *GetRingFrame(BufferAccessStrategy *strategy, bool clean_only = false);
+  // map a victim frame to a new page, writing back its old content
+  void InstallNewPage(Page *ptr, page_id_t page_id,
+                      std::unique_lock<std::mutex> &lck);
+  // wait until page_id is neither being read in nor written back
+  void WaitForIO(page_id_t page_id, std::unique_lock<std::mutex> &lck);
+  // lsn the log must be flushed to before ptr is written, INVALID_LSN if none
+  lsn_t GetWriteLSN(Page *ptr);
+  // write-ahead rule: flush the log up to lsn, latch_ must not be held
+  void FlushLogTo(lsn_t lsn);
+  // body of the cleaner thread
+  void CleanerLoop();
+  // next dirty page the cleaner should write, nullptr if none
+  Page *GetPageToClean();
+  // body of the prefetch thread
+  void PrefetchLoop();
+  // frame to read a prefetched page into, nullptr if that would evict a
+  // dirty page
+  Page *GetPrefetchFrame();
+  // pages in replacer order, pinned pages last
+  void CollectWarmPages(std::vector<page_id_t> &page_ids) override;
+  size_t StartWarmRestore(std::vector<page_id_t> &page_ids) override;
+  // body of the restore thread
+  void WarmRestoreLoop(std::vector<page_id_t> page_ids);
+
+  size_t pool_size_; // number of pages in buffer pool
+  std::vector<FrameChunk> chunks_;
+  // all the frames by frame id, those >= pool_size_ are released or being
+  // released by Resize()
+  std::vector<Page *> frames_;
+  DiskManager *disk_manager_;
+  LogManager *log_manager_;
+  // to keep track of pages, rebuilt when the pool outgrows it
+  LinearProbeHashTable<page_id_t, Page *> *page_table_;
+  Replacer<Page *> *replacer_;   // to find an unpinned page for replacement
+  std::list<Page *> *free_list_; // to find a free page for replacement
+  std::mutex latch_;             // to protect shared data structure
+  // pages whose disk I/O is in progress with latch_ released
+  std::unordered_set<page_id_t> in_flight_;
+  std::condition_variable io_cv_; // notified when an in-flight I/O is done
+  // background cleaner, configuration is protected by latch_
+  std::thread *cleaner_thread_;
+  bool cleaner_running_;
+  bool cleaning_; // between falling below low and reaching high watermark
+  size_t low_watermark_;
+  size_t high_watermark_;
+  size_t max_pages_per_sec_;
+  std::condition_variable cleaner_cv_;
+  // readahead, started by the first PrefetchPages() call
+  std::thread *prefetch_thread_;
+  bool prefetch_running_;
+  std::deque<page_id_t> prefetch_queue_;
+  std::condition_variable prefetch_cv_;
+  // Resize() holds resize_latch_ throughout, resize_progress_ is protected
+  // by latch_
+  std::mutex resize_latch_;
+  ResizeProgress resize_progress_;
+  // warm restore, at most one at a time
+  std::thread *restore_thread_;
+  bool restore_running_;
+  StatCounters<NUM_STATS> stats_;
+};
+} // namespace scudb
@@ -0,0 +1,59 @@
+/**
+ * clock_replacer.h
+ *
+ * Functionality: CLOCK (second chance) approximation of LRU. Every frame owns
+ * a fixed slot holding an evictable bit and a reference bit. Insert/Erase only
+ * flip those bits with atomic operations, no allocation and no mutex. Only
+ * the clock hand sweeping for a victim is protected by the replacer latch.
+ */
+
+#pragma once
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "buffer/replacer.h"
+
+namespace scudb {
+
+template <typename T> class ClockReplacer : public Replacer<T> {
+public:
+  // frame_of maps a value to its slot, which must be < num_frames
+  ClockReplacer(size_t num_frames, std::function<size_t(const T &)> frame_of);
+
+  ~ClockReplacer();
+
+  void Insert(const T &value);
+
+  bool Victim(T &value);
+
+  bool Erase(const T &value);
+
+  size_t Size();
+
+  size_t PeekVictims(std::vector<T> &values, size_t count);
+
+  // slots of frames that are kept keep their bits, dropped frames must not
+  // be evictable. NOTE: must not run concurrently with other calls
+  void Resize(size_t num_frames);
+
+private:
+  static const uint8_t EVICTABLE = 0x1;
+  static const uint8_t REFERENCED = 0x2;
+
+  size_t num_frames_;
+  std::function<size_t(const T &)> frame_of_;
+  // per frame evictable & reference bits
+  std::unique_ptr<std::atomic<uint8_t>[]> states_;
+  // per frame value, written before the frame becomes evictable
+  std::vector<T> values_;
+  // number of evictable frames
+  std::atomic<size_t> size_;
+  // position of the clock hand, protected by latch
+  size_t hand_;
+  std::mutex latch;
+};
+
+} // namespace scudb
@@ -0,0 +1,69 @@
+/**
+ * lru_k_replacer.h
+ *
+ * Functionality: LRU-K replacement (O'Neil et al.). The victim is the
+ * evictable frame whose K-th most recent reference is the oldest, frames with
+ * less than K references are considered infinitely old and are evicted first,
+ * in order of their first reference. So a page touched once by a sequential
+ * scan can not push out pages that are referenced over and over.
+ *
+ * References are counted on Insert (i.e. when the buffer pool unpins a
+ * frame). Time is a logical clock advanced by every Insert, references of the
+ * same frame closer than the correlated reference period are collapsed into
+ * one. Erase (the frame gets pinned) keeps the reference history, which is
+ * dropped when the frame is chosen as victim, or by Remove when the buffer
+ * pool gives the frame to another page without asking for a victim.
+ */
+
+#pragma once
+#include <deque>
+#include <mutex>
+#include <set>
+#include <tuple>
+#include <unordered_map>
+
+#include "buffer/replacer.h"
+
+namespace scudb {
+
+template <typename T> class LRUKReplacer : public Replacer<T> {
+public:
+  LRUKReplacer(size_t k = 2, size_t correlated_period = 0);
+
+  ~LRUKReplacer();
+
+  void Insert(const T &value);
+
+  bool Victim(T &value);
+
+  bool Erase(const T &value);
+
+  void Remove(const T &value);
+
+  size_t Size();
+
+  size_t PeekVictims(std::vector<T> &values, size_t count);
+
+private:
+  // (has K references, K-th most recent or oldest reference, value)
+  typedef std::tuple<bool, size_t, T> key_t;
+
+  struct frame_info {
+    // reference timestamps, most recent first, at most K of them
+    std::deque<size_t> history;
+    bool evictable = false;
+    key_t key;
+  };
+
+  key_t MakeKey(const T &value, const frame_info &info) const;
+
+  size_t k_;
+  size_t correlated_period_;
+  size_t current_timestamp_;
+  std::unordered_map<T, frame_info> frames_;
+  // evictable frames, the first one is the victim
+  std::set<key_t> evictable_;
+  mutable std::mutex latch;
+};
+
+} // namespace scudb
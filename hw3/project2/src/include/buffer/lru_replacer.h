@@ -29,6 +29,8 @@ public:
 
   size_t Size();
 
+  size_t PeekVictims(std::vector<T> &values, size_t count);
+
 private:
   // add your member variables here
   struct node
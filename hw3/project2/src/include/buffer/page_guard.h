@@ -0,0 +1,108 @@
+/**
+ * page_guard.h
+ *
+ * RAII handles of a pinned page. A guard keeps the frame it was given, so
+ * releasing it unpins that frame directly instead of looking the page id up
+ * in page table again, and releases it on every path out of a scope,
+ * exceptions included.
+ * BasicPageGuard only holds the pin, for callers that have the page latched
+ * otherwise. ReadPageGuard and WritePageGuard also hold the read or write
+ * latch of the page. A write guard remembers whether the page was changed,
+ * GetDataMut() and AsMut() mark it dirty.
+ * Guards are movable, not copyable. Drop() releases a guard early, it is
+ * empty afterwards.
+ */
+
+#pragma once
+
+#include "page/page.h"
+
+namespace scudb {
+
+class BufferPoolManager;
+
+class BasicPageGuard {
+public:
+  BasicPageGuard() = default;
+  // page is pinned on behalf of the guard
+  BasicPageGuard(BufferPoolManager *buffer_pool_manager, Page *page);
+  BasicPageGuard(const BasicPageGuard &) = delete;
+  BasicPageGuard &operator=(const BasicPageGuard &) = delete;
+  BasicPageGuard(BasicPageGuard &&that) noexcept;
+  BasicPageGuard &operator=(BasicPageGuard &&that) noexcept;
+  ~BasicPageGuard() { Drop(); }
+
+  // unpin the page
+  void Drop();
+
+  inline explicit operator bool() const { return page_ != nullptr; }
+  inline Page *GetPage() { return page_; }
+  inline page_id_t GetPageId() { return page_->GetPageId(); }
+  inline const char *GetData() { return page_->GetData(); }
+  inline char *GetDataMut() {
+    is_dirty_ = true;
+    return page_->GetData();
+  }
+  inline void MarkDirty() { is_dirty_ = true; }
+  // view the content of the page as T
+  template <typename T> inline const T *As() {
+    return reinterpret_cast<const T *>(GetData());
+  }
+  template <typename T> inline T *AsMut() {
+    return reinterpret_cast<T *>(GetDataMut());
+  }
+
+private:
+  BufferPoolManager *buffer_pool_manager_ = nullptr;
+  Page *page_ = nullptr;
+  bool is_dirty_ = false;
+};
+
+class ReadPageGuard {
+public:
+  ReadPageGuard() = default;
+  // page is pinned and read latched on behalf of the guard
+  ReadPageGuard(BufferPoolManager *buffer_pool_manager, Page *page);
+  ReadPageGuard(ReadPageGuard &&that) noexcept = default;
+  ReadPageGuard &operator=(ReadPageGuard &&that) noexcept;
+  ~ReadPageGuard() { Drop(); }
+
+  // unlatch and unpin the page
+  void Drop();
+
+  inline explicit operator bool() const { return bool(guard_); }
+  inline Page *GetPage() { return guard_.GetPage(); }
+  inline page_id_t GetPageId() { return guard_.GetPageId(); }
+  inline const char *GetData() { return guard_.GetData(); }
+  template <typename T> inline const T *As() { return guard_.As<T>(); }
+
+private:
+  BasicPageGuard guard_;
+};
+
+class WritePageGuard {
+public:
+  WritePageGuard() = default;
+  // page is pinned and write latched on behalf of the guard
+  WritePageGuard(BufferPoolManager *buffer_pool_manager, Page *page);
+  WritePageGuard(WritePageGuard &&that) noexcept = default;
+  WritePageGuard &operator=(WritePageGuard &&that) noexcept;
+  ~WritePageGuard() { Drop(); }
+
+  // unlatch and unpin the page, dirty if it was changed
+  void Drop();
+
+  inline explicit operator bool() const { return bool(guard_); }
+  inline Page *GetPage() { return guard_.GetPage(); }
+  inline page_id_t GetPageId() { return guard_.GetPageId(); }
+  inline const char *GetData() { return guard_.GetData(); }
+  inline char *GetDataMut() { return guard_.GetDataMut(); }
+  inline void MarkDirty() { guard_.MarkDirty(); }
+  template <typename T> inline const T *As() { return guard_.As<T>(); }
+  template <typename T> inline T *AsMut() { return guard_.AsMut<T>(); }
+
+private:
+  BasicPageGuard guard_;
+};
+
+} // namespace scudb
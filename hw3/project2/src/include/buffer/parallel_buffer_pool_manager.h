@@ -0,0 +1,89 @@
+/*
+ * parallel_buffer_pool_manager.h
+ *
+ * Functionality: Partitioned buffer pool. Page ids are hashed to one of N
+ * independent BufferPoolManagerInstance, each with its own frames, page
+ * table, replacer, free list and latch, so that threads working on different
+ * pages do not serialize on a single latch.
+ * Callers keep using the BufferPoolManager interface.
+ */
+
+#pragma once
+#include <atomic>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+
+namespace scudb {
+class ParallelBufferPoolManager : public BufferPoolManager {
+public:
+  // pool_size is the total number of frames, split evenly among instances
+  ParallelBufferPoolManager(size_t num_instances, size_t pool_size,
+                            DiskManager *disk_manager,
+                            LogManager *log_manager = nullptr,
+                            ReplacerType replacer_type = ReplacerType::LRU);
+
+  ~ParallelBufferPoolManager();
+
+  Page *FetchPage(page_id_t page_id,
+                  BufferAccessStrategy *strategy = nullptr) override;
+
+  bool UnpinPage(page_id_t page_id, bool is_dirty) override;
+
+  bool UnpinFrame(Page *page, bool is_dirty) override;
+
+  size_t CheckPinLeaks() override;
+
+  bool FlushPage(page_id_t page_id) override;
+
+  void FlushAllPages() override;
+
+  Page *NewPage(page_id_t &page_id,
+                BufferAccessStrategy *strategy = nullptr) override;
+
+  bool DeletePage(page_id_t page_id) override;
+
+  // every instance runs its own cleaner, with its share of the watermarks
+  // and of the rate limit
+  void RunCleanerThread(size_t low_watermark, size_t high_watermark,
+                        size_t max_pages_per_sec = 0) override;
+
+  void StopCleanerThread() override;
+
+  // consecutive page ids belong to different instances, each page is queued
+  // at its own instance
+  size_t PrefetchPages(page_id_t first_page_id, size_t count) override;
+
+  // instances are resized one after another, each to its share
+  void Resize(size_t new_pool_size) override;
+
+  ResizeProgress GetResizeProgress() override;
+
+  size_t GetPoolSize() override;
+
+  // counters and gauges summed over the instances
+  BufferPoolStats GetStats() override;
+
+  // the tables of the instances one after another
+  std::vector<std::pair<page_id_t, lsn_t>> GetDirtyPageTable() override;
+
+  void WaitForWarmRestore() override;
+
+  inline size_t GetNumInstances() const { return instances_.size(); }
+
+private:
+  // the pages of every instance one after another, so that each instance
+  // finds its own pages of a dump in its replacer order
+  void CollectWarmPages(std::vector<page_id_t> &page_ids) override;
+  // every instance restores its own pages
+  size_t StartWarmRestore(std::vector<page_id_t> &page_ids) override;
+
+  // the instance responsible for page_id
+  inline BufferPoolManagerInstance *GetInstance(page_id_t page_id) {
+    return instances_[static_cast<size_t>(page_id) % instances_.size()];
+  }
+
+  DiskManager *disk_manager_;
+  std::vector<BufferPoolManagerInstance *> instances_;
+};
+} // namespace scudb
@@ -0,0 +1,33 @@
+/**
+ * readahead.h
+ *
+ * Adaptive readahead for scans. A scan reports every move from one page to
+ * the next; as long as it keeps moving to the following page id, the pages
+ * ahead of it are prefetched into buffer pool. The window starts at
+ * READAHEAD_MIN_PAGES and doubles each time the scan consumes half of it, up
+ * to READAHEAD_MAX_PAGES. Any other move resets it.
+ */
+
+#pragma once
+
+#include "buffer/buffer_pool_manager.h"
+
+namespace scudb {
+
+class Readahead {
+public:
+  Readahead(BufferPoolManager *buffer_pool_manager);
+
+  // the scan is leaving prev_page_id for page_id, call before fetching it
+  void Advance(page_id_t prev_page_id, page_id_t page_id);
+
+  inline size_t GetWindow() const { return window_; }
+
+private:
+  BufferPoolManager *buffer_pool_manager_;
+  size_t window_; // 0 while access is not sequential
+  // pages before it have been requested already
+  page_id_t prefetched_until_;
+};
+
+} // namespace scudb
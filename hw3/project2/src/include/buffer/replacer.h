@@ -6,9 +6,13 @@
 #pragma once
 
 #include <cstdlib>
+#include <vector>
 
 namespace scudb {
 
+// replacement policy used by buffer pool manager
+enum class ReplacerType { LRU = 0, CLOCK, LRU_K };
+
 template <typename T> class Replacer {
 public:
   Replacer() {}
@@ -17,6 +21,15 @@ public:
   virtual bool Victim(T &value) = 0;
   virtual bool Erase(const T &value) = 0;
   virtual size_t Size() = 0;
+  // append up to count values in the order they would be chosen as victim,
+  // without removing them. return the number of values appended
+  virtual size_t PeekVictims(std::vector<T> &values, size_t count) = 0;
+  // the buffer pool now has num_frames frames, only replacers keeping per
+  // frame state care
+  virtual void Resize(size_t num_frames) {}
+  // like Erase, and the frame of value is about to hold another page, only
+  // replacers keeping a reference history care
+  virtual void Remove(const T &value) { Erase(value); }
 };
 
 } // namespace scudb
@@ -14,17 +14,44 @@ namespace scudb {
 
 extern std::chrono::duration<long long int> LOG_TIMEOUT;
 
+extern std::chrono::milliseconds CLEANER_TIMEOUT;
+
+extern std::chrono::milliseconds SYNC_INTERVAL;
+
+extern std::chrono::milliseconds WARM_STATE_INTERVAL;
+
 extern std::atomic<bool> ENABLE_LOGGING;
 
+// an async commit is written by the flush thread within this lag
+extern std::chrono::milliseconds ASYNC_COMMIT_LAG;
+
 #define INVALID_PAGE_ID -1 // representing an invalid page id
 #define INVALID_TXN_ID -1  // representing an invalid txn id
 #define INVALID_LSN -1     // representing an invalid lsn
 #define HEADER_PAGE_ID 0   // the header page id
-#define PAGE_SIZE 512     // size of a data page in byte
-#define LOG_BUFFER_SIZE                                                            \
-  ((BUFFER_POOL_SIZE + 1) * PAGE_SIZE) // size of a log buffer in byte
+// page size is chosen when a db file is created and kept in its header
+#define MIN_PAGE_SIZE 4096      // smallest page size in byte
+#define MAX_PAGE_SIZE 65536     // largest page size in byte
+#define DEFAULT_PAGE_SIZE 4096  // page size of a db created by default
+#define TEST_PAGE_SIZE 512      // only for tests, small trees split early
+#define LOG_BUFFER_PAGES (BUFFER_POOL_SIZE + 1) // size of a log buffer in pages
+#define LOG_READ_PAGES 256  // recovery reads the log this many pages at a time
+#define RECOVERY_WORKERS 4  // threads replaying the log in parallel on redo
 #define BUCKET_SIZE 50                 // size of extendible hash bucket
-#define BUFFER_POOL_SIZE 10            // size of buffer pool
+#define BUFFER_POOL_SIZE 10            // default size of buffer pool
+#define LRUK_REPLACER_K 2              // K of LRU-K replacer
+// re-references of a frame within this many replacer accesses count as one
+#define LRUK_CORRELATED_PERIOD 16
+#define READAHEAD_MIN_PAGES 4  // first readahead window of a sequential scan
+#define READAHEAD_MAX_PAGES 32 // readahead window stops doubling here
+#define ASYNC_IO_QUEUE_DEPTH 64 // requests in flight in DiskManager async I/O
+#define CLEANER_BATCH_SIZE 16   // pages written by the cleaner in one batch
+#define WARM_RESTORE_BATCH_SIZE 64 // pages read together by a warm restore
+#define BULK_READ_RING_SIZE 32  // frames of a BufferAccessStrategy for scans
+#define BULK_WRITE_RING_SIZE 64 // frames of a BufferAccessStrategy for loads
+#define DIRECT_IO_ALIGNMENT 4096 // memory alignment of buffers under O_DIRECT
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024) // frame memory is aligned to it
+#define STAT_SHARDS 16 // statistics counters are spread over this many shards
 
 typedef int32_t page_id_t; // page id type
 typedef int32_t txn_id_t;  // transaction id type
@@ -0,0 +1,101 @@
+/**
+ * rwlatch.h
+ *
+ * Reader-Writer latch in one 64 bit word, meant to be embedded in every page.
+ * Readers and writers get in with a single compare-and-swap when there is no
+ * conflict. A thread that cannot get in spins for a while, then parks on a
+ * mutex/condvar pair shared by all latches hashing to the same bucket, so
+ * the latch itself stays 8 bytes.
+ * Writer preferring: once a writer waits, new readers wait behind it.
+ * A reader may upgrade to writer. Only one reader can wait for that at a
+ * time, Upgrade() returns false to any other one, which then has to release
+ * its read latch and start over to avoid a deadlock.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace scudb {
+class RWLatch {
+public:
+  RWLatch() : state_(0) {}
+
+  RWLatch(const RWLatch &) = delete;
+  RWLatch &operator=(const RWLatch &) = delete;
+
+  inline void WLock() {
+    uint64_t expected = 0;
+    if (!state_.compare_exchange_weak(expected, WRITER,
+                                      std::memory_order_acquire)) {
+      WLockSlow();
+    }
+  }
+
+  inline bool TryWLock() {
+    uint64_t state = state_.load(std::memory_order_relaxed);
+    return (state & (WRITER | UPGRADING | READERS)) == 0 &&
+           state_.compare_exchange_strong(
+               state, (state & ~WRITER_WAITING) | WRITER,
+               std::memory_order_acquire);
+  }
+
+  inline void WUnlock() {
+    uint64_t state = state_.fetch_and(~WRITER, std::memory_order_release);
+    if (state & PARKED) {
+      Unpark();
+    }
+  }
+
+  inline void RLock() {
+    if (!TryRLock()) {
+      RLockSlow();
+    }
+  }
+
+  inline bool TryRLock() {
+    uint64_t state = state_.load(std::memory_order_relaxed);
+    return (state & (WRITER | WRITER_WAITING | UPGRADING)) == 0 &&
+           state_.compare_exchange_strong(state, state + READER,
+                                          std::memory_order_acquire);
+  }
+
+  inline void RUnlock() {
+    uint64_t state =
+        state_.fetch_sub(READER, std::memory_order_release) - READER;
+    // the last reader lets a writer in, the last but one an upgrader
+    if ((state & PARKED) &&
+        ((state & READERS) == 0 ||
+         ((state & UPGRADING) && (state & READERS) == READER))) {
+      Unpark();
+    }
+  }
+
+  // turn the read latch held into the write latch, if no other reader holds
+  // it
+  bool TryUpgrade();
+  // wait for the other readers to leave, false if another reader is
+  // upgrading already, the read latch is still held then
+  bool Upgrade();
+  // turn the write latch held into a read latch, nobody gets in between
+  void Downgrade();
+
+private:
+  static const uint64_t WRITER = 0x1;
+  static const uint64_t WRITER_WAITING = 0x2;
+  static const uint64_t UPGRADING = 0x4; // a reader waits to become writer
+  static const uint64_t PARKED = 0x8;    // some thread sleeps on the latch
+  static const uint64_t READER = 0x10;   // readers count from here up
+  static const uint64_t READERS = ~(READER - 1);
+
+  void WLockSlow();
+  void RLockSlow();
+  // spin, then park until blocked(state) is false, the caller retries
+  template <typename Blocked> void Wait(Blocked blocked);
+  // wake every thread parked on this latch
+  void Unpark();
+
+  std::atomic<uint64_t> state_;
+};
+} // namespace scudb
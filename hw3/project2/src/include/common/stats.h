@@ -0,0 +1,85 @@
+/**
+ * stats.h
+ *
+ * Functionality: Statistics cheap enough for hot paths. Counters are
+ * sharded, a thread only adds to the shard it was given, so threads do not
+ * fight over a cache line. Shards are summed when counters are read, the sum
+ * is not a consistent snapshot of all the counters.
+ * Latencies are kept as histograms with power of 2 microsecond buckets, built
+ * on the same counters.
+ */
+
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include "common/config.h"
+
+namespace scudb {
+
+// shard of the calling thread, threads are given shards round robin
+inline size_t GetStatShard() {
+  static std::atomic<size_t> next_shard(0);
+  thread_local size_t shard = next_shard.fetch_add(1) % STAT_SHARDS;
+  return shard;
+}
+
+template <size_t N> class StatCounters {
+public:
+  StatCounters() {
+    for (auto &shard : shards_) {
+      for (auto &value : shard.values) {
+        value.store(0);
+      }
+    }
+  }
+
+  inline void Add(size_t counter, uint64_t delta = 1) {
+    shards_[GetStatShard()].values[counter].fetch_add(
+        delta, std::memory_order_relaxed);
+  }
+
+  uint64_t Get(size_t counter) const {
+    uint64_t sum = 0;
+    for (auto &shard : shards_) {
+      sum += shard.values[counter].load(std::memory_order_relaxed);
+    }
+    return sum;
+  }
+
+private:
+  struct Shard {
+    std::atomic<uint64_t> values[N];
+    char padding[64]; // keeps the next shard off our cache lines
+  };
+  Shard shards_[STAT_SHARDS];
+};
+
+// snapshot of a LatencyRecorder
+struct LatencyHistogram {
+  static const size_t NUM_BUCKETS = 24;
+  // bucket 0 counts latencies below 1us, bucket i those in [2^(i-1), 2^i)
+  // us, the last bucket everything above
+  uint64_t buckets[NUM_BUCKETS] = {};
+  uint64_t count = 0;
+  uint64_t total_us = 0;
+
+  // upper bound in us of the bucket holding the p-th quantile, 0 < p <= 1
+  uint64_t Percentile(double p) const;
+  // count, average and a few percentiles on one line
+  std::string ToString() const;
+};
+
+class LatencyRecorder {
+public:
+  void Record(std::chrono::steady_clock::duration latency);
+  LatencyHistogram GetHistogram() const;
+
+private:
+  // buckets, then count and total
+  StatCounters<LatencyHistogram::NUM_BUCKETS + 2> counters_;
+};
+
+} // namespace scudb
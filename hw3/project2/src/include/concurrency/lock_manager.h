@@ -38,7 +38,30 @@ public:
   /*** END OF APIs ***/
 
 private:
+  // a granted or waiting request of one transaction
+  struct Request {
+    txn_id_t txn_id;
+    bool exclusive;
+  };
+  // requests on one rid in arrival order, the granted ones first
+  struct RequestQueue {
+    std::list<Request> requests;
+    std::condition_variable cv;
+    bool upgrading = false;
+  };
+
+  // queue the request, die if an older transaction holds or waits for a
+  // conflicting lock, otherwise wait until it is granted
+  bool Lock(Transaction *txn, const RID &rid, bool exclusive);
+  // whether the request of txn_id is compatible with every request ahead
+  // of it
+  bool IsGrantable(RequestQueue &queue, txn_id_t txn_id);
+  // abort txn and return false
+  bool Die(Transaction *txn);
+
   bool strict_2PL_;
+  std::mutex latch_;
+  std::unordered_map<RID, RequestQueue> lock_table_;
 };
 
 } // namespace scudb
@@ -31,6 +31,7 @@ enum class TransactionState { GROWING, SHRINKING, COMMITTED, ABORTED };
 enum class WType { INSERT = 0, DELETE, UPDATE };
 
 class TableHeap;
+class BufferAccessStrategy;
 
 // write set record
 class WriteRecord {
@@ -52,7 +53,9 @@ public:
   Transaction(txn_id_t txn_id)
       : state_(TransactionState::GROWING),
         thread_id_(std::this_thread::get_id()),
-        txn_id_(txn_id), prev_lsn_(INVALID_LSN), shared_lock_set_{new std::unordered_set<RID>},
+        txn_id_(txn_id), prev_lsn_(INVALID_LSN), async_commit_(false),
+        strategy_(nullptr),
+        shared_lock_set_{new std::unordered_set<RID>},
         exclusive_lock_set_{new std::unordered_set<RID>} {
     // initialize sets
     write_set_.reset(new std::deque<WriteRecord>);
@@ -101,6 +104,22 @@ public:
 
   inline void SetPrevLSN(lsn_t prev_lsn) { prev_lsn_ = prev_lsn; }
 
+  // commit returns without waiting for the commit record to be written, the
+  // transaction may be lost on a crash within ASYNC_COMMIT_LAG
+  inline bool IsAsyncCommit() { return async_commit_; }
+
+  inline void SetAsyncCommit(bool async_commit) {
+    async_commit_ = async_commit;
+  }
+
+  // pages of the transaction go through this ring, nullptr for the whole
+  // pool. the strategy is not owned by the transaction
+  inline BufferAccessStrategy *GetBufferAccessStrategy() { return strategy_; }
+
+  inline void SetBufferAccessStrategy(BufferAccessStrategy *strategy) {
+    strategy_ = strategy;
+  }
+
 private:
   TransactionState state_;
   // thread id, single-threaded transactions
@@ -109,8 +128,10 @@ private:
   txn_id_t txn_id_;
   // Below are used by transaction, undo set
   std::shared_ptr<std::deque<WriteRecord>> write_set_;
-  // prev lsn
-  lsn_t prev_lsn_;
+  // prev lsn, also read by a checkpoint
+  std::atomic<lsn_t> prev_lsn_;
+  bool async_commit_;
+  BufferAccessStrategy *strategy_;
 
   // Below are used by concurrent index
   // this deque contains page pointer that was latche during index operation
@@ -5,7 +5,10 @@
 
 #pragma once
 #include <atomic>
+#include <mutex>
+#include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include "common/config.h"
 #include "concurrency/lock_manager.h"
@@ -14,18 +17,35 @@
 namespace scudb {
 class TransactionManager {
 public:
+  // async_commit: default commit mode of the transactions begun here
   TransactionManager(LockManager *lock_manager,
-                           LogManager *log_manager = nullptr)
+                           LogManager *log_manager = nullptr,
+                           bool async_commit = false)
       : next_txn_id_(0), lock_manager_(lock_manager),
-        log_manager_(log_manager) {}
+        log_manager_(log_manager), async_commit_(async_commit) {}
   Transaction *Begin();
   void Commit(Transaction *txn);
   void Abort(Transaction *txn);
 
+  // log the begin record of a checkpoint and return its lsn, with the last
+  // lsn of every active transaction and the oldest lsn one of them began at
+  // (INVALID_LSN if none is active). transactions can not begin or end
+  // in between. only while logging
+  lsn_t BeginCheckpoint(std::vector<std::pair<txn_id_t, lsn_t>> &active_txns,
+                        lsn_t &oldest_begin_lsn);
+
 private:
+  // the record ends txn, it is no longer active
+  void AppendEndRecord(Transaction *txn, LogRecordType log_record_type);
+
   std::atomic<txn_id_t> next_txn_id_;
   LockManager *lock_manager_;
   LogManager *log_manager_;
+  bool async_commit_;
+  // active transactions with the lsn of their begin record, kept while
+  // logging. protected by latch_
+  std::unordered_map<txn_id_t, std::pair<Transaction *, lsn_t>> active_txns_;
+  std::mutex latch_;
 };
 
 } // namespace scudb
@@ -0,0 +1,126 @@
+/**
+ * async_io.h
+ *
+ * Asynchronous positional file I/O used by DiskManager. A request is
+ * submitted with a completion callback, which receives the number of bytes
+ * transferred or -errno. Two engines are provided:
+ * IOUringIO submits requests through an io_uring. Requests from several
+ * threads are batched into one io_uring_enter() when they arrive together,
+ * and a reaper thread runs the callbacks.
+ * ThreadPoolIO does blocking pread/pwrite on a small pool of worker threads,
+ * used when io_uring is not compiled in or not allowed by the kernel.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define SCUDB_HAVE_IO_URING 1
+#endif
+#endif
+
+namespace scudb {
+
+enum class AsyncIOType { THREAD_POOL = 0, IO_URING };
+
+class AsyncIO {
+public:
+  typedef std::function<void(ssize_t)> Callback;
+
+  virtual ~AsyncIO() {}
+
+  // read/write len bytes at offset of fd, done is called once with the
+  // result of the transfer, from a thread of the engine
+  virtual void Read(int fd, char *buf, size_t len, off_t offset,
+                    Callback done) = 0;
+  virtual void Write(int fd, const char *buf, size_t len, off_t offset,
+                     Callback done) = 0;
+
+  // io_uring if asked for and available, thread pool otherwise
+  static AsyncIO *Create(AsyncIOType type, size_t queue_depth);
+};
+
+class ThreadPoolIO : public AsyncIO {
+public:
+  ThreadPoolIO(size_t num_threads);
+  // waits for submitted requests
+  ~ThreadPoolIO();
+
+  void Read(int fd, char *buf, size_t len, off_t offset,
+            Callback done) override;
+  void Write(int fd, const char *buf, size_t len, off_t offset,
+             Callback done) override;
+
+private:
+  void WorkerLoop();
+
+  std::vector<std::thread> workers_;
+  std::deque<std::function<void()>> queue_;
+  bool running_;
+  std::mutex latch_;
+  std::condition_variable cv_;
+};
+
+#ifdef SCUDB_HAVE_IO_URING
+class IOUringIO : public AsyncIO {
+public:
+  // returns nullptr if the ring can not be set up
+  static IOUringIO *Create(size_t queue_depth);
+  // waits for submitted requests
+  ~IOUringIO();
+
+  void Read(int fd, char *buf, size_t len, off_t offset,
+            Callback done) override;
+  void Write(int fd, const char *buf, size_t len, off_t offset,
+             Callback done) override;
+
+private:
+  struct Request {
+    struct iovec iov;
+    Callback done;
+  };
+
+  IOUringIO();
+  bool Setup(size_t queue_depth);
+  // put one sqe in the ring and submit all pending ones, request nullptr is
+  // a nop
+  void Submit(int opcode, int fd, Request *request, off_t offset);
+  void ReaperLoop();
+
+  int ring_fd_;
+  // mmapped rings
+  void *sq_ptr_;
+  size_t sq_size_;
+  void *cq_ptr_;
+  size_t cq_size_;
+  void *sqes_ptr_;
+  size_t sqes_size_;
+  unsigned *sq_head_;
+  unsigned *sq_tail_;
+  unsigned *sq_mask_;
+  unsigned *sq_array_;
+  unsigned *cq_head_;
+  unsigned *cq_tail_;
+  unsigned *cq_mask_;
+  void *cqes_;
+  unsigned sq_entries_;
+  // sqes in flight, bounded by sq_entries_ so that cq never overflows
+  unsigned in_flight_;
+  bool running_;
+  std::mutex latch_; // protects sq tail and in_flight_
+  std::condition_variable cv_;
+  std::thread *reaper_thread_;
+};
+#endif
+
+} // namespace scudb
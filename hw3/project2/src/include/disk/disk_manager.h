@@ -9,45 +9,145 @@
 
 #pragma once
 #include <atomic>
+#include <condition_variable>
 #include <fstream>
 #include <future>
+#include <mutex>
 #include <string>
+#include <sys/types.h>
+#include <thread>
+#include <utility>
+#include <vector>
 
 #include "common/config.h"
+#include "common/stats.h"
+#include "disk/async_io.h"
 
 namespace scudb {
 
+// when written data is made durable with fdatasync(). WritePage() alone never
+// syncs, under WAL a page only has to be durable once its log is truncated,
+// which Sync() takes care of
+enum class SyncPolicy {
+  PER_COMMIT = 0, // log at every WriteLog(), db file at Sync()
+  PER_BATCH,      // same, and db file after every WritePages() batch
+  PERIODIC        // both files every SYNC_INTERVAL, by a background thread
+};
+
 class DiskManager {
 public:
-  DiskManager(const std::string &db_file);
+  // page_size only matters when the db file is created, it is a power of 2
+  // from MIN_PAGE_SIZE to MAX_PAGE_SIZE, or TEST_PAGE_SIZE. with direct_io
+  // the db file bypasses the OS page cache (O_DIRECT) if the file system
+  // allows. an existing db file without a valid header throws Exception
+  DiskManager(const std::string &db_file, size_t page_size = DEFAULT_PAGE_SIZE,
+              AsyncIOType async_io_type = AsyncIOType::IO_URING,
+              bool direct_io = false);
   ~DiskManager();
 
   void WritePage(page_id_t page_id, const char *page_data);
   void ReadPage(page_id_t page_id, char *page_data);
+  // the future is ready once the page is transferred, through io_uring or a
+  // thread pool, see AsyncIO. under direct I/O page_data should be aligned
+  // to DIRECT_IO_ALIGNMENT, otherwise the transfer is synchronous
+  std::future<void> WritePageAsync(page_id_t page_id, const char *page_data);
+  std::future<void> ReadPageAsync(page_id_t page_id, char *page_data);
+  // write many pages at once, as vectored writes of adjacent page ids.
+  // pages are sorted in place
+  void WritePages(std::vector<std::pair<page_id_t, const char *>> &pages);
+  // fdatasync db file and log
+  void Sync();
+  void SetSyncPolicy(SyncPolicy policy);
+  inline SyncPolicy GetSyncPolicy() const { return sync_policy_; }
 
   void WriteLog(char *log_data, int size);
-  bool ReadLog(char *log_data, int size, int offset);
+  bool ReadLog(char *log_data, int size, off_t offset);
+  // give back the space of the log before offset, it reads as zeros
+  // afterwards. offsets of the rest of the log do not change
+  void TruncateLog(off_t offset);
+  inline off_t GetLogFileSize() const { return log_file_size_.load(); }
 
   page_id_t AllocatePage();
   void DeallocatePage(page_id_t page_id);
+  bool IsAllocated(page_id_t page_id);
+
+  // number of pages the db file can be read from
+  page_id_t GetNumPages();
+  inline size_t GetPageSize() const { return page_size_; }
+  inline bool IsDirectIO() const { return direct_io_; }
+  // number of pages tracked by one bitmap page
+  inline size_t GetPagesPerExtent() const { return pages_per_extent_; }
+
+  // latency of page reads and writes, a batch write counts once per
+  // vectored write, an async request from submission to completion
+  inline LatencyHistogram GetReadLatency() const {
+    return read_latency_.GetHistogram();
+  }
+  inline LatencyHistogram GetWriteLatency() const {
+    return write_latency_.GetHistogram();
+  }
 
   int GetNumFlushes() const;
+  int GetNumSyncs() const;
   bool GetFlushState() const;
   inline void SetFlushLogFuture(std::future<void> *f) { flush_log_f_ = f; }
   inline bool HasFlushLogFuture() { return flush_log_f_ != nullptr; }
 
 private:
-  int GetFileSize(const std::string &name);
-  // stream to write log file
-  std::fstream log_io_;
+  AsyncIO *GetAsyncIO();
+  void SyncLoop();
+  void SyncFile(int fd);
+  void FinishWrite(off_t offset, const char *page_data, size_t written);
+  void FinishRead(off_t offset, char *page_data, size_t read_count);
+  void EnableDirectIO();
+  // whether data has to be copied to an aligned buffer for I/O
+  inline bool NeedsBounce(const void *data) const {
+    return direct_io_ &&
+           reinterpret_cast<uintptr_t>(data) % DIRECT_IO_ALIGNMENT != 0;
+  }
+  off_t GetPageOffset(page_id_t page_id);
+  off_t GetBitmapOffset(size_t extent);
+  void WriteFileHeader();
+  void WriteBitmapPage(size_t extent);
+  void AddExtent();
+  bool LoadBitmap();
+  static bool IsValidPageSize(size_t page_size);
+  // log file, opened for append
+  int log_fd_;
   std::string log_name_;
-  // stream to write db file
-  std::fstream db_io_;
+  std::atomic<off_t> log_file_size_;
+  // db file is accessed with pread/pwrite, which do not share a cursor, so
+  // page I/O from several threads needs no latch
+  int db_fd_;
   std::string file_name_;
-  std::atomic<page_id_t> next_page_id_;
+  size_t page_size_;
+  size_t pages_per_extent_;
+  // all page I/O is aligned to page size and DIRECT_IO_ALIGNMENT
+  bool direct_io_;
+  // size of db file, kept in memory instead of asking the file system
+  std::atomic<off_t> db_file_size_;
+  // async I/O engine, created on first use
+  AsyncIOType async_io_type_;
+  AsyncIO *async_io_;
+  std::once_flag async_io_once_;
+  std::atomic<SyncPolicy> sync_policy_;
+  // periodic sync
+  std::thread *sync_thread_;
+  std::mutex sync_latch_;
+  std::condition_variable sync_cv_;
+  // page allocation. db file starts with a header page, followed by extents
+  // of a bitmap page and the pages_per_extent_ pages whose use it records
+  std::mutex alloc_latch_;
+  std::vector<char> bitmap_; // bitmap pages of all extents
+  size_t num_extents_;
+  size_t next_free_; // pages below it are all in use
+  LatencyRecorder read_latency_;
+  LatencyRecorder write_latency_;
   int num_flushes_;
+  std::atomic<int> num_syncs_;
   bool flush_log_;
   std::future<void> *flush_log_f_;
+  char *last_log_data_; // buffer of the previous WriteLog()
 };
 
 } // namespace scudb
\ No newline at end of file
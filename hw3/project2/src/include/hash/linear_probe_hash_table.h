@@ -0,0 +1,67 @@
+/*
+ * linear_probe_hash_table.h : fixed capacity hash table using open addressing
+ * with linear probing
+ *
+ * Functionality: Page table of the buffer pool. All the slots live in one
+ * array, a lookup walks neighbouring slots instead of chasing pointers.
+ * Find() takes no lock, every slot carries a version that readers check to
+ * get a consistent key/value pair. Insert() and Remove() are serialized by a
+ * mutex. Remove() shifts the following entries back instead of leaving a
+ * tombstone, a table-level counter lets a reader that missed during a shift
+ * retry.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+#include "hash/hash_table.h"
+
+namespace scudb {
+
+template <typename K, typename V>
+class LinearProbeHashTable : public HashTable<K, V> {
+  struct Slot {
+    // bit 0 is set while a writer changes key and value, bit 1 when the slot
+    // is occupied, the upper bits count the changes
+    std::atomic<uint32_t> meta;
+    std::atomic<K> key;
+    std::atomic<V> value;
+  };
+
+public:
+  // room for at least num_entries entries at a load factor of 0.5
+  LinearProbeHashTable(size_t num_entries);
+  // lookup and modifier
+  bool Find(const K &key, V &value) override;
+  bool Remove(const K &key) override;
+  // throws when every slot but one is used
+  void Insert(const K &key, const V &value) override;
+  inline size_t GetCapacity() const { return capacity_; }
+  size_t GetSize();
+
+private:
+  static const uint32_t BUSY = 0x1;
+  static const uint32_t FULL = 0x2;
+  static const uint32_t VERSION = 0x4;
+
+  // slot where probing for key starts
+  size_t Home(const K &key) const;
+  // consistent copy of a slot, false if it is empty
+  bool ReadSlot(size_t index, K &key, V &value) const;
+  // occupy a slot, NOTE: caller must hold latch_
+  void WriteSlot(size_t index, const K &key, const V &value);
+
+  size_t capacity_; // number of slots, a power of 2
+  size_t mask_;
+  int shift_; // hash bits dropped to get a slot index
+  std::unique_ptr<Slot[]> slots_;
+  size_t size_; // number of entries, protected by latch_
+  // odd while Remove() moves entries, bumped by each such Remove()
+  std::atomic<uint64_t> moves_;
+  std::mutex latch_; // serializes writers
+};
+} // namespace scudb
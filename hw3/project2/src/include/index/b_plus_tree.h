@@ -10,6 +10,7 @@
  */
 #pragma once
 
+#include <atomic>
 #include <queue>
 #include <vector>
 
@@ -53,7 +54,8 @@ public:
   // Print this B+ tree to stdout using a simple command-line
   std::string ToString(bool verbose = false);
 
-  // read data from file and insert one by one
+  // read data from file and insert one by one, new leaves go through a
+  // ring of BULK_WRITE_RING_SIZE frames unless transaction has a strategy
   void InsertFromFile(const std::string &file_name,
                       Transaction *transaction = nullptr);
 
@@ -67,6 +69,9 @@ public:
                                            Operation op = Operation::SEARCH);
 
 private:
+  // read latched leaf, inner pages are read without latches
+  Page *FindLeafPageOptimistic(const KeyType &key, bool leftMost);
+
   void LockPage(Page* page, Transaction* txn, Operation op);
   
   void UnlockPage(Page* page, Transaction* txn, Operation op);
@@ -84,7 +89,9 @@ private:
                         BPlusTreePage *new_node,
                         Transaction *transaction = nullptr);
 
-  template <typename N> N *Split(N *node);
+  // the new page is taken through strategy, if any
+  template <typename N>
+  WritePageGuard Split(N *node, BufferAccessStrategy *strategy = nullptr);
 
   template <typename N>
   bool CoalesceOrRedistribute(N *node, Transaction *transaction = nullptr);
@@ -107,7 +114,8 @@ private:
 
   // member variable
   std::string index_name_;
-  page_id_t root_page_id_;
+  // read without the root mutex by FindLeafPageOptimistic()
+  std::atomic<page_id_t> root_page_id_;
   BufferPoolManager *buffer_pool_manager_;
   KeyComparator comparator_;
 
@@ -3,6 +3,7 @@
  * For range scan of b+ tree
  */
 #pragma once
+#include "buffer/readahead.h"
 #include "page/b_plus_tree_leaf_page.h"
 
 namespace scudb {
@@ -28,6 +29,7 @@ private:
   int index_;
   BufferPoolManager* buffer_pool_manager_;
   B_PLUS_TREE_LEAF_PAGE_TYPE* leaf_page_;
+  Readahead readahead_;
 };
 
 } // namespace scudb
@@ -0,0 +1,67 @@
+/**
+ * checkpoint_manager.h
+ * Fuzzy checkpoints bound how much log recovery reads and how much log is
+ * kept. A checkpoint logs a begin record B, then an end record with the
+ * active transaction table (last lsn of each transaction) and the dirty page
+ * table (recLSN of each page) as of B. Neither table stops writers, see
+ * TransactionManager::BeginCheckpoint() and
+ * BufferPoolManager::GetDirtyPageTable(). A table too large for one log
+ * buffer is split over several end records.
+ * Once the end record is persistent the header page gets the offset of the
+ * checkpoint and the log start, the offset of the oldest of B, the recLSNs
+ * and the begin records of the active transactions. Log before the log start
+ * is no longer needed and is given back.
+ */
+
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "buffer/buffer_pool_manager.h"
+#include "concurrency/transaction_manager.h"
+#include "logging/log_manager.h"
+
+namespace scudb {
+
+class CheckpointManager {
+public:
+  CheckpointManager(TransactionManager *transaction_manager,
+                    LogManager *log_manager,
+                    BufferPoolManager *buffer_pool_manager,
+                    DiskManager *disk_manager)
+      : transaction_manager_(transaction_manager), log_manager_(log_manager),
+        buffer_pool_manager_(buffer_pool_manager), disk_manager_(disk_manager),
+        checkpoint_thread_(nullptr), checkpoint_running_(false) {}
+
+  ~CheckpointManager() { StopCheckpointThread(); }
+
+  // take a checkpoint, returns the lsn of its last end record, INVALID_LSN
+  // if logging is off or the header page can not be fetched. concurrent
+  // calls are serialized
+  lsn_t Checkpoint();
+
+  // spawn a separate thread that takes a checkpoint every interval
+  void RunCheckpointThread(std::chrono::milliseconds interval);
+  void StopCheckpointThread();
+
+private:
+  // body of the checkpoint thread
+  void CheckpointLoop();
+
+  TransactionManager *transaction_manager_;
+  LogManager *log_manager_;
+  BufferPoolManager *buffer_pool_manager_;
+  DiskManager *disk_manager_;
+  // one checkpoint at a time
+  std::mutex checkpoint_latch_;
+  // checkpoint thread, configuration is protected by latch_
+  std::thread *checkpoint_thread_;
+  bool checkpoint_running_;
+  std::chrono::milliseconds interval_;
+  std::condition_variable cv_;
+  std::mutex latch_;
+};
+
+} // namespace scudb
@@ -3,13 +3,32 @@
  * log manager maintain a separate thread that is awaken when the log buffer is
  * full or time out(every X second) to write log buffer's content into disk log
  * file.
+ * Group commit: records are appended to one buffer while the flush thread
+ * writes the other, the two are swapped before each write. A committing
+ * transaction waits in WaitForFlush() until its commit record is persistent,
+ * all the transactions that committed during a write are made durable
+ * together by the next one.
+ * Appending takes no lock. An appender reserves its LSN and its bytes in the
+ * buffer with one compare-and-swap on reservation_, serializes the record in
+ * parallel with other appenders, then adds its size to the completed bytes
+ * of the buffer. A buffer is written once all the bytes reserved in it
+ * before the swap are completed. Only an appender finding the buffer full
+ * waits for the flush thread.
+ * Async commit: a transaction that can lose its last moments on a crash does
+ * not wait for its commit record, it calls ScheduleFlush() instead. The flush
+ * thread then writes the buffer within ASYNC_COMMIT_LAG rather than at the
+ * next LOG_TIMEOUT.
+ * The file offset of every write is remembered with the first lsn in it, so
+ * that a checkpoint can tell where in the log file a record starts.
  */
 
 #pragma once
 #include <algorithm>
 #include <condition_variable>
+#include <deque>
 #include <future>
 #include <mutex>
+#include <thread>
 
 #include "disk/disk_manager.h"
 #include "logging/log_record.h"
@@ -19,18 +38,25 @@ namespace scudb {
 class LogManager {
 public:
   LogManager(DiskManager *disk_manager)
-      : next_lsn_(0), persistent_lsn_(INVALID_LSN),
+      : reservation_(0), persistent_lsn_(INVALID_LSN),
+        log_buffer_size_(LOG_BUFFER_PAGES * disk_manager->GetPageSize()),
+        buffer_lsn_(0), log_offset_(disk_manager->GetLogFileSize()),
+        flush_requested_(false), flushing_(false), flush_deadline_(0),
+        flush_thread_(nullptr), flush_thread_running_(false),
         disk_manager_(disk_manager) {
-    // TODO: you may intialize your own defined memeber variables here
-    log_buffer_ = new char[LOG_BUFFER_SIZE];
-    flush_buffer_ = new char[LOG_BUFFER_SIZE];
+    for (int i = 0; i < 2; ++i) {
+      buffers_[i] = new char[log_buffer_size_];
+      completed_[i] = 0;
+    }
   }
 
   ~LogManager() {
-    delete[] log_buffer_;
-    delete[] flush_buffer_;
-    log_buffer_ = nullptr;
-    flush_buffer_ = nullptr;
+    if (flush_thread_ != nullptr)
+      StopFlushThread();
+    for (int i = 0; i < 2; ++i) {
+      delete[] buffers_[i];
+      buffers_[i] = nullptr;
+    }
   }
   // spawn a separate thread to wake up periodically to flush
   void RunFlushThread();
@@ -38,29 +64,93 @@ public:
 
   // append a log record into log buffer
   lsn_t AppendLogRecord(LogRecord &log_record);
+  // block until every record up to and including lsn is persistent, the
+  // buffer is written right away rather than at the next timeout
+  void WaitForFlush(lsn_t lsn);
+  // have what is appended so far written within ASYNC_COMMIT_LAG, without
+  // waiting. only bounded while the flush thread runs
+  void ScheduleFlush();
+
+  // offset in the log file of a write holding the records from lsn on, -1
+  // if lsn precedes what was written by this log manager. lsn must be
+  // persistent
+  off_t GetLogOffset(lsn_t lsn);
+  // give back the log file before offset, see DiskManager::TruncateLog()
+  void TruncateLog(off_t offset);
+  // continue the lsns of a recovered log, before anything is appended
+  void SetNextLSN(lsn_t lsn);
 
   // get/set helper functions
   inline lsn_t GetPersistentLSN() { return persistent_lsn_; }
   inline void SetPersistentLSN(lsn_t lsn) { persistent_lsn_ = lsn; }
-  inline char *GetLogBuffer() { return log_buffer_; }
+  inline char *GetLogBuffer() {
+    return buffers_[ReservedBuffer(reservation_.load())];
+  }
+  inline size_t GetLogBufferSize() { return log_buffer_size_; }
 
 private:
-  // TODO: you may add your own member variables
-  // also remember to change constructor accordingly
+  // fields of reservation_: next lsn in the upper half, then the buffer
+  // appended to and the bytes reserved in it
+  static const uint64_t RESERVED_LSN = uint64_t(1) << 32;
+  static const uint64_t RESERVED_BUFFER = uint64_t(1) << 31;
+  static inline lsn_t ReservedLSN(uint64_t reservation) {
+    return static_cast<lsn_t>(reservation >> 32);
+  }
+  static inline int ReservedBuffer(uint64_t reservation) {
+    return (reservation & RESERVED_BUFFER) ? 1 : 0;
+  }
+  static inline size_t ReservedBytes(uint64_t reservation) {
+    return reservation & (RESERVED_BUFFER - 1);
+  }
+
+  // body of the flush thread
+  void FlushLoop();
+  // when the flush thread must write for ScheduleFlush()
+  std::chrono::steady_clock::time_point GetFlushDeadline();
+  // get the buffer written, by the flush thread if it runs, and wait for the
+  // write. NOTE: lck must hold latch_
+  void RequestFlush(std::unique_lock<std::mutex> &lck);
+  // swap buffers and write what was appended before, once it is completed.
+  // latch_ is released meanwhile.
+  // NOTE: lck must hold latch_ and no other flush may be running
+  void FlushBuffer(std::unique_lock<std::mutex> &lck);
+  void SerializeLogRecord(LogRecord &log_record, char *data);
+  // rid of a tuple record, followed by the CLR fields if it is one. returns
+  // the bytes written
+  static int SerializeRID(const LogRecord &log_record, const RID &rid,
+                          char *data);
 
-  // atomic counter, record the next log sequence number
-  std::atomic<lsn_t> next_lsn_;
+  // next log sequence number, buffer in use and bytes reserved in it
+  std::atomic<uint64_t> reservation_;
   // log records before & include persistent_lsn_ have been written to disk
   std::atomic<lsn_t> persistent_lsn_;
-  // log buffer related
-  char *log_buffer_;
-  char *flush_buffer_;
+  // log buffer related, sized after page size of db file
+  size_t log_buffer_size_;
+  char *buffers_[2];
+  // bytes of each buffer whose record is serialized
+  std::atomic<size_t> completed_[2];
+  // first lsn of the buffer appended to, offset of the next write and
+  // (first lsn, offset) of the writes since the log was last truncated.
+  // protected by latch_
+  lsn_t buffer_lsn_;
+  off_t log_offset_;
+  std::deque<std::pair<lsn_t, off_t>> write_offsets_;
   // latch to protect shared member variables
   std::mutex latch_;
+  // someone waits for the buffer to be written
+  bool flush_requested_;
+  // a buffer is being written
+  bool flushing_;
+  // ticks of steady_clock when the buffer must be written for an async
+  // commit, 0 if no async commit waits
+  std::atomic<int64_t> flush_deadline_;
   // flush thread
   std::thread *flush_thread_;
+  bool flush_thread_running_;
   // for notifying flush thread
   std::condition_variable cv_;
+  // notified after every write, for appenders and committers
+  std::condition_variable flushed_cv_;
   // disk manager
   DiskManager *disk_manager_;
 };
@@ -21,11 +21,26 @@
  *------------------------------------------------------------------------------
  * For new page type log record
  *-------------------------------------------------------------
- * | HEADER | prev_page_id |
+ * | HEADER | prev_page_id | page_id |
+ *-------------------------------------------------------------
+ * For end checkpoint log record, prevLSN is the begin checkpoint record
+ *------------------------------------------------------------------------------
+ * | HEADER | txn_count | txn_id | last_lsn | ... | page_count | page_id |
+ * | rec_lsn | ... |
+ *------------------------------------------------------------------------------
+ * Begin checkpoint log record is just the HEADER
+ * For compensation log record (CLR), written when recovery undoes one of the
+ * tuple records above. It is laid out like the record it redoes, of type
+ * LogType, with undoNextLSN after the rid. Undo skips from it to
+ * undoNextLSN, the record before the one it compensated. A CLR of type
+ * INSERT puts back the tuple an APPLYDELETE removed, at the same rid
+ *-------------------------------------------------------------
+ * | HEADER | tuple_rid | undoNextLSN | LogType | ... |
  *-------------------------------------------------------------
  */
 #pragma once
 #include <cassert>
+#include <vector>
 
 #include "common/config.h"
 #include "table/tuple.h"
@@ -44,6 +59,11 @@ enum class LogRecordType {
   ABORT,
   // when create a new page in heap table
   NEWPAGE,
+  // fuzzy checkpoint, see CheckpointManager
+  BEGIN_CHECKPOINT,
+  END_CHECKPOINT,
+  // compensation of an undone record, see LogRecovery::Undo()
+  CLR,
 };
 
 class LogRecord {
@@ -91,14 +111,39 @@ public:
             new_tuple.GetLength() + 2 * sizeof(int32_t);
   }
 
-  // constructor for NEWPAGE type
+  // constructor for NEWPAGE type, page_id is the new page
   LogRecord(txn_id_t txn_id, lsn_t prev_lsn, LogRecordType log_record_type,
-            page_id_t page_id)
+            page_id_t prev_page_id, page_id_t page_id)
       : size_(HEADER_SIZE), lsn_(INVALID_LSN), txn_id_(txn_id),
         prev_lsn_(prev_lsn), log_record_type_(log_record_type),
-        prev_page_id_(page_id) {
+        prev_page_id_(prev_page_id), page_id_(page_id) {
+    // calculate log record size
+    size_ = HEADER_SIZE + 2 * sizeof(page_id_t);
+  }
+
+  // constructor for END_CHECKPOINT type, active_txns maps each active
+  // transaction to its last lsn, dirty_pages each dirty page to its recLSN
+  LogRecord(lsn_t begin_lsn, LogRecordType log_record_type,
+            const std::vector<std::pair<txn_id_t, lsn_t>> &active_txns,
+            const std::vector<std::pair<page_id_t, lsn_t>> &dirty_pages)
+      : lsn_(INVALID_LSN), txn_id_(INVALID_TXN_ID), prev_lsn_(begin_lsn),
+        log_record_type_(log_record_type), active_txns_(active_txns),
+        dirty_pages_(dirty_pages) {
     // calculate log record size
-    size_ = HEADER_SIZE + sizeof(page_id_t);
+    size_ = HEADER_SIZE + 2 * sizeof(int32_t) +
+            active_txns.size() * (sizeof(txn_id_t) + sizeof(lsn_t)) +
+            dirty_pages.size() * (sizeof(page_id_t) + sizeof(lsn_t));
+  }
+
+  // constructor for CLR type, redo applies action, one of the tuple records,
+  // undo goes on at undo_next_lsn
+  LogRecord(lsn_t undo_next_lsn, const LogRecord &action) : LogRecord(action) {
+    assert(action.log_record_type_ >= LogRecordType::INSERT &&
+           action.log_record_type_ <= LogRecordType::UPDATE);
+    log_record_type_ = LogRecordType::CLR;
+    clr_type_ = action.log_record_type_;
+    undo_next_lsn_ = undo_next_lsn;
+    size_ += sizeof(lsn_t) + sizeof(LogRecordType);
   }
 
   ~LogRecord() {}
@@ -111,6 +156,16 @@ public:
 
   inline page_id_t GetNewPageRecord() { return prev_page_id_; }
 
+  inline page_id_t GetNewPageId() { return page_id_; }
+
+  inline std::vector<std::pair<txn_id_t, lsn_t>> &GetActiveTxns() {
+    return active_txns_;
+  }
+
+  inline std::vector<std::pair<page_id_t, lsn_t>> &GetDirtyPages() {
+    return dirty_pages_;
+  }
+
   inline int32_t GetSize() { return size_; }
 
   inline lsn_t GetLSN() { return lsn_; }
@@ -121,6 +176,14 @@ public:
 
   inline LogRecordType &GetLogRecordType() { return log_record_type_; }
 
+  // type of the record a CLR redoes like, the type itself for the others
+  inline LogRecordType GetRedoType() const {
+    return log_record_type_ == LogRecordType::CLR ? clr_type_
+                                                  : log_record_type_;
+  }
+
+  inline lsn_t GetUndoNextLSN() { return undo_next_lsn_; }
+
   // For debug purpose
   inline std::string ToString() const {
     std::ostringstream os;
@@ -158,6 +221,16 @@ private:
 
   // case4: for new page opeartion
   page_id_t prev_page_id_ = INVALID_PAGE_ID;
+  page_id_t page_id_ = INVALID_PAGE_ID;
+
+  // case5: for end checkpoint
+  std::vector<std::pair<txn_id_t, lsn_t>> active_txns_;
+  std::vector<std::pair<page_id_t, lsn_t>> dirty_pages_;
+
+  // case6: for compensation, the fields of the record it redoes like are
+  // set as well
+  LogRecordType clr_type_ = LogRecordType::INVALID;
+  lsn_t undo_next_lsn_ = INVALID_LSN;
   const static int HEADER_SIZE = 20;
 }; // namespace scudb
 
@@ -1,27 +1,58 @@
 /**
  * recovery_manager.h
  * Read log file from disk, redo and undo
+ *
+ * Redo reads the log sequentially in chunks of LOG_READ_PAGES pages. Every
+ * record touching a page is handed to the worker owning that page, workers
+ * are picked by page id, so the records of a page are replayed in log order
+ * while different pages are replayed in parallel. A record is only replayed
+ * if the page LSN is older. Undo rolls back the transactions still active at
+ * the end of the log, newest record first. With a log manager every undone
+ * record is compensated by a CLR and each transaction ends with an ABORT
+ * record, so a crash during undo is recovered like any other: redo replays
+ * the CLRs and undo carries on after the last one.
+ * With a checkpoint in the header page, redo starts at its log start rather
+ * than at the beginning of the log. A record older than the checkpoint is
+ * only replayed on a page of its dirty page table whose recLSN is not newer.
+ * The log continues after recovery at GetNextLSN(), see
+ * LogManager::SetNextLSN().
  */
 
 #pragma once
 #include <algorithm>
+#include <condition_variable>
+#include <deque>
 #include <mutex>
 #include <unordered_map>
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
 #include "concurrency/lock_manager.h"
+#include "logging/log_manager.h"
 #include "logging/log_record.h"
 
 namespace scudb {
 
 class LogRecovery {
+  // raw records waiting for one redo worker, handed over in batches
+  struct RedoQueue {
+    std::mutex latch;
+    std::condition_variable cv;
+    std::deque<std::vector<char>> batches;
+    bool done = false;
+  };
+
 public:
   LogRecovery(DiskManager *disk_manager,
-                    BufferPoolManager *buffer_pool_manager)
+                    BufferPoolManager *buffer_pool_manager,
+                    LogManager *log_manager = nullptr,
+                    size_t num_workers = RECOVERY_WORKERS)
       : disk_manager_(disk_manager), buffer_pool_manager_(buffer_pool_manager),
-        offset_(0) {
+        log_manager_(log_manager), num_workers_(num_workers),
+        checkpoint_lsn_(INVALID_LSN), next_lsn_(0), offset_(0) {
     // global transaction through recovery phase
-    log_buffer_ = new char[LOG_BUFFER_SIZE];
+    log_buffer_size_ = LOG_READ_PAGES * disk_manager->GetPageSize();
+    log_buffer_ = new char[log_buffer_size_];
   }
 
   ~LogRecovery() {
@@ -31,19 +62,60 @@ public:
 
   void Redo();
   void Undo();
-  bool DeserializeLogRecord(const char *data, LogRecord &log_record);
+  // size: bytes available at data
+  bool DeserializeLogRecord(const char *data, int size, LogRecord &log_record);
+  // lsn after the last record seen by Redo()
+  inline lsn_t GetNextLSN() const { return next_lsn_; }
 
 private:
-  // TODO: you can add whatever member variable here
-  // Don't forget to initialize newly added variable in constructor
+  // bytes of records collected for a worker before they are handed over, and
+  // batches a worker may have queued before the reader waits
+  static const size_t REDO_BATCH_SIZE = 64 * 1024;
+  static const size_t REDO_QUEUE_DEPTH = 16;
+
+  inline size_t GetWorker(page_id_t page_id) const {
+    return static_cast<size_t>(page_id) % num_workers_;
+  }
+  // header fields only, see log_record.h
+  static void DeserializeHeader(const char *data, LogRecord &log_record);
+  // rid of a tuple record and the undo-next LSN of a CLR, returns the bytes
+  // read
+  static int DeserializeRID(const char *data, RID &rid,
+                            LogRecord &log_record);
+  // body of a redo worker
+  void RedoLoop(size_t worker, RedoQueue *queue);
+  // replay the part of a record that falls on the pages of worker
+  void RedoLogRecord(size_t worker, LogRecord &log_record);
+  // roll back one record, logging a CLR if there is a log manager
+  void UndoLogRecord(LogRecord &log_record);
+  // pass a batch to a worker, waiting while its queue is full
+  void HandOver(RedoQueue *queue, std::vector<char> &batch);
+  // find the log start and the dirty page table of the last checkpoint,
+  // returns where redo starts reading
+  off_t ReadCheckpoint();
+  // read the record at offset, false at end of log
+  bool ReadLogRecord(off_t offset, std::vector<char> &data);
+  // whether a record older than the checkpoint changed page_id after it
+  // was last written
+  bool NeedsRedo(page_id_t page_id, lsn_t lsn) const;
+
   DiskManager *disk_manager_;
   BufferPoolManager *buffer_pool_manager_;
+  // where Undo() logs, nullptr to log nothing
+  LogManager *log_manager_;
+  size_t num_workers_;
   // maintain active transactions and its corresponds latest lsn
   std::unordered_map<txn_id_t, lsn_t> active_txn_;
   // mapping log sequence number to log file offset, for undo purpose
-  std::unordered_map<lsn_t, int> lsn_mapping_;
-  // log buffer related
-  int offset_;
+  std::unordered_map<lsn_t, off_t> lsn_mapping_;
+  // begin lsn and dirty page table of the last checkpoint, INVALID_LSN if
+  // there is none
+  lsn_t checkpoint_lsn_;
+  std::unordered_map<page_id_t, lsn_t> dirty_pages_;
+  lsn_t next_lsn_;
+  // log buffer related, offset_ is where log_buffer_ starts in the log file
+  off_t offset_;
+  size_t log_buffer_size_;
   char *log_buffer_;
 };
 
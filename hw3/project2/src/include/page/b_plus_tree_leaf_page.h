@@ -34,7 +34,8 @@ class BPlusTreeLeafPage : public BPlusTreePage {
 public:
   // After creating a new leaf page from buffer pool, must call initialize
   // method to set default values
-  void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID);
+  void Init(page_id_t page_id, size_t page_size,
+            page_id_t parent_id = INVALID_PAGE_ID);
   // helper methods
   page_id_t GetNextPageId() const;
   void SetNextPageId(page_id_t next_page_id);
@@ -9,6 +9,10 @@
  *  -----------------------------------------------------------------
  * | RecordCount (4) | Entry_1 name (32) | Entry_1 root_id (4) | ... |
  *  -----------------------------------------------------------------
+ * The last 20 bytes of the page locate the log, see CheckpointManager
+ *  -----------------------------------------------------------------
+ * | ... | LogStart (8) | CheckpointOffset (8) | CheckpointLSN (4) |
+ *  -----------------------------------------------------------------
  */
 
 #pragma once
@@ -21,7 +25,11 @@ namespace scudb {
 
 class HeaderPage : public Page {
 public:
-  void Init() { SetRecordCount(0); }
+  void Init() {
+    SetRecordCount(0);
+    SetLogStart(0);
+    SetCheckpoint(0, INVALID_LSN);
+  }
   /**
    * Record related
    */
@@ -33,11 +41,25 @@ public:
   bool GetRootId(const std::string &name, page_id_t &root_id);
   int GetRecordCount();
 
+  /**
+   * Log related
+   */
+  // offset in the log file where recovery starts reading
+  off_t GetLogStart();
+  void SetLogStart(off_t offset);
+  // last complete checkpoint, INVALID_LSN if none. offset is where its end
+  // record is found from
+  off_t GetCheckpointOffset();
+  lsn_t GetCheckpointLSN();
+  void SetCheckpoint(off_t offset, lsn_t lsn);
+
 private:
   /**
    * helper functions
    */
   int FindRecord(const std::string &name);
+  // where the log related fields start
+  inline int GetLogFieldsOffset() { return static_cast<int>(GetPageSize()) - 20; }
 
   void SetRecordCount(int record_count);
 };
@@ -4,48 +4,112 @@
  * Wrapper around actual data page in main memory and also contains bookkeeping
  * information used by buffer pool manager like pin_count/dirty_flag/page_id.
  * Use page as a basic unit within the database system
+ * Besides the latch, every page has a version that is odd while the page is
+ * write latched and bumped on each write latch and unlatch. A reader may read
+ * the page without latching it: take ReadBegin(), read, and trust what was
+ * read only if ReadValidate() holds for that version afterwards. The page must
+ * stay pinned meanwhile, and what was read can be inconsistent before it is
+ * validated.
+ * A page also remembers the LSN of its first logged change since it was
+ * last written, so that the buffer pool knows which pages must wait for the
+ * log before they are written. The dirty page table of a checkpoint is made
+ * of these.
  */
 
 #pragma once
 
+#include <atomic>
+#include <cstdint>
 #include <cstring>
 #include <iostream>
+#include <thread>
 
 #include "common/config.h"
-#include "common/rwmutex.h"
+#include "common/rwlatch.h"
 
 namespace scudb {
 
 class Page {
-  friend class BufferPoolManager;
+  friend class BufferPoolManagerInstance;
 
 public:
-  Page() { ResetMemory(); }
+  Page() {}
   ~Page(){};
   // get actual data page content
   inline char *GetData() { return data_; }
+  // get size of page content in byte
+  inline size_t GetPageSize() { return page_size_; }
   // get page id
   inline page_id_t GetPageId() { return page_id_; }
   // get page pin count
   inline int GetPinCount() { return pin_count_; }
   // method use to latch/unlatch page content
-  inline void WUnlatch() { rwlatch_.WUnlock(); }
-  inline void WLatch() { rwlatch_.WLock(); }
+  inline void WUnlatch() {
+    version_.store(version_.load(std::memory_order_relaxed) + 1,
+                   std::memory_order_release);
+    rwlatch_.WUnlock();
+  }
+  inline void WLatch() {
+    rwlatch_.WLock();
+    version_.store(version_.load(std::memory_order_relaxed) + 1,
+                   std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+  }
+  inline bool TryWLatch() {
+    if (!rwlatch_.TryWLock()) {
+      return false;
+    }
+    version_.store(version_.load(std::memory_order_relaxed) + 1,
+                   std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    return true;
+  }
   inline void RUnlatch() { rwlatch_.RUnlock(); }
   inline void RLatch() { rwlatch_.RLock(); }
+  inline bool TryRLatch() { return rwlatch_.TryRLock(); }
+  // optimistic read, waits while a writer holds the page
+  inline uint64_t ReadBegin() {
+    uint64_t version;
+    while ((version = version_.load(std::memory_order_acquire)) & 1) {
+      std::this_thread::yield();
+    }
+    return version;
+  }
+  // true if no writer latched the page since ReadBegin() returned version
+  inline bool ReadValidate(uint64_t version) {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return version_.load(std::memory_order_relaxed) == version;
+  }
 
   inline lsn_t GetLSN() { return *reinterpret_cast<lsn_t *>(GetData() + 4); }
-  inline void SetLSN(lsn_t lsn) { memcpy(GetData() + 4, &lsn, 4); }
+  inline void SetLSN(lsn_t lsn) {
+    memcpy(GetData() + 4, &lsn, 4);
+    lsn_t none = INVALID_LSN;
+    rec_lsn_.compare_exchange_strong(none, lsn);
+  }
+  // LSN of the first change since the page was last written, INVALID_LSN if
+  // none was logged
+  inline lsn_t GetRecLSN() { return rec_lsn_.load(); }
 
 private:
   // method used by buffer pool manager
-  inline void ResetMemory() { memset(data_, 0, PAGE_SIZE); }
+  inline void ResetMemory() { memset(data_, 0, page_size_); }
+  // the frame now holds what is on disk, or nothing
+  inline void SetClean() {
+    is_dirty_ = false;
+    rec_lsn_.store(INVALID_LSN);
+  }
   // members
-  char data_[PAGE_SIZE]; // actual data
+  char *data_ = nullptr; // actual data, owned by buffer pool manager
+  size_t page_size_ = 0;
+  size_t frame_id_ = 0; // position in buffer pool, see BufferPoolManager
   page_id_t page_id_ = INVALID_PAGE_ID;
   int pin_count_ = 0;
   bool is_dirty_ = false;
-  RWMutex rwlatch_;
+  bool prefetched_ = false; // read ahead and not fetched since
+  RWLatch rwlatch_;
+  std::atomic<uint64_t> version_{0}; // odd while write latched
+  std::atomic<lsn_t> rec_lsn_{INVALID_LSN};
 };
 
 } // namespace scudb
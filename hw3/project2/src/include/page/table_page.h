@@ -60,6 +60,8 @@ public:
                    LogManager *log_manager); // when commit success
   void RollbackDelete(const RID &rid, Transaction *txn,
                       LogManager *log_manager); // when commit abort
+  // put a tuple removed by ApplyDelete back at rid, recovery only
+  void RestoreTuple(const Tuple &tuple, const RID &rid);
 
   // return tuple (with data pointing to heap) if success
   bool GetTuple(const RID &rid, Tuple &tuple, Transaction *txn,
@@ -46,7 +46,9 @@ public:
 
   bool DeleteTableHeap();
 
-  TableIterator begin(Transaction *txn);
+  // a strategy given here is used by the iterator instead of the one of txn
+  TableIterator begin(Transaction *txn,
+                      BufferAccessStrategy *strategy = nullptr);
 
   TableIterator end();
 
@@ -60,6 +62,11 @@ private:
   LockManager *lock_manager_;
   LogManager *log_manager_;
   page_id_t first_page_id_;
+
+  // pages are fetched on behalf of txn through its strategy
+  static inline BufferAccessStrategy *GetStrategy(Transaction *txn) {
+    return txn == nullptr ? nullptr : txn->GetBufferAccessStrategy();
+  }
 };
 
 } // namespace scudb
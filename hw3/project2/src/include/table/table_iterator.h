@@ -8,6 +8,7 @@
 
 #include <cassert>
 
+#include "buffer/readahead.h"
 #include "common/rid.h"
 #include "table/tuple.h"
 
@@ -19,7 +20,9 @@ class TableIterator {
   friend class Cursor;
 
 public:
-  TableIterator(TableHeap *table_heap, RID rid, Transaction *txn);
+  // pages are fetched through strategy, or the one of txn if it is nullptr
+  TableIterator(TableHeap *table_heap, RID rid, Transaction *txn,
+                BufferAccessStrategy *strategy = nullptr);
 
   ~TableIterator() { delete tuple_; }
 
@@ -43,6 +46,8 @@ private:
   TableHeap *table_heap_;
   Tuple *tuple_;
   Transaction *txn_;
+  BufferAccessStrategy *strategy_;
+  Readahead readahead_;
 };
 
 } // namespace scudb
\ No newline at end of file
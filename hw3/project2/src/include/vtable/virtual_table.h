@@ -5,6 +5,7 @@
 #pragma once
 
 #include "buffer/lru_replacer.h"
+#include "buffer/parallel_buffer_pool_manager.h"
 #include "catalog/schema.h"
 #include "concurrency/transaction_manager.h"
 #include "index/b_plus_tree_index.h"
@@ -62,17 +63,38 @@ int VtabBegin(sqlite3_vtab *pVTab);
 // storage engine
 class StorageEngine {
 public:
-  StorageEngine(std::string db_file_name) {
+  // num_instances > 1 splits the pool_size frames among that many
+  // independent pools, see ParallelBufferPoolManager. page_size is used when
+  // the db file is created, an existing file keeps its own. direct_io makes
+  // the buffer pool the only cache of db file. warm_state keeps the resident
+  // pages in db_file_name + ".warm" and loads them back on the next start
+  StorageEngine(std::string db_file_name, size_t pool_size = BUFFER_POOL_SIZE,
+                size_t num_instances = 1,
+                size_t page_size = DEFAULT_PAGE_SIZE, bool direct_io = false,
+                bool warm_state = false) {
     ENABLE_LOGGING = false;
 
     // storage related
-    disk_manager_ = new DiskManager(db_file_name);
+    disk_manager_ = new DiskManager(db_file_name, page_size,
+                                    AsyncIOType::IO_URING, direct_io);
 
     // log related
     log_manager_ = new LogManager(disk_manager_);
 
-    buffer_pool_manager_ =
-        new BufferPoolManager(BUFFER_POOL_SIZE, disk_manager_, log_manager_);
+    if (num_instances > 1) {
+      buffer_pool_manager_ = new ParallelBufferPoolManager(
+          num_instances, pool_size, disk_manager_, log_manager_);
+    } else {
+      buffer_pool_manager_ = new BufferPoolManagerInstance(
+          pool_size, disk_manager_, log_manager_);
+    }
+    // warm the pool up with the pages resident before the last shutdown
+    if (warm_state) {
+      std::string warm_state_file = db_file_name + ".warm";
+      buffer_pool_manager_->RestoreWarmState(warm_state_file);
+      buffer_pool_manager_->RunWarmStateThread(warm_state_file,
+                                               WARM_STATE_INTERVAL);
+    }
 
     // txn related
     lock_manager_ = new LockManager(true); // S2PL
@@ -80,11 +102,13 @@ public:
   }
 
   ~StorageEngine() {
-    if (ENABLE_LOGGING)
-      log_manager_->StopFlushThread();
-    delete disk_manager_;
+    log_manager_->StopFlushThread();
+    // the buffer pool dumps its warm state and may still be reading, it
+    // flushes the log before writing a page. the log manager writes its
+    // last buffer to the disk manager
     delete buffer_pool_manager_;
     delete log_manager_;
+    delete disk_manager_;
     delete lock_manager_;
     delete transaction_manager_;
   }
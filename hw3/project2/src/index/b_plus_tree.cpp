@@ -1,6 +1,7 @@
 /**
  * b_plus_tree.cpp
  */
+#include <fstream>
 #include <iostream>
 #include <string>
 
@@ -69,9 +70,14 @@ INDEX_TEMPLATE_ARGUMENTS
 bool BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value,
                             Transaction *transaction) {
   if(IsEmpty()) {
-    std::cout << "start a new tree" << std::endl;
-    StartNewTree(key, value, transaction);
-    return true;
+    // another insert may have started the tree meanwhile
+    LockRoot();
+    if(IsEmpty()) {
+      StartNewTree(key, value, transaction);
+      UnlockRoot();
+      return true;
+    }
+    UnlockRoot();
   }
   return InsertIntoLeaf(key, value, transaction);
 }
@@ -87,24 +93,20 @@ void BPLUSTREE_TYPE::StartNewTree(const KeyType &key, const ValueType &value, Tr
   assert(IsEmpty());
 
   // require new page
-  auto page = buffer_pool_manager_->NewPage(root_page_id_);
-  if(page == nullptr)
+  page_id_t root_page_id;
+  WritePageGuard root_guard = buffer_pool_manager_->NewPageGuarded(root_page_id);
+  if(!root_guard)
     throw Exception(ExceptionType::EXCEPTION_TYPE_INDEX, "StartNewTree: out of memory");
+  root_page_id_ = root_page_id;
   
   // update root
-  LockPage(page, txn, Operation::INSERT);
-  B_PLUS_TREE_LEAF_PAGE_TYPE* root_page = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE*>(page->GetData());
+  B_PLUS_TREE_LEAF_PAGE_TYPE* root_page = root_guard.AsMut<B_PLUS_TREE_LEAF_PAGE_TYPE>();
   UpdateRootPageId(true);
   
   // config root
-  root_page->Init(root_page_id_, INVALID_PAGE_ID);
+  root_page->Init(root_page_id_, buffer_pool_manager_->GetPageSize());
   assert(!IsEmpty());
   root_page->Insert(key, value, comparator_);
-  page->WUnlatch();
-
-  // other updates
-  buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
-  txn->GetPageSet()->pop_front();
 }
 
 /*
@@ -120,20 +122,12 @@ bool BPLUSTREE_TYPE::InsertIntoLeaf(const KeyType &key, const ValueType &value,
                                     Transaction *transaction) {
   // get leaf page
   auto leaf_raw_page = FindLeafPage(key, false, transaction, Operation::INSERT);
-<<<<<<< HEAD
-=======
-  std::cout << "found leaf page" << std::endl;
->>>>>>> dfb4acf36093692d5426c536830c2219dc8cacad
   B_PLUS_TREE_LEAF_PAGE_TYPE* leaf_page = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE*>(leaf_raw_page->GetData());
   
   // look up and insert
   ValueType vt;
   if(leaf_page->Lookup(key, vt, comparator_)){
     // duplicate
-<<<<<<< HEAD
-=======
-    std::cout << "b plus tree: duplicate pair" << std::endl;
->>>>>>> dfb4acf36093692d5426c536830c2219dc8cacad
     UnlockParentPage(leaf_raw_page, transaction, Operation::INSERT);
     UnlockPage(leaf_raw_page, transaction, Operation::INSERT);
     return false;
@@ -166,19 +160,18 @@ bool BPLUSTREE_TYPE::InsertIntoLeaf(const KeyType &key, const ValueType &value,
     // }
 
     // insert 
-    std::cout << "page " << leaf_page->GetPageId() << ": start insert" << std::endl; 
     int cur_size = leaf_page->Insert(key, value, comparator_);
-    std::cout << "page " << leaf_page->GetPageId() << ": finish insert" << std::endl;
 
     // check full
     if(cur_size >= leaf_page->GetMaxSize()) {
-<<<<<<< HEAD
-=======
-      std::cout << "page " << leaf_page->GetPageId() << ": start split" << std::endl;
->>>>>>> dfb4acf36093692d5426c536830c2219dc8cacad
 
       // split
-      auto n_leaf_page = Split(leaf_page);
+      // a bulk load leaves full leaves behind, they stay in its ring
+      WritePageGuard n_leaf_guard = Split(
+          leaf_page, transaction == nullptr
+                         ? nullptr
+                         : transaction->GetBufferAccessStrategy());
+      auto n_leaf_page = n_leaf_guard.AsMut<B_PLUS_TREE_LEAF_PAGE_TYPE>();
       n_leaf_page->SetParentPageId(leaf_page->GetParentPageId());
       n_leaf_page->SetNextPageId(leaf_page->GetNextPageId());
       leaf_page->SetNextPageId(n_leaf_page->GetPageId());
@@ -189,10 +182,6 @@ bool BPLUSTREE_TYPE::InsertIntoLeaf(const KeyType &key, const ValueType &value,
 
       // unlock
       UnlockParentPage(leaf_raw_page, transaction, Operation::INSERT);
-<<<<<<< HEAD
-=======
-      std::cout << "page " << leaf_page->GetPageId() << ": finish spliting" << std::endl;
->>>>>>> dfb4acf36093692d5426c536830c2219dc8cacad
     }
     UnlockPage(leaf_raw_page, transaction, Operation::INSERT);
   }
@@ -205,21 +194,24 @@ bool BPLUSTREE_TYPE::InsertIntoLeaf(const KeyType &key, const ValueType &value,
  * User needs to first ask for new page from buffer pool manager(NOTICE: throw
  * an "out of memory" exception if returned value is nullptr), then move half
  * of key & value pairs from input page to newly created page
+ * The new page is returned as a guard, it is released when the caller is
+ * done with it.
  */
 INDEX_TEMPLATE_ARGUMENTS
-template <typename N> N *BPLUSTREE_TYPE::Split(N *node) {
+template <typename N>
+WritePageGuard BPLUSTREE_TYPE::Split(N *node, BufferAccessStrategy *strategy) {
   // require new page
   page_id_t page_id;
-  auto page = buffer_pool_manager_->NewPage(page_id);
-  if(page == nullptr)
+  WritePageGuard guard = buffer_pool_manager_->NewPageGuarded(page_id, strategy);
+  if(!guard)
     throw Exception(ExceptionType::EXCEPTION_TYPE_INDEX, "Split: out of memory");
   
   // move half pairs
-  auto n_page = reinterpret_cast<N*>(page->GetData());
-  n_page->Init(page_id, INVALID_PAGE_ID);
+  auto n_page = guard.AsMut<N>();
+  n_page->Init(page_id, buffer_pool_manager_->GetPageSize());
   node->MoveHalfTo(n_page, buffer_pool_manager_);
   
-  return n_page;
+  return guard;
 }
 
 /*
@@ -243,18 +235,20 @@ void BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node,
   int parent_page_id;
   if(old_node->IsRootPage()) {
     // require new page
-    auto root_raw_page = buffer_pool_manager_->NewPage(root_page_id_);
+    page_id_t new_root_page_id;
+    auto root_raw_page = buffer_pool_manager_->NewPage(new_root_page_id);
     if(root_raw_page == nullptr)
       throw Exception(ExceptionType::EXCEPTION_TYPE_INDEX, "InsertIntoParent: out of memory");
     
-    // latch new page
+    // latch new page, before searches can see it as root
     root_raw_page->WLatch();
     transaction->GetPageSet()->push_front(root_raw_page);
+    root_page_id_ = new_root_page_id;
     
     // config new root
     auto root_page = reinterpret_cast<BPlusTreeInternalPage<KeyType, page_id_t,
                                         KeyComparator>*>(root_raw_page->GetData());
-    root_page->Init(root_page_id_, INVALID_PAGE_ID);
+    root_page->Init(root_page_id_, buffer_pool_manager_->GetPageSize());
     root_page->PopulateNewRoot(old_node->GetPageId(), key, new_node->GetPageId());
 
     // update children 
@@ -265,34 +259,30 @@ void BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node,
     UpdateRootPageId(false);
 
   } else {
-    // get parent page
+    // get parent page, it is latched already by FindLeafPage()
     parent_page_id = old_node->GetParentPageId();
-    auto parent_raw_page = buffer_pool_manager_->FetchPage(parent_page_id);
-<<<<<<< HEAD
-    if(parent_raw_page==nullptr){
+    BasicPageGuard parent_guard = buffer_pool_manager_->FetchPageBasic(parent_page_id);
+    if(!parent_guard){
       throw Exception(EXCEPTION_TYPE_INDEX, "Out of memory");
     }
-=======
->>>>>>> dfb4acf36093692d5426c536830c2219dc8cacad
-    auto parent_page = reinterpret_cast<BPlusTreeInternalPage<KeyType, page_id_t,
-                                          KeyComparator>*>(parent_raw_page->GetData());
+    auto parent_page = parent_guard.AsMut<BPlusTreeInternalPage<KeyType, page_id_t,
+                                          KeyComparator>>();
 
     // insert into parent
     int cur_size = parent_page->InsertNodeAfter(old_node->GetPageId(), key, new_node->GetPageId());
     
-    // check parent
-    if(cur_size >= parent_page->GetMaxSize()) {
+    // check parent, an internal page splits once it holds max size + 1 pairs
+    if(cur_size > parent_page->GetMaxSize()) {
       // split
-      auto n_parent_page = Split(parent_page);
+      WritePageGuard n_parent_guard = Split(parent_page);
+      auto n_parent_page = n_parent_guard.AsMut<BPlusTreeInternalPage<KeyType, page_id_t,
+                                                  KeyComparator>>();
       n_parent_page->SetParentPageId(parent_page->GetParentPageId());
 
       // insert into parent
       auto mid = n_parent_page->KeyAt(0);
       InsertIntoParent(parent_page, mid, n_parent_page, transaction);
     }
-
-    // unpin page
-    buffer_pool_manager_->UnpinPage(parent_page_id, true);
   }
 }
 
@@ -340,8 +330,11 @@ void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *transaction) {
   for(auto it = transaction->GetDeletedPageSet()->begin();
   it != transaction->GetDeletedPageSet()->end();
   it++) {
-    assert(buffer_pool_manager_->DeletePage(*it));
+    bool deleted = buffer_pool_manager_->DeletePage(*it);
+    assert(deleted);
+    (void)deleted;
   }
+  transaction->GetDeletedPageSet()->clear();
 }
 
 /*
@@ -366,56 +359,34 @@ bool BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node, Transaction *transaction) {
     }
   }
 
-  // get parent page
+  // get parent page, it is latched already by FindLeafPage(). The brothers
+  // are write latched too, searches read them without going through it
   int parent_page_id = node->GetParentPageId();
-  auto parent_raw_page = buffer_pool_manager_->FetchPage(parent_page_id);
-  auto parent_page = reinterpret_cast<BPlusTreeInternalPage<KeyType, page_id_t, 
-                                        KeyComparator>*>(parent_raw_page->GetData());
+  BasicPageGuard parent_guard = buffer_pool_manager_->FetchPageBasic(parent_page_id);
+  auto parent_page = parent_guard.AsMut<BPlusTreeInternalPage<KeyType, page_id_t,
+                                          KeyComparator>>();
     
-  // left brother
+  // left brother, or the right one for the first child
   auto idx = parent_page->ValueIndex(node->GetPageId());
-  if(idx > 0) {
-    // fetch page
-    auto lft_bro_page_id = parent_page->ValueAt(idx - 1);
-    auto lft_bro_raw_page = buffer_pool_manager_->FetchPage(lft_bro_page_id);
-    N* lft_bro_page = reinterpret_cast<N*>(lft_bro_raw_page->GetData());
-
-    if(lft_bro_page->GetSize() > lft_bro_page->GetMinSize()){
-      // redistribute
-      Redistribute(lft_bro_page, node, idx);
-      buffer_pool_manager_->UnpinPage(lft_bro_page_id, true);
-      buffer_pool_manager_->UnpinPage(parent_page_id, false);
-      return false;
-    } else {
-      // merge
-      Coalesce(node, lft_bro_page, parent_page, idx, transaction);
-      buffer_pool_manager_->UnpinPage(lft_bro_page_id, true);
-      buffer_pool_manager_->UnpinPage(parent_page_id, false);
-      return true;
-    }
+  auto bro_page_id = parent_page->ValueAt(idx > 0 ? idx - 1 : idx + 1);
+  WritePageGuard bro_guard = buffer_pool_manager_->FetchPageWrite(bro_page_id);
+  N* bro_page = bro_guard.AsMut<N>();
+
+  // a leaf splits once it is full, an internal page once it overflows
+  int max_size = node->IsLeafPage() ? node->GetMaxSize() - 1 : node->GetMaxSize();
+  if(bro_page->GetSize() + node->GetSize() > max_size) {
+    // redistribute
+    Redistribute(bro_page, node, idx);
+    return false;
   }
 
-  // right brother
-  if(idx < parent_page->GetMaxSize() - 1) {
-    // fetch page
-    auto rht_bro_page_id = parent_page->ValueAt(idx + 1);
-    auto rht_bro_raw_page = buffer_pool_manager_->FetchPage(rht_bro_page_id);
-    N* rht_bro_page = reinterpret_cast<N*>(rht_bro_raw_page->GetData());
-
-    if(rht_bro_page->GetSize() > rht_bro_page->GetMinSize()){
-      // redistribute
-      Redistribute(rht_bro_page, node, idx);
-      buffer_pool_manager_->UnpinPage(rht_bro_page_id, true);
-      buffer_pool_manager_->UnpinPage(parent_page_id, false);
-      return false;
-    } else {
-      // merge
-      Coalesce(rht_bro_page, node, parent_page, idx, transaction);
-      buffer_pool_manager_->UnpinPage(rht_bro_page_id, true);
-      buffer_pool_manager_->UnpinPage(parent_page_id, false);
-      return true;
-    }
+  // merge the right page into the left one
+  if(idx > 0) {
+    Coalesce(bro_page, node, parent_page, idx, transaction);
+    return true;
   }
+  Coalesce(node, bro_page, parent_page, 1, transaction);
+  return false;
 }
 
 /*
@@ -436,13 +407,13 @@ bool BPLUSTREE_TYPE::Coalesce(
     N *&neighbor_node, N *&node,
     BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *&parent,
     int index, Transaction *transaction) {
-  // merge pages
+  // merge pages, node is the right one of the two
   node->MoveAllTo(neighbor_node, index, buffer_pool_manager_);
 
   // delete empty page
   parent->Remove(index);
   transaction->AddIntoDeletedPageSet(node->GetPageId());
-  if(parent->GetSize() < parent->GetMinSize()){
+  if(parent->IsRootPage() || parent->GetSize() < parent->GetMinSize()){
     return CoalesceOrRedistribute(parent, transaction);
   }
 
@@ -461,19 +432,10 @@ bool BPLUSTREE_TYPE::Coalesce(
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
 void BPLUSTREE_TYPE::Redistribute(N *neighbor_node, N *node, int index) {
-  // get index in parent
-  auto parent_page_id = neighbor_node->GetParentPageId();
-  auto page = buffer_pool_manager_->FetchPage(parent_page_id);
-  assert(page == nullptr);
-  auto parent_page = reinterpret_cast<BPlusTreeInternalPage<KeyType, page_id_t, 
-                                        KeyComparator>*>(page->GetData());
-  auto index_in_parent = parent_page->ValueIndex(neighbor_node->GetPageId());
-  buffer_pool_manager_->UnpinPage(parent_page_id, false);
-
   if(index == 0) 
     neighbor_node->MoveFirstToEndOf(node, buffer_pool_manager_);
   else 
-    neighbor_node->MoveLastToFrontOf(node, index_in_parent, buffer_pool_manager_);
+    neighbor_node->MoveLastToFrontOf(node, index, buffer_pool_manager_);
 }
 /*
  * Update root page if necessary
@@ -495,19 +457,18 @@ bool BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root_node) {
   }
 
   // case 1
-  if(old_root_node->GetSize() == 1) {
+  if(!old_root_node->IsLeafPage() && old_root_node->GetSize() == 1) {
     // change root
     auto old_root = reinterpret_cast<BPlusTreeInternalPage<KeyType, page_id_t, 
                                       KeyComparator>*>(old_root_node);
     root_page_id_ = old_root->ValueAt(0);
-    UpdateRootPageId(true);
+    UpdateRootPageId(false);
 
     // config new root
-    auto root_raw_page = buffer_pool_manager_->FetchPage(root_page_id_);
-    auto root_page = reinterpret_cast<BPlusTreeInternalPage<KeyType, page_id_t,
-                                      KeyComparator>*>(root_raw_page->GetData());
+    BasicPageGuard root_guard = buffer_pool_manager_->FetchPageBasic(root_page_id_);
+    auto root_page = root_guard.AsMut<BPlusTreeInternalPage<KeyType, page_id_t,
+                                      KeyComparator>>();
     root_page->SetParentPageId(INVALID_PAGE_ID);
-    buffer_pool_manager_->UnpinPage(root_page_id_, true);
 
     return true;
   }
@@ -579,6 +540,14 @@ Page *BPLUSTREE_TYPE::FindLeafPage(const KeyType &key,
   // empty
   if(IsEmpty()) return nullptr;
 
+  // searches do not latch inner pages
+  if(op == Operation::SEARCH) {
+    auto leaf_raw_page = FindLeafPageOptimistic(key, leftMost);
+    if(txn != nullptr && leaf_raw_page != nullptr)
+      txn->GetPageSet()->push_back(leaf_raw_page);
+    return leaf_raw_page;
+  }
+
   // check operation
   if(op != Operation::SEARCH)
     // if operation is write, all write latch lock
@@ -594,7 +563,6 @@ Page *BPLUSTREE_TYPE::FindLeafPage(const KeyType &key,
   auto child_raw_page = root_raw_page;
   BPlusTreePage* cur_page = root_page;
   while(!cur_page->IsLeafPage()){
-    std::cout << "not leaf" << std::endl;
     // get child page id
     auto cur_in_page = reinterpret_cast<BPlusTreeInternalPage<KeyType, page_id_t,
                                         KeyComparator>*>(cur_page);
@@ -607,7 +575,7 @@ Page *BPLUSTREE_TYPE::FindLeafPage(const KeyType &key,
     // unping page
     if(txn == nullptr){
       child_raw_page->RUnlatch();  
-      buffer_pool_manager_->UnpinPage(cur_in_page->GetPageId(), false);
+      buffer_pool_manager_->UnpinFrame(child_raw_page, false);
     }
 
     // update cur page
@@ -617,13 +585,8 @@ Page *BPLUSTREE_TYPE::FindLeafPage(const KeyType &key,
 
     if(txn != nullptr){
       if(op==Operation::SEARCH || 
-<<<<<<< HEAD
       (op==Operation::INSERT && cur_page->GetSize() + 1 < cur_page->GetMaxSize())|| 
       (op==Operation::DELETE && cur_page->GetSize() - 1 > cur_page->GetMinSize())){
-=======
-      (op==Operation::INSERT && cur_page->GetSize() < cur_page->GetMaxSize())|| 
-      (op==Operation::DELETE && cur_page->GetSize() > cur_page->GetMinSize())){
->>>>>>> dfb4acf36093692d5426c536830c2219dc8cacad
         // Search, or current page is safe
         UnlockParentPage(child_raw_page, txn, op);
       }
@@ -633,6 +596,76 @@ Page *BPLUSTREE_TYPE::FindLeafPage(const KeyType &key,
   return child_raw_page;
 }
 
+/*
+ * Descend without latching inner pages. An inner page is read optimistically
+ * and validated against its version, see Page::ReadBegin(). The version of a
+ * child is taken before the parent is validated again, so the child was
+ * still the one the parent pointed to. Only the leaf is read latched, and it
+ * is returned the same way FindLeafPage() does. A change met on the way
+ * starts the descent over from the root.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+Page *BPLUSTREE_TYPE::FindLeafPageOptimistic(const KeyType &key, bool leftMost) {
+  while(true) {
+    // root
+    page_id_t root_page_id = root_page_id_;
+    if(root_page_id == INVALID_PAGE_ID) return nullptr;
+    auto cur_raw_page = buffer_pool_manager_->FetchPage(root_page_id);
+    if(cur_raw_page == nullptr)
+      throw Exception(ExceptionType::EXCEPTION_TYPE_INDEX, "FindLeafPage: out of memory");
+    uint64_t version = cur_raw_page->ReadBegin();
+    if(root_page_id != root_page_id_) {
+      buffer_pool_manager_->UnpinFrame(cur_raw_page, false);
+      continue;
+    }
+
+    // search
+    while(true) {
+      BPlusTreePage* cur_page = reinterpret_cast<BPlusTreePage*>(cur_raw_page->GetData());
+      if(cur_page->IsLeafPage()) {
+        cur_raw_page->RLatch();
+        if(cur_raw_page->ReadValidate(version))
+          return cur_raw_page;
+        cur_raw_page->RUnlatch();
+        break;
+      }
+
+      // get child page id, the page may change under us, so check its size
+      // before looking into it
+      auto cur_in_page = reinterpret_cast<BPlusTreeInternalPage<KeyType, page_id_t,
+                                          KeyComparator>*>(cur_page);
+      page_id_t child_page_id = INVALID_PAGE_ID;
+      int size = cur_in_page->GetSize();
+      if(size > 1 && size <= cur_in_page->GetMaxSize()) {
+        if(leftMost)
+          child_page_id = cur_in_page->ValueAt(0);
+        else
+          child_page_id = cur_in_page->Lookup(key, comparator_);
+      }
+      if(!cur_raw_page->ReadValidate(version) || child_page_id == INVALID_PAGE_ID)
+        break;
+
+      // update cur page
+      auto child_raw_page = buffer_pool_manager_->FetchPage(child_page_id);
+      if(child_raw_page == nullptr) {
+        buffer_pool_manager_->UnpinFrame(cur_raw_page, false);
+        throw Exception(ExceptionType::EXCEPTION_TYPE_INDEX, "FindLeafPage: out of memory");
+      }
+      uint64_t child_version = child_raw_page->ReadBegin();
+      if(!cur_raw_page->ReadValidate(version)) {
+        buffer_pool_manager_->UnpinFrame(child_raw_page, false);
+        break;
+      }
+      buffer_pool_manager_->UnpinFrame(cur_raw_page, false);
+      cur_raw_page = child_raw_page;
+      version = child_version;
+    }
+
+    // restart
+    buffer_pool_manager_->UnpinFrame(cur_raw_page, false);
+  }
+}
+
 
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::LockPage(Page* page, Transaction* txn, Operation op){
@@ -652,10 +685,10 @@ void BPLUSTREE_TYPE::UnlockPage(Page* page, Transaction* txn, Operation op){
     }
     if(op == Operation::SEARCH){
         page->RUnlatch();
-        buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+        buffer_pool_manager_->UnpinFrame(page, false);
     }else{
         page->WUnlatch();
-        buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
+        buffer_pool_manager_->UnpinFrame(page, true);
     }
     if(txn != nullptr)
         txn->GetPageSet()->pop_front();
@@ -672,13 +705,13 @@ void BPLUSTREE_TYPE::UnlockAllPage(Transaction* txn, Operation op){
         if(front->GetPageId() != INVALID_PAGE_ID){
             if(op == Operation::SEARCH){
                 front->RUnlatch();
-                buffer_pool_manager_->UnpinPage(front->GetPageId(), false);
+                buffer_pool_manager_->UnpinFrame(front, false);
             }else{
                 if(front->GetPageId() == root_page_id_){
                     UnlockRoot();
                 }
                 front->WUnlatch(); 
-                buffer_pool_manager_->UnpinPage(front->GetPageId(), true);
+                buffer_pool_manager_->UnpinFrame(front, true);
             }
         }
         txn->GetPageSet()->pop_front();
@@ -702,13 +735,13 @@ void BPLUSTREE_TYPE::UnlockParentPage(Page* page, Transaction* txn, Operation op
             if(front->GetPageId() != INVALID_PAGE_ID){
                 if(op == Operation::SEARCH){
                     front->RUnlatch();
-                    buffer_pool_manager_->UnpinPage(front->GetPageId(), false);
+                    buffer_pool_manager_->UnpinFrame(front, false);
                 }else{
                     if(front->GetPageId() == root_page_id_){
                         UnlockRoot();
                     }
                     front->WUnlatch(); 
-                    buffer_pool_manager_->UnpinPage(front->GetPageId(), true);
+                    buffer_pool_manager_->UnpinFrame(front, true);
                 }
             }
             txn->GetPageSet()->pop_front();
@@ -727,15 +760,16 @@ void BPLUSTREE_TYPE::UnlockParentPage(Page* page, Transaction* txn, Operation op
  */
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::UpdateRootPageId(int insert_record) {
-  HeaderPage *header_page = static_cast<HeaderPage *>(
-      buffer_pool_manager_->FetchPage(HEADER_PAGE_ID));
+  WritePageGuard header_guard =
+      buffer_pool_manager_->FetchPageWrite(HEADER_PAGE_ID);
+  HeaderPage *header_page = static_cast<HeaderPage *>(header_guard.GetPage());
   if (insert_record)
     // create a new record<index_name + root_page_id> in header_page
     header_page->InsertRecord(index_name_, root_page_id_);
   else
     // update root_page_id in header_page
     header_page->UpdateRecord(index_name_, root_page_id_);
-  buffer_pool_manager_->UnpinPage(HEADER_PAGE_ID, true);
+  header_guard.MarkDirty();
 }
 
 /*
@@ -791,6 +825,12 @@ std::string BPLUSTREE_TYPE::ToString(bool verbose) {
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::InsertFromFile(const std::string &file_name,
                                     Transaction *transaction) {
+  BufferAccessStrategy strategy(BULK_WRITE_RING_SIZE);
+  bool own_strategy = transaction != nullptr &&
+                      transaction->GetBufferAccessStrategy() == nullptr;
+  if (own_strategy) {
+    transaction->SetBufferAccessStrategy(&strategy);
+  }
   int64_t key;
   std::ifstream input(file_name);
   while (input) {
@@ -801,6 +841,9 @@ void BPLUSTREE_TYPE::InsertFromFile(const std::string &file_name,
     RID rid(key);
     Insert(index_key, rid, transaction);
   }
+  if (own_strategy) {
+    transaction->SetBufferAccessStrategy(nullptr);
+  }
 }
 /*
  * This method is used for test only
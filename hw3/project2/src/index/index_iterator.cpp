@@ -14,7 +14,8 @@ namespace scudb {
 INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE::IndexIterator(page_id_t page_id, int index, BufferPoolManager* buffer_pool_manager):
     index_(index),
-    buffer_pool_manager_(buffer_pool_manager){
+    buffer_pool_manager_(buffer_pool_manager),
+    readahead_(buffer_pool_manager){
         auto leaf_raw_page = buffer_pool_manager_->FetchPage(page_id);
         B_PLUS_TREE_LEAF_PAGE_TYPE* leaf_page = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE*>(leaf_raw_page->GetData());
         leaf_page_ = leaf_page;
@@ -46,6 +47,8 @@ INDEXITERATOR_TYPE& INDEXITERATOR_TYPE::operator++(){
     index_++;
     if(index_ >= leaf_page_->GetSize()){
         if(leaf_page_->GetNextPageId() != INVALID_PAGE_ID){
+            readahead_.Advance(leaf_page_->GetPageId(), leaf_page_->GetNextPageId());
+
             // unpin page
             buffer_pool_manager_->UnpinPage(leaf_page_->GetPageId(), false);
 
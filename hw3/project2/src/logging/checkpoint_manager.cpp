@@ -0,0 +1,123 @@
+/**
+ * checkpoint_manager.cpp
+ */
+
+#include "logging/checkpoint_manager.h"
+#include "page/header_page.h"
+
+namespace scudb {
+
+/*
+ * 1. Log B and read the active transaction table, see BeginCheckpoint().
+ * 2. Read the dirty page table, every change not in it is written back.
+ * 3. Log the end records and wait until they are persistent.
+ * 4. Sync db file, so that pages written back so far survive a crash, then
+ * point the header page at the checkpoint and sync again.
+ * 5. Give back the log before the log start. If the log start precedes
+ * what this log manager wrote, the one of the last checkpoint is kept.
+ */
+lsn_t CheckpointManager::Checkpoint() {
+  if (!ENABLE_LOGGING) {
+    return INVALID_LSN;
+  }
+  std::lock_guard<std::mutex> lck(checkpoint_latch_);
+  std::vector<std::pair<txn_id_t, lsn_t>> active_txns;
+  lsn_t start_lsn;
+  lsn_t begin_lsn =
+      transaction_manager_->BeginCheckpoint(active_txns, start_lsn);
+  std::vector<std::pair<page_id_t, lsn_t>> dirty_pages =
+      buffer_pool_manager_->GetDirtyPageTable();
+  if (start_lsn == INVALID_LSN || begin_lsn < start_lsn) {
+    start_lsn = begin_lsn;
+  }
+  for (auto &entry : dirty_pages) {
+    start_lsn = std::min(start_lsn, entry.second);
+  }
+
+  // header, both counts, then 8 bytes per entry
+  size_t max_entries = (log_manager_->GetLogBufferSize() - 20 - 8) / 8;
+  lsn_t first_end_lsn = INVALID_LSN;
+  lsn_t end_lsn = INVALID_LSN;
+  size_t txn_pos = 0;
+  size_t page_pos = 0;
+  do {
+    size_t num_txns = std::min(active_txns.size() - txn_pos, max_entries);
+    size_t num_pages =
+        std::min(dirty_pages.size() - page_pos, max_entries - num_txns);
+    LogRecord log_record(
+        begin_lsn, LogRecordType::END_CHECKPOINT,
+        std::vector<std::pair<txn_id_t, lsn_t>>(
+            active_txns.begin() + txn_pos,
+            active_txns.begin() + txn_pos + num_txns),
+        std::vector<std::pair<page_id_t, lsn_t>>(
+            dirty_pages.begin() + page_pos,
+            dirty_pages.begin() + page_pos + num_pages));
+    end_lsn = log_manager_->AppendLogRecord(log_record);
+    if (first_end_lsn == INVALID_LSN) {
+      first_end_lsn = end_lsn;
+    }
+    txn_pos += num_txns;
+    page_pos += num_pages;
+  } while (txn_pos < active_txns.size() || page_pos < dirty_pages.size());
+  log_manager_->WaitForFlush(end_lsn);
+
+  off_t checkpoint_offset = log_manager_->GetLogOffset(first_end_lsn);
+  off_t log_start = log_manager_->GetLogOffset(start_lsn);
+  disk_manager_->Sync();
+  {
+    WritePageGuard guard =
+        buffer_pool_manager_->FetchPageWrite(HEADER_PAGE_ID);
+    if (!guard) {
+      return INVALID_LSN;
+    }
+    HeaderPage *header_page = static_cast<HeaderPage *>(guard.GetPage());
+    if (log_start < 0) {
+      log_start = header_page->GetLogStart();
+    }
+    header_page->SetLogStart(log_start);
+    header_page->SetCheckpoint(checkpoint_offset, end_lsn);
+    guard.MarkDirty();
+  }
+  buffer_pool_manager_->FlushPage(HEADER_PAGE_ID);
+  disk_manager_->Sync();
+  log_manager_->TruncateLog(log_start);
+  return end_lsn;
+}
+
+void CheckpointManager::RunCheckpointThread(
+    std::chrono::milliseconds interval) {
+  std::lock_guard<std::mutex> lck(latch_);
+  if (checkpoint_thread_ != nullptr) {
+    return;
+  }
+  interval_ = interval;
+  checkpoint_running_ = true;
+  checkpoint_thread_ =
+      new std::thread(&CheckpointManager::CheckpointLoop, this);
+}
+
+void CheckpointManager::StopCheckpointThread() {
+  {
+    std::lock_guard<std::mutex> lck(latch_);
+    if (checkpoint_thread_ == nullptr) {
+      return;
+    }
+    checkpoint_running_ = false;
+    cv_.notify_one();
+  }
+  checkpoint_thread_->join();
+  delete checkpoint_thread_;
+  checkpoint_thread_ = nullptr;
+}
+
+void CheckpointManager::CheckpointLoop() {
+  std::unique_lock<std::mutex> lck(latch_);
+  while (!cv_.wait_for(lck, interval_,
+                       [this] { return !checkpoint_running_; })) {
+    lck.unlock();
+    Checkpoint();
+    lck.lock();
+  }
+}
+
+} // namespace scudb
@@ -2,6 +2,8 @@
  * log_manager.cpp
  */
 
+#include <thread>
+
 #include "logging/log_manager.h"
 
 namespace scudb {
@@ -12,35 +14,296 @@ namespace scudb {
  * manager wants to force flush (it only happens when the flushed page has a
  * larger LSN than persistent LSN)
  */
-void LogManager::RunFlushThread() {}
+void LogManager::RunFlushThread() {
+  std::lock_guard<std::mutex> lck(latch_);
+  if (flush_thread_ != nullptr)
+    return;
+  ENABLE_LOGGING = true;
+  flush_thread_running_ = true;
+  flush_thread_ = new std::thread(&LogManager::FlushLoop, this);
+}
+
 /*
  * Stop and join the flush thread, set ENABLE_LOGGING = false
+ * What is left in the log buffer is written before the thread exits
+ */
+void LogManager::StopFlushThread() {
+  {
+    std::lock_guard<std::mutex> lck(latch_);
+    if (flush_thread_ == nullptr)
+      return;
+    flush_thread_running_ = false;
+  }
+  cv_.notify_one();
+  flush_thread_->join();
+  delete flush_thread_;
+  flush_thread_ = nullptr;
+  ENABLE_LOGGING = false;
+}
+
+/*
+ * Write the buffer every LOG_TIMEOUT, by the deadline of an async commit, or
+ * as soon as an appender runs out of room or a committer waits. Everything
+ * appended while a write was going on goes out with the next single write.
+ */
+void LogManager::FlushLoop() {
+  std::unique_lock<std::mutex> lck(latch_);
+  while (flush_thread_running_) {
+    std::chrono::steady_clock::time_point timeout =
+        std::chrono::steady_clock::now() + LOG_TIMEOUT;
+    while (flush_thread_running_ && !flush_requested_) {
+      // the deadline may be brought forward while waiting
+      auto deadline = std::min(timeout, GetFlushDeadline());
+      if (std::chrono::steady_clock::now() >= deadline) {
+        break;
+      }
+      cv_.wait_until(lck, deadline);
+    }
+    FlushBuffer(lck);
+  }
+  FlushBuffer(lck);
+}
+
+std::chrono::steady_clock::time_point LogManager::GetFlushDeadline() {
+  int64_t ticks = flush_deadline_.load();
+  if (ticks == 0) {
+    return std::chrono::steady_clock::time_point::max();
+  }
+  return std::chrono::steady_clock::time_point(
+      std::chrono::steady_clock::duration(ticks));
+}
+
+/*
+ * Only the first async commit after a write sets the deadline, later ones
+ * are covered by it. The flush thread is told under latch_ so that it does
+ * not miss the new deadline between reading it and going to sleep.
+ */
+void LogManager::ScheduleFlush() {
+  if (flush_deadline_.load() != 0) {
+    return;
+  }
+  int64_t ticks = (std::chrono::steady_clock::now() + ASYNC_COMMIT_LAG)
+                      .time_since_epoch()
+                      .count();
+  int64_t none = 0;
+  if (flush_deadline_.compare_exchange_strong(none, ticks)) {
+    std::lock_guard<std::mutex> lck(latch_);
+    cv_.notify_one();
+  }
+}
+
+void LogManager::RequestFlush(std::unique_lock<std::mutex> &lck) {
+  if (flush_thread_running_) {
+    flush_requested_ = true;
+    cv_.notify_one();
+    flushed_cv_.wait(lck);
+  } else if (!flushing_) {
+    FlushBuffer(lck);
+  } else {
+    flushed_cv_.wait(lck);
+  }
+}
+
+/*
+ * Appenders switch to the other buffer as soon as the reservation word is
+ * swapped, the records reserved before the swap may still be serialized.
+ * They are waited for before the write, the buffer is only written once its
+ * whole reserved prefix is completed.
+ */
+void LogManager::FlushBuffer(std::unique_lock<std::mutex> &lck) {
+  flush_requested_ = false;
+  // cleared before the swap, a record appended after the swap sets it again
+  flush_deadline_ = 0;
+  uint64_t reservation = reservation_.load();
+  uint64_t swapped;
+  do {
+    if (ReservedBytes(reservation) == 0) {
+      // every record before this lsn went out with an earlier write
+      persistent_lsn_ = ReservedLSN(reservation) - 1;
+      flushed_cv_.notify_all();
+      return;
+    }
+    swapped = (reservation & ~(RESERVED_LSN - 1)) |
+              (ReservedBuffer(reservation) ? 0 : RESERVED_BUFFER);
+  } while (!reservation_.compare_exchange_weak(reservation, swapped));
+
+  flushing_ = true;
+  write_offsets_.emplace_back(buffer_lsn_, log_offset_);
+  buffer_lsn_ = ReservedLSN(reservation);
+  lck.unlock();
+  int index = ReservedBuffer(reservation);
+  size_t size = ReservedBytes(reservation);
+  while (completed_[index].load(std::memory_order_acquire) != size) {
+    std::this_thread::yield();
+  }
+  disk_manager_->WriteLog(buffers_[index], size);
+  completed_[index].store(0, std::memory_order_relaxed);
+  lck.lock();
+  log_offset_ += size;
+  flushing_ = false;
+  persistent_lsn_ = ReservedLSN(reservation) - 1;
+  flushed_cv_.notify_all();
+}
+
+/*
+ * The latest write starting at or before lsn holds it
  */
-void LogManager::StopFlushThread() {}
+off_t LogManager::GetLogOffset(lsn_t lsn) {
+  std::lock_guard<std::mutex> lck(latch_);
+  auto it = std::upper_bound(
+      write_offsets_.begin(), write_offsets_.end(), lsn,
+      [](lsn_t value, const std::pair<lsn_t, off_t> &entry) {
+        return value < entry.first;
+      });
+  if (it == write_offsets_.begin()) {
+    return -1;
+  }
+  return (--it)->second;
+}
+
+/*
+ * Writes entirely before offset are forgotten
+ */
+void LogManager::TruncateLog(off_t offset) {
+  disk_manager_->TruncateLog(offset);
+  std::lock_guard<std::mutex> lck(latch_);
+  while (write_offsets_.size() > 1 && write_offsets_[1].second <= offset) {
+    write_offsets_.pop_front();
+  }
+}
+
+void LogManager::SetNextLSN(lsn_t lsn) {
+  std::lock_guard<std::mutex> lck(latch_);
+  assert(ReservedBytes(reservation_.load()) == 0);
+  uint64_t buffer = reservation_.load() & RESERVED_BUFFER;
+  reservation_ = (static_cast<uint64_t>(lsn) << 32) | buffer;
+  buffer_lsn_ = lsn;
+  persistent_lsn_ = lsn - 1;
+}
+
+/*
+ * Committers waiting at the same time share one write, see FlushLoop()
+ */
+void LogManager::WaitForFlush(lsn_t lsn) {
+  std::unique_lock<std::mutex> lck(latch_);
+  while (persistent_lsn_ < lsn) {
+    RequestFlush(lck);
+  }
+}
 
 /*
  * append a log record into log buffer
  * you MUST set the log record's lsn within this method
  * @return: lsn that is assigned to this log record
- *
- *
- * example below
- * // First, serialize the must have fields(20 bytes in total)
- * log_record.lsn_ = next_lsn_++;
- * memcpy(log_buffer_ + offset_, &log_record, 20);
- * int pos = offset_ + 20;
- *
- * if (log_record.log_record_type_ == LogRecordType::INSERT) {
- *    memcpy(log_buffer_ + pos, &log_record.insert_rid_, sizeof(RID));
- *    pos += sizeof(RID);
- *    // we have provided serialize function for tuple class
- *    log_record.insert_tuple_.SerializeTo(log_buffer_ + pos);
- *  }
- *
+ * The lsn and the bytes of the record are reserved together by one
+ * compare-and-swap, so LSNs are given in the order records are placed in the
+ * log and no lock is taken. Only if the record does not fit, latch_ is taken
+ * to have the buffer written first.
  */
 lsn_t LogManager::AppendLogRecord(LogRecord &log_record) {
+  size_t size = static_cast<size_t>(log_record.size_);
+  assert(size <= log_buffer_size_);
+  uint64_t reservation = reservation_.load();
+  while (true) {
+    if (ReservedBytes(reservation) + size > log_buffer_size_) {
+      std::unique_lock<std::mutex> lck(latch_);
+      reservation = reservation_.load();
+      while (ReservedBytes(reservation) + size > log_buffer_size_) {
+        RequestFlush(lck);
+        reservation = reservation_.load();
+      }
+    }
+    if (reservation_.compare_exchange_weak(reservation,
+                                           reservation + RESERVED_LSN + size)) {
+      break;
+    }
+  }
+
+  int index = ReservedBuffer(reservation);
+  log_record.lsn_ = ReservedLSN(reservation);
+  SerializeLogRecord(log_record, buffers_[index] + ReservedBytes(reservation));
+  completed_[index].fetch_add(size, std::memory_order_release);
+  return log_record.lsn_;
+}
+
+/*
+ * Layout of each record type is described in log_record.h
+ */
+void LogManager::SerializeLogRecord(LogRecord &log_record, char *data) {
+  // the must have fields(20 bytes in total), see
+  // LogRecovery::DeserializeHeader()
+  int pos = 0;
+  memcpy(data + pos, &log_record.size_, sizeof(int32_t));
+  pos += sizeof(int32_t);
+  memcpy(data + pos, &log_record.lsn_, sizeof(lsn_t));
+  pos += sizeof(lsn_t);
+  memcpy(data + pos, &log_record.txn_id_, sizeof(txn_id_t));
+  pos += sizeof(txn_id_t);
+  memcpy(data + pos, &log_record.prev_lsn_, sizeof(lsn_t));
+  pos += sizeof(lsn_t);
+  memcpy(data + pos, &log_record.log_record_type_, sizeof(LogRecordType));
+  pos += sizeof(LogRecordType);
+
+  switch (log_record.GetRedoType()) {
+  case LogRecordType::INSERT:
+    pos += SerializeRID(log_record, log_record.insert_rid_, data + pos);
+    log_record.insert_tuple_.SerializeTo(data + pos);
+    break;
+  case LogRecordType::MARKDELETE:
+  case LogRecordType::APPLYDELETE:
+  case LogRecordType::ROLLBACKDELETE:
+    pos += SerializeRID(log_record, log_record.delete_rid_, data + pos);
+    log_record.delete_tuple_.SerializeTo(data + pos);
+    break;
+  case LogRecordType::UPDATE:
+    pos += SerializeRID(log_record, log_record.update_rid_, data + pos);
+    log_record.old_tuple_.SerializeTo(data + pos);
+    pos += sizeof(int32_t) + log_record.old_tuple_.GetLength();
+    log_record.new_tuple_.SerializeTo(data + pos);
+    break;
+  case LogRecordType::NEWPAGE:
+    memcpy(data + pos, &log_record.prev_page_id_, sizeof(page_id_t));
+    pos += sizeof(page_id_t);
+    memcpy(data + pos, &log_record.page_id_, sizeof(page_id_t));
+    break;
+  case LogRecordType::END_CHECKPOINT: {
+    int32_t count = static_cast<int32_t>(log_record.active_txns_.size());
+    memcpy(data + pos, &count, sizeof(int32_t));
+    pos += sizeof(int32_t);
+    for (auto &entry : log_record.active_txns_) {
+      memcpy(data + pos, &entry.first, sizeof(txn_id_t));
+      pos += sizeof(txn_id_t);
+      memcpy(data + pos, &entry.second, sizeof(lsn_t));
+      pos += sizeof(lsn_t);
+    }
+    count = static_cast<int32_t>(log_record.dirty_pages_.size());
+    memcpy(data + pos, &count, sizeof(int32_t));
+    pos += sizeof(int32_t);
+    for (auto &entry : log_record.dirty_pages_) {
+      memcpy(data + pos, &entry.first, sizeof(page_id_t));
+      pos += sizeof(page_id_t);
+      memcpy(data + pos, &entry.second, sizeof(lsn_t));
+      pos += sizeof(lsn_t);
+    }
+    break;
+  }
+  default:
+    break;
+  }
+}
 
-  return INVALID_LSN;
+int LogManager::SerializeRID(const LogRecord &log_record, const RID &rid,
+                             char *data) {
+  int pos = 0;
+  memcpy(data + pos, &rid, sizeof(RID));
+  pos += sizeof(RID);
+  if (log_record.log_record_type_ == LogRecordType::CLR) {
+    memcpy(data + pos, &log_record.undo_next_lsn_, sizeof(lsn_t));
+    pos += sizeof(lsn_t);
+    memcpy(data + pos, &log_record.clr_type_, sizeof(LogRecordType));
+    pos += sizeof(LogRecordType);
+  }
+  return pos;
 }
 
 } // namespace scudb
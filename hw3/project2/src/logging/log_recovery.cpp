@@ -2,18 +2,209 @@
  * log_recovey.cpp
  */
 
+#include <queue>
+#include <thread>
+
 #include "logging/log_recovery.h"
+#include "page/header_page.h"
 #include "page/table_page.h"
 
 namespace scudb {
+/*
+ * read the 5 fields every record starts with, data must hold HEADER_SIZE
+ * bytes
+ */
+void LogRecovery::DeserializeHeader(const char *data, LogRecord &log_record) {
+  int pos = 0;
+  memcpy(&log_record.size_, data + pos, sizeof(int32_t));
+  pos += sizeof(int32_t);
+  memcpy(&log_record.lsn_, data + pos, sizeof(lsn_t));
+  pos += sizeof(lsn_t);
+  memcpy(&log_record.txn_id_, data + pos, sizeof(txn_id_t));
+  pos += sizeof(txn_id_t);
+  memcpy(&log_record.prev_lsn_, data + pos, sizeof(lsn_t));
+  pos += sizeof(lsn_t);
+  memcpy(&log_record.log_record_type_, data + pos, sizeof(LogRecordType));
+}
+
+/*
+ * read the rid a tuple record starts with, a CLR has its undo-next LSN and
+ * type after it
+ */
+int LogRecovery::DeserializeRID(const char *data, RID &rid,
+                                LogRecord &log_record) {
+  int pos = 0;
+  memcpy(&rid, data + pos, sizeof(RID));
+  pos += sizeof(RID);
+  if (log_record.log_record_type_ == LogRecordType::CLR) {
+    memcpy(&log_record.undo_next_lsn_, data + pos, sizeof(lsn_t));
+    pos += sizeof(lsn_t);
+    memcpy(&log_record.clr_type_, data + pos, sizeof(LogRecordType));
+    pos += sizeof(LogRecordType);
+  }
+  return pos;
+}
+
 /*
  * deserialize a log record from log buffer
  * @return: true means deserialize succeed, otherwise can't deserialize cause
  * incomplete log record
  */
-bool LogRecovery::DeserializeLogRecord(const char *data,
+bool LogRecovery::DeserializeLogRecord(const char *data, int size,
                                              LogRecord &log_record) {
-  return false;
+  if (size < LogRecord::HEADER_SIZE) {
+    return false;
+  }
+  // the must have fields(20 bytes in total)
+  DeserializeHeader(data, log_record);
+  if (log_record.size_ < LogRecord::HEADER_SIZE || log_record.size_ > size ||
+      log_record.log_record_type_ <= LogRecordType::INVALID ||
+      log_record.log_record_type_ > LogRecordType::CLR) {
+    return false;
+  }
+  int pos = LogRecord::HEADER_SIZE;
+  if (log_record.log_record_type_ == LogRecordType::CLR) {
+    // the type of the record it redoes like decides the layout
+    int type_pos = pos + sizeof(RID) + sizeof(lsn_t);
+    if (type_pos + static_cast<int>(sizeof(LogRecordType)) >
+        log_record.size_) {
+      return false;
+    }
+    memcpy(&log_record.clr_type_, data + type_pos, sizeof(LogRecordType));
+    if (log_record.clr_type_ < LogRecordType::INSERT ||
+        log_record.clr_type_ > LogRecordType::UPDATE) {
+      return false;
+    }
+  }
+
+  switch (log_record.GetRedoType()) {
+  case LogRecordType::INSERT:
+    pos += DeserializeRID(data + pos, log_record.insert_rid_, log_record);
+    log_record.insert_tuple_.DeserializeFrom(data + pos);
+    break;
+  case LogRecordType::MARKDELETE:
+  case LogRecordType::APPLYDELETE:
+  case LogRecordType::ROLLBACKDELETE:
+    pos += DeserializeRID(data + pos, log_record.delete_rid_, log_record);
+    log_record.delete_tuple_.DeserializeFrom(data + pos);
+    break;
+  case LogRecordType::UPDATE:
+    pos += DeserializeRID(data + pos, log_record.update_rid_, log_record);
+    log_record.old_tuple_.DeserializeFrom(data + pos);
+    pos += sizeof(int32_t) + log_record.old_tuple_.GetLength();
+    log_record.new_tuple_.DeserializeFrom(data + pos);
+    break;
+  case LogRecordType::NEWPAGE:
+    memcpy(&log_record.prev_page_id_, data + pos, sizeof(page_id_t));
+    pos += sizeof(page_id_t);
+    memcpy(&log_record.page_id_, data + pos, sizeof(page_id_t));
+    break;
+  case LogRecordType::END_CHECKPOINT: {
+    int32_t count;
+    memcpy(&count, data + pos, sizeof(int32_t));
+    pos += sizeof(int32_t);
+    if (count < 0 || pos + count * 8 + 4 > log_record.size_) {
+      return false;
+    }
+    log_record.active_txns_.resize(count);
+    for (auto &entry : log_record.active_txns_) {
+      memcpy(&entry.first, data + pos, sizeof(txn_id_t));
+      pos += sizeof(txn_id_t);
+      memcpy(&entry.second, data + pos, sizeof(lsn_t));
+      pos += sizeof(lsn_t);
+    }
+    memcpy(&count, data + pos, sizeof(int32_t));
+    pos += sizeof(int32_t);
+    if (count < 0 || pos + count * 8 > log_record.size_) {
+      return false;
+    }
+    log_record.dirty_pages_.resize(count);
+    for (auto &entry : log_record.dirty_pages_) {
+      memcpy(&entry.first, data + pos, sizeof(page_id_t));
+      pos += sizeof(page_id_t);
+      memcpy(&entry.second, data + pos, sizeof(lsn_t));
+      pos += sizeof(lsn_t);
+    }
+    break;
+  }
+  default:
+    break;
+  }
+  return true;
+}
+
+bool LogRecovery::ReadLogRecord(off_t offset, std::vector<char> &data) {
+  int32_t size;
+  if (!disk_manager_->ReadLog(reinterpret_cast<char *>(&size),
+                              sizeof(int32_t), offset) ||
+      size < LogRecord::HEADER_SIZE) {
+    return false;
+  }
+  data.resize(size);
+  return disk_manager_->ReadLog(data.data(), size, offset);
+}
+
+/*
+ * The header page is trusted only if its offsets lie within the log. The
+ * end records of the checkpoint are searched from its offset, a checkpoint
+ * whose last end record is not found is ignored, redo then reads from the
+ * log start
+ */
+off_t LogRecovery::ReadCheckpoint() {
+  checkpoint_lsn_ = INVALID_LSN;
+  dirty_pages_.clear();
+  if (!disk_manager_->IsAllocated(HEADER_PAGE_ID)) {
+    return 0;
+  }
+  off_t log_start;
+  off_t offset;
+  lsn_t end_lsn;
+  {
+    ReadPageGuard guard = buffer_pool_manager_->FetchPageRead(HEADER_PAGE_ID);
+    assert(guard);
+    auto header_page = static_cast<HeaderPage *>(guard.GetPage());
+    log_start = header_page->GetLogStart();
+    offset = header_page->GetCheckpointOffset();
+    end_lsn = header_page->GetCheckpointLSN();
+  }
+  off_t log_size = disk_manager_->GetLogFileSize();
+  if (log_start < 0 || log_start > log_size) {
+    return 0;
+  }
+  if (end_lsn == INVALID_LSN || offset < log_start || offset >= log_size) {
+    return log_start;
+  }
+
+  std::vector<char> data;
+  std::unordered_map<page_id_t, lsn_t> dirty_pages;
+  while (ReadLogRecord(offset, data)) {
+    LogRecord log_record;
+    if (!DeserializeLogRecord(data.data(), data.size(), log_record) ||
+        log_record.lsn_ > end_lsn) {
+      break;
+    }
+    if (log_record.log_record_type_ == LogRecordType::END_CHECKPOINT) {
+      for (auto &entry : log_record.dirty_pages_) {
+        dirty_pages[entry.first] = entry.second;
+      }
+      if (log_record.lsn_ == end_lsn) {
+        checkpoint_lsn_ = log_record.prev_lsn_;
+        dirty_pages_ = std::move(dirty_pages);
+        next_lsn_ = std::max(next_lsn_, end_lsn + 1);
+        break;
+      }
+    }
+    offset += log_record.size_;
+  }
+  return log_start;
+}
+
+bool LogRecovery::NeedsRedo(page_id_t page_id, lsn_t lsn) const {
+  if (checkpoint_lsn_ == INVALID_LSN || lsn >= checkpoint_lsn_) {
+    return true;
+  }
+  auto it = dirty_pages_.find(page_id);
+  return it != dirty_pages_.end() && it->second <= lsn;
 }
 
 /*
@@ -22,13 +213,372 @@ bool LogRecovery::DeserializeLogRecord(const char *data,
  *log buffer to reduce unnecessary I/O operations), remember to compare page's
  *LSN with log_record's sequence number, and also build active_txn_ table &
  *lsn_mapping_ table
+ * This thread only parses headers: it keeps both tables and copies every
+ * record that touches a page to the batch of the worker owning the page.
+ * Workers deserialize and replay the records. A NEWPAGE record touches the
+ * new page and the page linked to it, it goes to the workers of both.
  */
-void LogRecovery::Redo() {}
+void LogRecovery::Redo() {
+  assert(!ENABLE_LOGGING);
+  std::unique_ptr<RedoQueue[]> queues(new RedoQueue[num_workers_]);
+  std::vector<std::vector<char>> batches(num_workers_);
+  std::vector<std::thread> workers;
+  for (size_t i = 0; i < num_workers_; ++i) {
+    workers.push_back(
+        std::thread(&LogRecovery::RedoLoop, this, i, &queues[i]));
+  }
+
+  active_txn_.clear();
+  lsn_mapping_.clear();
+  next_lsn_ = 0;
+  offset_ = ReadCheckpoint();
+  size_t size = 0; // bytes of log_buffer_ read from the log
+  size_t pos = 0;  // next record in log_buffer_
+  while (true) {
+    LogRecord header;
+    bool complete = pos + LogRecord::HEADER_SIZE <= size;
+    if (complete) {
+      DeserializeHeader(log_buffer_ + pos, header);
+      complete = header.size_ >= LogRecord::HEADER_SIZE &&
+                 pos + header.size_ <= size;
+    }
+    if (!complete) {
+      // a record that does not fit in the whole buffer is torn
+      if (pos == 0 && size == log_buffer_size_) {
+        break;
+      }
+      // keep the partial record and read what follows it
+      memmove(log_buffer_, log_buffer_ + pos, size - pos);
+      offset_ += pos;
+      size -= pos;
+      pos = 0;
+      if (!disk_manager_->ReadLog(log_buffer_ + size, log_buffer_size_ - size,
+                                  offset_ + size)) {
+        break;
+      }
+      // the part after end of log is zeroed, a record of size 0 ends it
+      size = log_buffer_size_;
+      if (*reinterpret_cast<int32_t *>(log_buffer_) == 0) {
+        break;
+      }
+      continue;
+    }
+
+    const char *data = log_buffer_ + pos;
+    lsn_mapping_[header.lsn_] = offset_ + pos;
+    next_lsn_ = std::max(next_lsn_, header.lsn_ + 1);
+    switch (header.log_record_type_) {
+    case LogRecordType::BEGIN:
+      active_txn_[header.txn_id_] = header.lsn_;
+      break;
+    case LogRecordType::COMMIT:
+    case LogRecordType::ABORT:
+      active_txn_.erase(header.txn_id_);
+      break;
+    case LogRecordType::BEGIN_CHECKPOINT:
+    case LogRecordType::END_CHECKPOINT:
+      break;
+    default: {
+      active_txn_[header.txn_id_] = header.lsn_;
+      // the rid of a tuple record and prev_page_id of a NEWPAGE record come
+      // first, both start with a page id
+      page_id_t page_ids[2];
+      memcpy(page_ids, data + LogRecord::HEADER_SIZE, sizeof(page_ids));
+      size_t first = GetWorker(page_ids[0]);
+      bool first_sent = page_ids[0] != INVALID_PAGE_ID &&
+                        NeedsRedo(page_ids[0], header.lsn_);
+      if (first_sent) {
+        batches[first].insert(batches[first].end(), data, data + header.size_);
+      }
+      if (header.log_record_type_ == LogRecordType::NEWPAGE &&
+          NeedsRedo(page_ids[1], header.lsn_) &&
+          (!first_sent || GetWorker(page_ids[1]) != first)) {
+        size_t second = GetWorker(page_ids[1]);
+        batches[second].insert(batches[second].end(), data,
+                               data + header.size_);
+      }
+      break;
+    }
+    }
+    pos += header.size_;
+
+    for (size_t i = 0; i < num_workers_; ++i) {
+      if (batches[i].size() >= REDO_BATCH_SIZE) {
+        HandOver(&queues[i], batches[i]);
+      }
+    }
+  }
+
+  for (size_t i = 0; i < num_workers_; ++i) {
+    if (!batches[i].empty()) {
+      HandOver(&queues[i], batches[i]);
+    }
+    {
+      std::lock_guard<std::mutex> lck(queues[i].latch);
+      queues[i].done = true;
+    }
+    queues[i].cv.notify_all();
+  }
+  for (auto &worker : workers) {
+    worker.join();
+  }
+}
+
+void LogRecovery::HandOver(RedoQueue *queue, std::vector<char> &batch) {
+  // the records are on disk already, the pool may write the pages they
+  // change without waiting for the log
+  if (log_manager_ != nullptr) {
+    log_manager_->SetNextLSN(next_lsn_);
+  }
+  {
+    std::unique_lock<std::mutex> lck(queue->latch);
+    queue->cv.wait(lck, [queue] {
+      return queue->batches.size() < REDO_QUEUE_DEPTH;
+    });
+    queue->batches.push_back(std::move(batch));
+  }
+  queue->cv.notify_all();
+  batch.clear();
+  batch.reserve(REDO_BATCH_SIZE);
+}
+
+void LogRecovery::RedoLoop(size_t worker, RedoQueue *queue) {
+  while (true) {
+    std::vector<char> batch;
+    {
+      std::unique_lock<std::mutex> lck(queue->latch);
+      queue->cv.wait(lck,
+                     [queue] { return !queue->batches.empty() || queue->done; });
+      if (queue->batches.empty()) {
+        return;
+      }
+      batch = std::move(queue->batches.front());
+      queue->batches.pop_front();
+    }
+    queue->cv.notify_all();
+
+    size_t pos = 0;
+    while (pos < batch.size()) {
+      LogRecord log_record;
+      bool complete = DeserializeLogRecord(batch.data() + pos,
+                                           batch.size() - pos, log_record);
+      assert(complete);
+      (void)complete;
+      RedoLogRecord(worker, log_record);
+      pos += log_record.size_;
+    }
+  }
+}
+
+/*
+ * A page whose header does not carry its own page id was never written, its
+ * LSN means nothing and every record is replayed on it
+ */
+void LogRecovery::RedoLogRecord(size_t worker, LogRecord &log_record) {
+  page_id_t page_ids[2];
+  int num_pages = 1;
+  switch (log_record.GetRedoType()) {
+  case LogRecordType::INSERT:
+    page_ids[0] = log_record.insert_rid_.GetPageId();
+    break;
+  case LogRecordType::MARKDELETE:
+  case LogRecordType::APPLYDELETE:
+  case LogRecordType::ROLLBACKDELETE:
+    page_ids[0] = log_record.delete_rid_.GetPageId();
+    break;
+  case LogRecordType::UPDATE:
+    page_ids[0] = log_record.update_rid_.GetPageId();
+    break;
+  case LogRecordType::NEWPAGE:
+    page_ids[0] = log_record.page_id_;
+    page_ids[1] = log_record.prev_page_id_;
+    num_pages = page_ids[1] == INVALID_PAGE_ID ? 1 : 2;
+    break;
+  default:
+    return;
+  }
+
+  for (int i = 0; i < num_pages; ++i) {
+    if (GetWorker(page_ids[i]) != worker) {
+      continue;
+    }
+    WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(page_ids[i]);
+    assert(guard);
+    auto page = static_cast<TablePage *>(guard.GetPage());
+    if (page->GetPageId() == page_ids[i] &&
+        page->GetLSN() >= log_record.lsn_) {
+      continue;
+    }
+
+    RID rid;
+    Tuple old_tuple;
+    switch (log_record.GetRedoType()) {
+    case LogRecordType::INSERT:
+      if (log_record.log_record_type_ == LogRecordType::CLR) {
+        page->RestoreTuple(log_record.insert_tuple_, log_record.insert_rid_);
+        break;
+      }
+      page->InsertTuple(log_record.insert_tuple_, rid, nullptr, nullptr,
+                        nullptr);
+      assert(rid == log_record.insert_rid_);
+      break;
+    case LogRecordType::MARKDELETE:
+      page->MarkDelete(log_record.delete_rid_, nullptr, nullptr, nullptr);
+      break;
+    case LogRecordType::APPLYDELETE:
+      page->ApplyDelete(log_record.delete_rid_, nullptr, nullptr);
+      break;
+    case LogRecordType::ROLLBACKDELETE:
+      page->RollbackDelete(log_record.delete_rid_, nullptr, nullptr);
+      break;
+    case LogRecordType::UPDATE:
+      page->UpdateTuple(log_record.new_tuple_, old_tuple,
+                        log_record.update_rid_, nullptr, nullptr, nullptr);
+      break;
+    default:
+      if (i == 0) {
+        page->Init(page_ids[0], buffer_pool_manager_->GetPageSize(),
+                   log_record.prev_page_id_, nullptr, nullptr);
+      } else {
+        page->SetNextPageId(log_record.page_id_);
+      }
+      break;
+    }
+    page->SetLSN(log_record.lsn_);
+    guard.MarkDirty();
+  }
+}
 
 /*
  *undo phase on TABLE PAGE level(table/table_page.h)
  *iterate through active txn map and undo each operation
+ * The records of all the active transactions are undone together, newest
+ * first. Each one undone is compensated by a CLR chained to the transaction,
+ * whose undo-next LSN is the record before it. After a crash the CLRs are
+ * redone, and undo skips from the last one to its undo-next LSN, so nothing
+ * is undone twice. The log is forced once, with the ABORT records, before
+ * the pages are written back, which is done before a checkpoint may give
+ * their records back. A pool given the log manager writes a page changed by
+ * a CLR only once the CLR is on disk.
  */
-void LogRecovery::Undo() {}
+void LogRecovery::Undo() {
+  assert(!ENABLE_LOGGING);
+  if (log_manager_ != nullptr) {
+    log_manager_->SetNextLSN(next_lsn_);
+  }
+  std::priority_queue<lsn_t> lsns;
+  for (auto &txn : active_txn_) {
+    lsns.push(txn.second);
+  }
+  std::vector<char> data;
+  while (!lsns.empty()) {
+    lsn_t lsn = lsns.top();
+    lsns.pop();
+    auto it = lsn_mapping_.find(lsn);
+    assert(it != lsn_mapping_.end());
+    int32_t size;
+    disk_manager_->ReadLog(reinterpret_cast<char *>(&size), sizeof(int32_t),
+                           it->second);
+    data.resize(size);
+    disk_manager_->ReadLog(data.data(), size, it->second);
+    LogRecord log_record;
+    bool complete = DeserializeLogRecord(data.data(), size, log_record);
+    assert(complete);
+    (void)complete;
+    lsn_t next = log_record.prev_lsn_;
+    if (log_record.log_record_type_ == LogRecordType::CLR) {
+      // undone before the crash
+      next = log_record.undo_next_lsn_;
+    } else {
+      UndoLogRecord(log_record);
+    }
+    if (next != INVALID_LSN) {
+      lsns.push(next);
+    }
+  }
+  if (log_manager_ != nullptr && !active_txn_.empty()) {
+    lsn_t lsn = INVALID_LSN;
+    for (auto &txn : active_txn_) {
+      LogRecord abort_record(txn.first, txn.second, LogRecordType::ABORT);
+      lsn = log_manager_->AppendLogRecord(abort_record);
+    }
+    log_manager_->WaitForFlush(lsn);
+    next_lsn_ = lsn + 1;
+  }
+  if (!active_txn_.empty()) {
+    buffer_pool_manager_->FlushAllPages();
+    disk_manager_->Sync();
+  }
+  active_txn_.clear();
+  lsn_mapping_.clear();
+}
+
+void LogRecovery::UndoLogRecord(LogRecord &log_record) {
+  page_id_t page_id;
+  switch (log_record.log_record_type_) {
+  case LogRecordType::INSERT:
+    page_id = log_record.insert_rid_.GetPageId();
+    break;
+  case LogRecordType::MARKDELETE:
+  case LogRecordType::APPLYDELETE:
+  case LogRecordType::ROLLBACKDELETE:
+    page_id = log_record.delete_rid_.GetPageId();
+    break;
+  case LogRecordType::UPDATE:
+    page_id = log_record.update_rid_.GetPageId();
+    break;
+  default:
+    // a new page stays in the table, empty
+    return;
+  }
+
+  WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(page_id);
+  assert(guard);
+  auto page = static_cast<TablePage *>(guard.GetPage());
+  Tuple old_tuple;
+  txn_id_t txn_id = log_record.txn_id_;
+  lsn_t prev_lsn = active_txn_[txn_id];
+  LogRecord compensation;
+  switch (log_record.log_record_type_) {
+  case LogRecordType::INSERT:
+    page->ApplyDelete(log_record.insert_rid_, nullptr, nullptr);
+    compensation =
+        LogRecord(txn_id, prev_lsn, LogRecordType::APPLYDELETE,
+                  log_record.insert_rid_, log_record.insert_tuple_);
+    break;
+  case LogRecordType::MARKDELETE:
+    page->RollbackDelete(log_record.delete_rid_, nullptr, nullptr);
+    compensation =
+        LogRecord(txn_id, prev_lsn, LogRecordType::ROLLBACKDELETE,
+                  log_record.delete_rid_, log_record.delete_tuple_);
+    break;
+  case LogRecordType::APPLYDELETE:
+    page->RestoreTuple(log_record.delete_tuple_, log_record.delete_rid_);
+    compensation =
+        LogRecord(txn_id, prev_lsn, LogRecordType::INSERT,
+                  log_record.delete_rid_, log_record.delete_tuple_);
+    break;
+  case LogRecordType::ROLLBACKDELETE:
+    page->MarkDelete(log_record.delete_rid_, nullptr, nullptr, nullptr);
+    compensation =
+        LogRecord(txn_id, prev_lsn, LogRecordType::MARKDELETE,
+                  log_record.delete_rid_, log_record.delete_tuple_);
+    break;
+  default:
+    page->UpdateTuple(log_record.old_tuple_, old_tuple,
+                      log_record.update_rid_, nullptr, nullptr, nullptr);
+    compensation = LogRecord(txn_id, prev_lsn, LogRecordType::UPDATE,
+                             log_record.update_rid_, old_tuple,
+                             log_record.old_tuple_);
+    break;
+  }
+  if (log_manager_ != nullptr) {
+    LogRecord clr(log_record.prev_lsn_, compensation);
+    lsn_t lsn = log_manager_->AppendLogRecord(clr);
+    active_txn_[txn_id] = lsn;
+    page->SetLSN(lsn);
+  }
+  guard.MarkDirty();
+}
 
 } // namespace scudb
@@ -1,6 +1,7 @@
 /**
  * b_plus_tree_internal_page.cpp
  */
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 
@@ -17,7 +18,7 @@ namespace scudb {
  * max page size
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Init(page_id_t page_id,
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Init(page_id_t page_id, size_t page_size,
                                           page_id_t parent_id) 
 {
   SetPageId(page_id);
@@ -25,7 +26,7 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Init(page_id_t page_id,
   SetSize(1);
   SetPageType(IndexPageType::INTERNAL_PAGE);
   // why the BPlusTreeInternalPage is stored in the page
-  SetMaxSize((PAGE_SIZE - sizeof(BPlusTreeInternalPage)) / sizeof(MappingType) - 1);                            
+  SetMaxSize((page_size - sizeof(BPlusTreeInternalPage)) / sizeof(MappingType) - 1);                            
 }
 /*
  * Helper method to get/set the key associated with input "index"(a.k.a
@@ -33,8 +34,8 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Init(page_id_t page_id,
  */
 INDEX_TEMPLATE_ARGUMENTS
 KeyType B_PLUS_TREE_INTERNAL_PAGE_TYPE::KeyAt(int index) const {
-  // replace with your own code
-  assert(index > 0 && index < GetMaxSize());
+  // the first key is invalid, but it carries the separator through splits
+  assert(index >= 0 && index <= GetMaxSize());
   KeyType key;
   key = array[index].first;
   return key;
@@ -42,7 +43,7 @@ KeyType B_PLUS_TREE_INTERNAL_PAGE_TYPE::KeyAt(int index) const {
 
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetKeyAt(int index, const KeyType &key) {
-  assert(index > 0 && index < GetMaxSize());
+  assert(index >= 0 && index <= GetMaxSize());
   array[index].first = key;
 }
 
@@ -82,7 +83,6 @@ ValueType
 B_PLUS_TREE_INTERNAL_PAGE_TYPE::Lookup(const KeyType &key,
                                        const KeyComparator &comparator) const {
   assert(GetSize() > 1);
-<<<<<<< HEAD
   int st = 1, ed = GetSize() - 1;
   while (st <= ed) { //find the last key in array <= input
     int mid = (ed - st) / 2 + st;
@@ -90,22 +90,6 @@ B_PLUS_TREE_INTERNAL_PAGE_TYPE::Lookup(const KeyType &key,
     else ed = mid - 1;
   }
   return array[st - 1].second;
-=======
-  int lft = 0, rht = GetSize() - 1;
-  // binary search
-  while(lft < rht) {
-    int mid = (lft + rht) / 2;
-    auto res = comparator(key, array[mid].first);
-    if(res < 0) {
-      rht = mid - 1;
-    } else if(res > 0) {
-      lft = mid + 1;
-    } else {
-      return array[mid].second;
-    }
-  }
-  return -1;
->>>>>>> dfb4acf36093692d5426c536830c2219dc8cacad
 }
 
 /*****************************************************************************
@@ -177,15 +161,15 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveHalfTo(
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyHalfFrom(
     MappingType *items, int size, BufferPoolManager *buffer_pool_manager) {
-  // detection
-  int cur_size = GetSize();
-  assert(cur_size + size <= GetMaxSize());
+  // detection, this page is freshly initialized by Split()
+  assert(GetSize() == 1);
+  assert(size <= GetMaxSize());
   
-  // copy from items
-  memmove(array + cur_size, items, size * (sizeof(MappingType)));
+  // copy from items, the first key is the one pushed up to the parent
+  std::copy(items, items + size, array);
   
   // update size
-  IncreaseSize(size);
+  SetSize(size);
 }
 
 /*****************************************************************************
@@ -282,6 +266,7 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveFirstToEndOf(
   auto page = buffer_pool_manager->FetchPage(parent_page_id);
   BPlusTreeInternalPage* parent_page = reinterpret_cast<BPlusTreeInternalPage*>(page->GetData());
   auto index_in_parent = parent_page->ValueIndex(GetPageId());
+  SetKeyAt(0, parent_page->KeyAt(index_in_parent));
   parent_page->SetKeyAt(index_in_parent, array[1].first);
   buffer_pool_manager->UnpinPage(parent_page_id, true);
 
@@ -329,6 +314,13 @@ INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyFirstFrom(
     const MappingType &pair, int parent_index,
     BufferPoolManager *buffer_pool_manager) {
+  // change the parent info, its key moves down to the old first pair
+  auto parent_raw_page = buffer_pool_manager->FetchPage(GetParentPageId());
+  BPlusTreeInternalPage* parent_page = reinterpret_cast<BPlusTreeInternalPage*>(parent_raw_page->GetData());
+  SetKeyAt(0, parent_page->KeyAt(parent_index));
+  parent_page->SetKeyAt(parent_index, pair.first);
+  buffer_pool_manager->UnpinPage(GetParentPageId(), true);
+
   // replace first pair
   memmove(array + 1, array, GetSize() * sizeof(MappingType));
   array[0] = pair;
@@ -339,12 +331,6 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyFirstFrom(
   child_page->SetParentPageId(GetPageId());
   buffer_pool_manager->UnpinPage(pair.second, true);
 
-  // change the parent info
-  auto parent_raw_page = buffer_pool_manager->FetchPage(GetParentPageId());
-  BPlusTreeInternalPage* parent_page = reinterpret_cast<BPlusTreeInternalPage*>(parent_raw_page->GetData());
-  parent_page->SetKeyAt(parent_index, pair.first);
-  buffer_pool_manager->UnpinPage(GetParentPageId(), true);
-
   // update size
   IncreaseSize(1); 
 }
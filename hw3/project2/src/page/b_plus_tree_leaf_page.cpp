@@ -2,6 +2,7 @@
  * b_plus_tree_leaf_page.cpp
  */
 
+#include <algorithm>
 #include <sstream>
 
 #include "common/exception.h"
@@ -21,13 +22,14 @@ namespace scudb {
  * next page id and set max size
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::Init(page_id_t page_id, page_id_t parent_id) {
+void B_PLUS_TREE_LEAF_PAGE_TYPE::Init(page_id_t page_id, size_t page_size,
+                                      page_id_t parent_id) {
   SetPageType(IndexPageType::LEAF_PAGE);
   SetSize(0);
   SetPageId(page_id);
   SetParentPageId(parent_id);
   SetNextPageId(INVALID_PAGE_ID);
-  SetMaxSize((PAGE_SIZE - sizeof(BPlusTreeLeafPage)) / sizeof(MappingType));
+  SetMaxSize((page_size - sizeof(BPlusTreeLeafPage)) / sizeof(MappingType));
 }
 
 /**
@@ -175,14 +177,11 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyHalfFrom(MappingType *items, int size) {
 INDEX_TEMPLATE_ARGUMENTS
 bool B_PLUS_TREE_LEAF_PAGE_TYPE::Lookup(const KeyType &key, ValueType &value,
                                         const KeyComparator &comparator) const {
+  // the slot past the last pair may still hold a removed key
   auto idx = KeyIndex(key,comparator);
-  if(comparator(key, array[idx].first) == 0) {
-    value = array[idx].second;
-  } else {
-    auto n_idx = idx - 1;
-    if(!(n_idx >= 0 && comparator(key, array[n_idx].first) == 0))  
-      return false;
-  }
+  if(idx >= GetSize() || comparator(key, array[idx].first) != 0)
+    return false;
+  value = array[idx].second;
   return true;
 }
 
@@ -257,7 +256,7 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveFirstToEndOf(
   // change parent info
   auto parent_page_id = GetParentPageId();
   auto page = buffer_pool_manager->FetchPage(parent_page_id);
-  assert(page == nullptr);
+  assert(page != nullptr);
   auto parent_page = reinterpret_cast<BPlusTreeInternalPage<KeyType, page_id_t,
                                                     KeyComparator>*>(page->GetData());
   auto index_in_parent = parent_page->ValueIndex(GetPageId());
@@ -313,7 +312,7 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyFirstFrom(
   assert(cur_size + 1 <= GetMaxSize());
 
   // copy
-  memmove(array, array + 1, cur_size * sizeof(MappingType));
+  std::move_backward(array, array + cur_size, array + cur_size + 1);
   array[0] = item;
 
   // change parent page info
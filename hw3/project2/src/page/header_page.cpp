@@ -21,6 +21,9 @@ bool HeaderPage::InsertRecord(const std::string &name,
   // check for duplicate name
   if (FindRecord(name) != -1)
     return false;
+  // page full
+  if (offset + 36 > GetLogFieldsOffset())
+    return false;
   // copy record content
   memcpy(GetData() + offset, name.c_str(), (name.length() + 1));
   memcpy((GetData() + offset + 32), &root_id, 4);
@@ -83,6 +86,36 @@ void HeaderPage::SetRecordCount(int record_count) {
   memcpy(GetData(), &record_count, 4);
 }
 
+/**
+ * Log related
+ */
+off_t HeaderPage::GetLogStart() {
+  int64_t offset;
+  memcpy(&offset, GetData() + GetLogFieldsOffset(), 8);
+  return static_cast<off_t>(offset);
+}
+
+void HeaderPage::SetLogStart(off_t offset) {
+  int64_t value = offset;
+  memcpy(GetData() + GetLogFieldsOffset(), &value, 8);
+}
+
+off_t HeaderPage::GetCheckpointOffset() {
+  int64_t offset;
+  memcpy(&offset, GetData() + GetLogFieldsOffset() + 8, 8);
+  return static_cast<off_t>(offset);
+}
+
+lsn_t HeaderPage::GetCheckpointLSN() {
+  return *reinterpret_cast<lsn_t *>(GetData() + GetLogFieldsOffset() + 16);
+}
+
+void HeaderPage::SetCheckpoint(off_t offset, lsn_t lsn) {
+  int64_t value = offset;
+  memcpy(GetData() + GetLogFieldsOffset() + 8, &value, 8);
+  memcpy(GetData() + GetLogFieldsOffset() + 16, &lsn, 4);
+}
+
 int HeaderPage::FindRecord(const std::string &name) {
   int record_num = GetRecordCount();
 
@@ -15,7 +15,10 @@ void TablePage::Init(page_id_t page_id, size_t page_size,
                      Transaction *txn) {
   memcpy(GetData(), &page_id, 4); // set page_id
   if (ENABLE_LOGGING) {
-    // TODO: add your logging logic here
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(),
+                         LogRecordType::NEWPAGE, prev_page_id, page_id);
+    txn->SetPrevLSN(log_manager->AppendLogRecord(log_record));
+    SetLSN(txn->GetPrevLSN());
   }
   SetPrevPageId(prev_page_id);
   SetNextPageId(INVALID_PAGE_ID);
@@ -85,9 +88,14 @@ bool TablePage::InsertTuple(const Tuple &tuple, RID &rid, Transaction *txn,
   }
   // write the log after set rid
   if (ENABLE_LOGGING) {
-    // acquire the exclusive lock
-    assert(lock_manager->LockExclusive(txn, rid.Get()));
-    // TODO: add your logging logic here
+    // acquire the exclusive lock, also when asserts are compiled out
+    bool locked = lock_manager->LockExclusive(txn, rid.Get());
+    assert(locked);
+    (void)locked;
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(),
+                         LogRecordType::INSERT, rid, tuple);
+    txn->SetPrevLSN(log_manager->AppendLogRecord(log_record));
+    SetLSN(txn->GetPrevLSN());
   }
   // LOG_DEBUG("Tuple inserted");
   return true;
@@ -128,7 +136,12 @@ bool TablePage::MarkDelete(const RID &rid, Transaction *txn,
                !lock_manager->LockExclusive(txn, rid)) { // no shared lock
       return false;
     }
-    // TODO: add your logging logic here
+    // the tuple stays on the page, undo only needs the rid
+    Tuple dummy_tuple;
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(),
+                         LogRecordType::MARKDELETE, rid, dummy_tuple);
+    txn->SetPrevLSN(log_manager->AppendLogRecord(log_record));
+    SetLSN(txn->GetPrevLSN());
   }
 
   // set tuple size to negative value
@@ -182,7 +195,10 @@ bool TablePage::UpdateTuple(const Tuple &new_tuple, Tuple &old_tuple,
                !lock_manager->LockExclusive(txn, rid)) { // no shared lock
       return false;
     }
-    // TODO: add your logging logic here
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(),
+                         LogRecordType::UPDATE, rid, old_tuple, new_tuple);
+    txn->SetPrevLSN(log_manager->AppendLogRecord(log_record));
+    SetLSN(txn->GetPrevLSN());
   }
 
   // update
@@ -199,7 +215,8 @@ bool TablePage::UpdateTuple(const Tuple &new_tuple, Tuple &old_tuple,
   for (int i = 0; i < GetTupleCount();
        ++i) { // update tuple offsets (including the updated one)
     int32_t tuple_offset_i = GetTupleOffset(i);
-    if (GetTupleSize(i) > 0 && tuple_offset_i < tuple_offset + tuple_size) {
+    // tuples marked deleted move too
+    if (GetTupleSize(i) != 0 && tuple_offset_i < tuple_offset + tuple_size) {
       SetTupleOffset(i, tuple_offset_i + tuple_size - new_tuple.size_);
     }
   }
@@ -234,7 +251,10 @@ void TablePage::ApplyDelete(const RID &rid, Transaction *txn,
     // must already grab the exclusive lock
     assert(txn->GetExclusiveLockSet()->find(rid) !=
            txn->GetExclusiveLockSet()->end());
-    // TODO: add your logging logic here
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(),
+                         LogRecordType::APPLYDELETE, rid, delete_tuple);
+    txn->SetPrevLSN(log_manager->AppendLogRecord(log_record));
+    SetLSN(txn->GetPrevLSN());
   }
 
   int32_t free_space_pointer =
@@ -266,7 +286,11 @@ void TablePage::RollbackDelete(const RID &rid, Transaction *txn,
     assert(txn->GetExclusiveLockSet()->find(rid) !=
            txn->GetExclusiveLockSet()->end());
 
-    // TODO: add your logging logic here
+    Tuple dummy_tuple;
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(),
+                         LogRecordType::ROLLBACKDELETE, rid, dummy_tuple);
+    txn->SetPrevLSN(log_manager->AppendLogRecord(log_record));
+    SetLSN(txn->GetPrevLSN());
   }
 
   int slot_num = rid.GetSlotNum();
@@ -278,6 +302,22 @@ void TablePage::RollbackDelete(const RID &rid, Transaction *txn,
     SetTupleSize(slot_num, -tuple_size);
 }
 
+/*
+ * RestoreTuple undoes ApplyDelete: the slot it emptied gets the tuple back.
+ * Recovery calls it to undo an APPLYDELETE record and to redo its CLR, so it
+ * neither locks nor logs. The slot is still empty, the transaction held the
+ * exclusive lock on rid until it ended
+ */
+void TablePage::RestoreTuple(const Tuple &tuple, const RID &rid) {
+  int slot_num = rid.GetSlotNum();
+  assert(slot_num < GetTupleCount() && GetTupleSize(slot_num) == 0);
+  assert(GetFreeSpaceSize() >= tuple.size_);
+  SetFreeSpacePointer(GetFreeSpacePointer() - tuple.size_);
+  memcpy(GetData() + GetFreeSpacePointer(), tuple.data_, tuple.size_);
+  SetTupleOffset(slot_num, GetFreeSpacePointer());
+  SetTupleSize(slot_num, tuple.size_);
+}
+
 bool TablePage::GetTuple(const RID &rid, Tuple &tuple, Transaction *txn,
                          LockManager *lock_manager) {
   int slot_num = rid.GetSlotNum();
@@ -8,8 +8,13 @@
 
 namespace scudb {
 
-TableIterator::TableIterator(TableHeap *table_heap, RID rid, Transaction *txn)
-    : table_heap_(table_heap), tuple_(new Tuple(rid)), txn_(txn) {
+TableIterator::TableIterator(TableHeap *table_heap, RID rid, Transaction *txn,
+                             BufferAccessStrategy *strategy)
+    : table_heap_(table_heap), tuple_(new Tuple(rid)), txn_(txn),
+      strategy_(strategy), readahead_(table_heap->buffer_pool_manager_) {
+  if (strategy_ == nullptr && txn_ != nullptr) {
+    strategy_ = txn_->GetBufferAccessStrategy();
+  }
   if (rid.GetPageId() != INVALID_PAGE_ID) {
     table_heap_->GetTuple(tuple_->rid_, *tuple_, txn_);
   }
@@ -28,7 +33,7 @@ Tuple *TableIterator::operator->() {
 TableIterator &TableIterator::operator++() {
   BufferPoolManager *buffer_pool_manager = table_heap_->buffer_pool_manager_;
   auto cur_page = static_cast<TablePage *>(
-      buffer_pool_manager->FetchPage(tuple_->rid_.GetPageId()));
+      buffer_pool_manager->FetchPage(tuple_->rid_.GetPageId(), strategy_));
   cur_page->RLatch();
   assert(cur_page != nullptr); // all pages are pinned
 
@@ -36,8 +41,9 @@ TableIterator &TableIterator::operator++() {
   if (!cur_page->GetNextTupleRid(tuple_->rid_,
                                  next_tuple_rid)) { // end of this page
     while (cur_page->GetNextPageId() != INVALID_PAGE_ID) {
+      readahead_.Advance(cur_page->GetPageId(), cur_page->GetNextPageId());
       auto next_page = static_cast<TablePage *>(
-          buffer_pool_manager->FetchPage(cur_page->GetNextPageId()));
+          buffer_pool_manager->FetchPage(cur_page->GetNextPageId(), strategy_));
       cur_page->RUnlatch();
       buffer_pool_manager->UnpinPage(cur_page->GetPageId(), false);
       cur_page = next_page;
@@ -2,6 +2,7 @@
  * virtual_table.cpp
  */
 #include <algorithm>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
 #include <sys/stat.h>
@@ -358,16 +359,42 @@ __declspec(dllexport)
   struct stat buffer;
   bool is_file_exist = (stat(db_file_name.c_str(), &buffer) == 0);
 
-  // init storage engine
-  storage_engine_ = new StorageEngine(db_file_name);
+  // init storage engine, sizes can be chosen through environment
+  size_t pool_size = BUFFER_POOL_SIZE;
+  size_t num_instances = 1;
+  size_t page_size = DEFAULT_PAGE_SIZE;
+  if (const char *env = getenv("SCUDB_BUFFER_POOL_SIZE")) {
+    pool_size = strtoul(env, nullptr, 10);
+  }
+  if (const char *env = getenv("SCUDB_BUFFER_POOL_INSTANCES")) {
+    num_instances = strtoul(env, nullptr, 10);
+  }
+  if (const char *env = getenv("SCUDB_PAGE_SIZE")) {
+    page_size = strtoul(env, nullptr, 10);
+  }
+  const char *direct_io = getenv("SCUDB_DIRECT_IO");
+  const char *warm_state = getenv("SCUDB_WARM_STATE");
+  try {
+    storage_engine_ = new StorageEngine(
+        db_file_name, pool_size, num_instances, page_size,
+        direct_io != nullptr && strcmp(direct_io, "1") == 0,
+        warm_state != nullptr && strcmp(warm_state, "1") == 0);
+  } catch (const Exception &e) {
+    // e.g. a db file of an older format
+    *pzErrMsg = sqlite3_mprintf("%s", e.what());
+    return SQLITE_ERROR;
+  }
   // start the logging
   storage_engine_->log_manager_->RunFlushThread();
   // create header page from BufferPoolManager if necessary
   if (!is_file_exist) {
     page_id_t header_page_id;
-    storage_engine_->buffer_pool_manager_->NewPage(header_page_id);
+    auto header_page = static_cast<HeaderPage *>(
+        storage_engine_->buffer_pool_manager_->NewPage(header_page_id));
 
     assert(header_page_id == HEADER_PAGE_ID);
+    // no checkpoint yet, recovery reads the log from its start
+    header_page->Init();
     storage_engine_->buffer_pool_manager_->UnpinPage(header_page_id, true);
   }
 
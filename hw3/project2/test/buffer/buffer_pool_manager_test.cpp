@@ -2,9 +2,18 @@
  * buffer_pool_manager_test.cpp
  */
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
 
-#include "buffer/buffer_pool_manager.h"
+#include "buffer/buffer_pool_manager_instance.h"
+#include "logging/log_manager.h"
 #include "gtest/gtest.h"
 
 namespace scudb {
@@ -12,8 +21,8 @@ namespace scudb {
 TEST(BufferPoolManagerTest, SampleTest) {
   page_id_t temp_page_id;
 
-  DiskManager *disk_manager = new DiskManager("test.db");
-  BufferPoolManager bpm(10, disk_manager);
+  DiskManager *disk_manager = new DiskManager("test.db", TEST_PAGE_SIZE);
+  BufferPoolManagerInstance bpm(10, disk_manager);
 
   auto page_zero = bpm.NewPage(temp_page_id);
   EXPECT_NE(nullptr, page_zero);
@@ -45,6 +54,687 @@ TEST(BufferPoolManagerTest, SampleTest) {
   // check read content
   EXPECT_EQ(0, strcmp(page_zero->GetData(), "Hello"));
 
+  // nothing is left pinned when the pool goes away
+  EXPECT_EQ(true, bpm.UnpinPage(0, false));
+  for (int i = 5; i < 14; ++i) {
+    EXPECT_EQ(true, bpm.UnpinPage(i, false));
+  }
+  EXPECT_EQ(0, bpm.CheckPinLeaks());
+
+  remove("test.db");
+}
+
+// many threads fetching a few cold pages through a tiny pool, every miss
+// reads the page and writes back a dirty victim without holding the latch
+TEST(BufferPoolManagerTest, ConcurrentMissTest) {
+  remove("test.db");
+  remove("test.log");
+  const int num_threads = 8;
+  const int num_pages = 20;
+  DiskManager *disk_manager = new DiskManager("test.db", TEST_PAGE_SIZE);
+  BufferPoolManagerInstance bpm(5, disk_manager);
+
+  page_id_t page_id;
+  for (int i = 0; i < num_pages; ++i) {
+    auto page = bpm.NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    memcpy(page->GetData(), &page_id, sizeof(page_id));
+    EXPECT_EQ(true, bpm.UnpinPage(page_id, true));
+  }
+
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.push_back(std::thread([tid, &bpm]() {
+      std::mt19937 gen(tid);
+      std::uniform_int_distribution<page_id_t> dis(0, num_pages - 1);
+      for (int i = 0; i < 500; i++) {
+        page_id_t id = dis(gen);
+        auto page = bpm.FetchPage(id);
+        if (page == nullptr) {
+          // every frame is pinned by the other threads
+          continue;
+        }
+        EXPECT_EQ(id, page->GetPageId());
+        EXPECT_EQ(id, *reinterpret_cast<page_id_t *>(page->GetData()));
+        EXPECT_EQ(true, bpm.UnpinPage(id, i % 2 == 0));
+      }
+    }));
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+// true if the page on disk already holds what is in the buffer pool
+static bool IsOnDisk(DiskManager *disk_manager, Page *page) {
+  char buffer[TEST_PAGE_SIZE];
+  disk_manager->ReadPage(page->GetPageId(), buffer);
+  return memcmp(buffer, page->GetData(), TEST_PAGE_SIZE) == 0;
+}
+
+TEST(BufferPoolManagerTest, FlushAllPagesTest) {
+  remove("test.db");
+  remove("test.log");
+  DiskManager *disk_manager = new DiskManager("test.db", TEST_PAGE_SIZE);
+  disk_manager->SetSyncPolicy(SyncPolicy::PER_BATCH);
+  BufferPoolManagerInstance bpm(10, disk_manager);
+
+  page_id_t page_id;
+  Page *pages[10];
+  for (int i = 0; i < 10; ++i) {
+    pages[i] = bpm.NewPage(page_id);
+    ASSERT_NE(nullptr, pages[i]);
+    snprintf(pages[i]->GetData(), TEST_PAGE_SIZE, "page %d", page_id);
+    EXPECT_EQ(true, bpm.UnpinPage(page_id, true));
+    // pinned and unpinned pages are flushed alike
+    if (i % 2 == 1) {
+      EXPECT_EQ(pages[i], bpm.FetchPage(page_id));
+    }
+  }
+
+  int num_syncs = disk_manager->GetNumSyncs();
+  bpm.FlushAllPages();
+  EXPECT_EQ(num_syncs + 1, disk_manager->GetNumSyncs());
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_TRUE(IsOnDisk(disk_manager, pages[i]));
+    EXPECT_EQ(i % 2 == 0 ? 0 : 1, pages[i]->GetPinCount());
+  }
+
+  // nothing is dirty any more, the unpinned pages can still be evicted
+  bpm.FlushAllPages();
+  EXPECT_EQ(num_syncs + 1, disk_manager->GetNumSyncs());
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_NE(nullptr, bpm.NewPage(page_id));
+  }
+  EXPECT_EQ(nullptr, bpm.NewPage(page_id));
+  for (int i = 10; i < 15; ++i) {
+    EXPECT_EQ(true, bpm.UnpinPage(i, false));
+  }
+  for (int i = 1; i < 10; i += 2) {
+    EXPECT_EQ(true, bpm.UnpinPage(pages[i]->GetPageId(), false));
+  }
+  EXPECT_EQ(0, bpm.CheckPinLeaks());
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, PageSizeTest) {
+  remove("test.db");
+  DiskManager *disk_manager = new DiskManager("test.db", MAX_PAGE_SIZE);
+  BufferPoolManagerInstance bpm(4, disk_manager);
+  EXPECT_EQ(MAX_PAGE_SIZE, bpm.GetPageSize());
+
+  // every frame holds a whole page, pages survive eviction
+  page_id_t page_id;
+  for (int i = 0; i < 8; ++i) {
+    Page *page = bpm.NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(MAX_PAGE_SIZE, page->GetPageSize());
+    memset(page->GetData(), i, MAX_PAGE_SIZE);
+    EXPECT_EQ(true, bpm.UnpinPage(page_id, true));
+  }
+  for (int i = 0; i < 8; ++i) {
+    Page *page = bpm.FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(i, page->GetData()[0]);
+    EXPECT_EQ(i, page->GetData()[MAX_PAGE_SIZE - 1]);
+    EXPECT_EQ(true, bpm.UnpinPage(i, false));
+  }
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, ResizeTest) {
+  remove("test.db");
+  remove("test.log");
+  for (auto type : {ReplacerType::LRU, ReplacerType::CLOCK}) {
+    DiskManager *disk_manager = new DiskManager("test.db", TEST_PAGE_SIZE);
+    BufferPoolManagerInstance bpm(10, disk_manager, nullptr, type);
+    page_id_t page_id;
+    for (int i = 0; i < 10; ++i) {
+      Page *page = bpm.NewPage(page_id);
+      ASSERT_NE(nullptr, page);
+      snprintf(page->GetData(), TEST_PAGE_SIZE, "page %d", page_id);
+    }
+    EXPECT_EQ(nullptr, bpm.NewPage(page_id));
+
+    // growing adds free frames
+    bpm.Resize(20);
+    EXPECT_EQ(20, bpm.GetPoolSize());
+    for (int i = 10; i < 20; ++i) {
+      Page *page = bpm.NewPage(page_id);
+      ASSERT_NE(nullptr, page);
+      snprintf(page->GetData(), TEST_PAGE_SIZE, "page %d", page_id);
+    }
+    EXPECT_EQ(nullptr, bpm.NewPage(page_id));
+
+    // shrinking waits for the pinned pages, which stay readable meanwhile
+    std::thread resizer([&bpm] { bpm.Resize(5); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    ResizeProgress progress = bpm.GetResizeProgress();
+    EXPECT_TRUE(progress.in_progress);
+    EXPECT_EQ(5, progress.target_pool_size);
+    EXPECT_EQ(15, progress.frames_to_release);
+    EXPECT_EQ(0, progress.frames_released);
+    EXPECT_EQ(5, bpm.GetPoolSize());
+    for (int i = 0; i < 20; ++i) {
+      Page *page = bpm.FetchPage(i);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ("page " + std::to_string(i), std::string(page->GetData()));
+      EXPECT_EQ(true, bpm.UnpinPage(i, false));
+    }
+    for (int i = 0; i < 20; ++i) {
+      EXPECT_EQ(true, bpm.UnpinPage(i, true));
+    }
+    resizer.join();
+    progress = bpm.GetResizeProgress();
+    EXPECT_FALSE(progress.in_progress);
+    EXPECT_EQ(15, progress.frames_released);
+    EXPECT_EQ(15, progress.pages_written);
+    EXPECT_EQ(15, progress.pages_relocated + progress.pages_evicted);
+
+    // every page survives with 5 frames
+    for (int i = 0; i < 20; ++i) {
+      Page *page = bpm.FetchPage(i);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ("page " + std::to_string(i), std::string(page->GetData()));
+      EXPECT_EQ(true, bpm.UnpinPage(i, false));
+    }
+
+    // growing again reuses the frames of the first chunk
+    bpm.Resize(12);
+    for (int i = 0; i < 12; ++i) {
+      EXPECT_NE(nullptr, bpm.FetchPage(i));
+    }
+    EXPECT_EQ(nullptr, bpm.FetchPage(12));
+    for (int i = 0; i < 12; ++i) {
+      EXPECT_EQ(true, bpm.UnpinPage(i, false));
+    }
+
+    delete disk_manager;
+    remove("test.db");
+  }
+}
+
+TEST(BufferPoolManagerTest, ResizeRelocateTest) {
+  remove("test.db");
+  remove("test.log");
+  DiskManager *disk_manager = new DiskManager("test.db", TEST_PAGE_SIZE);
+  BufferPoolManagerInstance bpm(10, disk_manager);
+  page_id_t page_id;
+  for (int i = 0; i < 10; ++i) {
+    Page *page = bpm.NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), TEST_PAGE_SIZE, "page %d", page_id);
+    EXPECT_EQ(true, bpm.UnpinPage(page_id, true));
+  }
+  // frees the frames that are kept
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_EQ(true, bpm.DeletePage(i));
+  }
+
+  // the other pages move into them instead of being evicted
+  bpm.Resize(5);
+  ResizeProgress progress = bpm.GetResizeProgress();
+  EXPECT_EQ(5, progress.frames_released);
+  EXPECT_EQ(5, progress.pages_relocated);
+  EXPECT_EQ(0, progress.pages_evicted);
+  EXPECT_EQ(5, progress.pages_written);
+  for (int i = 5; i < 10; ++i) {
+    Page *page = bpm.FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(i), std::string(page->GetData()));
+  }
+  EXPECT_EQ(nullptr, bpm.NewPage(page_id));
+  for (int i = 5; i < 10; ++i) {
+    EXPECT_EQ(true, bpm.UnpinPage(i, false));
+  }
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, DirectIOTest) {
+  remove("test.db");
+  DiskManager *disk_manager =
+      new DiskManager("test.db", 4096, AsyncIOType::IO_URING, true);
+  BufferPoolManagerInstance bpm(4, disk_manager);
+
+  // frames can be handed to O_DIRECT as they are
+  page_id_t page_id;
+  for (int i = 0; i < 12; ++i) {
+    Page *page = bpm.NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(page->GetData()) %
+                     DIRECT_IO_ALIGNMENT);
+    snprintf(page->GetData(), 4096, "page %d", page_id);
+    EXPECT_EQ(true, bpm.UnpinPage(page_id, true));
+  }
+  bpm.PrefetchPages(0, 2);
+  for (int i = 0; i < 12; ++i) {
+    Page *page = bpm.FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(i), std::string(page->GetData()));
+    EXPECT_EQ(true, bpm.UnpinPage(i, false));
+  }
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, WarmStateTest) {
+  remove("test.db");
+  remove("test.warm");
+  DiskManager *disk_manager = new DiskManager("test.db", TEST_PAGE_SIZE);
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(10, disk_manager);
+  page_id_t page_id;
+  for (int i = 0; i < 30; ++i) {
+    Page *page = bpm->NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    memcpy(page->GetData(), &page_id, sizeof(page_id));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+  bpm->FlushAllPages();
+  // pages 5 to 14 are resident, 5 is the coldest, 14 stays pinned
+  for (int i = 5; i < 15; ++i) {
+    ASSERT_NE(nullptr, bpm->FetchPage(i));
+    if (i != 14) {
+      EXPECT_EQ(true, bpm->UnpinPage(i, false));
+    }
+  }
+  bpm->RunWarmStateThread("test.warm", std::chrono::milliseconds(3600000));
+  EXPECT_EQ(true, bpm->UnpinPage(14, false));
+  // the last dump is taken at shutdown
+  delete bpm;
+
+  bpm = new BufferPoolManagerInstance(10, disk_manager);
+  EXPECT_EQ(10, bpm->RestoreWarmState("test.warm"));
+  bpm->WaitForWarmRestore();
+  BufferPoolStats stats = bpm->GetStats();
+  EXPECT_EQ(0, stats.free_frames);
+  EXPECT_EQ(0, stats.misses);
+  // replacer order is restored, the coldest page goes first
+  ASSERT_NE(nullptr, bpm->NewPage(page_id));
+  EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  for (int i = 6; i < 15; ++i) {
+    Page *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(i, *reinterpret_cast<page_id_t *>(page->GetData()));
+    EXPECT_EQ(true, bpm->UnpinPage(i, false));
+  }
+  EXPECT_EQ(0, bpm->GetStats().misses);
+  ASSERT_NE(nullptr, bpm->FetchPage(5));
+  EXPECT_EQ(true, bpm->UnpinPage(5, false));
+  EXPECT_EQ(1, bpm->GetStats().misses);
+  delete bpm;
+
+  // a smaller pool only takes the hottest pages
+  bpm = new BufferPoolManagerInstance(4, disk_manager);
+  EXPECT_EQ(4, bpm->RestoreWarmState("test.warm"));
+  bpm->WaitForWarmRestore();
+  for (int i = 11; i < 15; ++i) {
+    ASSERT_NE(nullptr, bpm->FetchPage(i));
+    EXPECT_EQ(true, bpm->UnpinPage(i, false));
+  }
+  EXPECT_EQ(0, bpm->GetStats().misses);
+  EXPECT_EQ(0, bpm->RestoreWarmState("no_such_file.warm"));
+  delete bpm;
+
+  delete disk_manager;
+  remove("test.db");
+  remove("test.warm");
+}
+
+TEST(BufferPoolManagerTest, AccessStrategyTest) {
+  remove("test.db");
+  DiskManager *disk_manager = new DiskManager("test.db", TEST_PAGE_SIZE);
+  BufferPoolManagerInstance bpm(10, disk_manager);
+  page_id_t page_id;
+  // pages 0 to 3 are the working set
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_NE(nullptr, bpm.NewPage(page_id));
+    EXPECT_EQ(true, bpm.UnpinPage(page_id, true));
+  }
+
+  // a bulk load only uses the 4 frames of its ring
+  BufferAccessStrategy load(4);
+  for (int i = 4; i < 44; ++i) {
+    Page *page = bpm.NewPage(page_id, &load);
+    ASSERT_NE(nullptr, page);
+    memcpy(page->GetData(), &page_id, sizeof(page_id));
+    EXPECT_EQ(true, bpm.UnpinPage(page_id, true));
+  }
+  BufferPoolStats stats = bpm.GetStats();
+  EXPECT_EQ(36, stats.ring_reuses);
+  EXPECT_EQ(2, stats.free_frames);
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_NE(nullptr, bpm.FetchPage(i));
+    EXPECT_EQ(true, bpm.UnpinPage(i, false));
+  }
+
+  // so does a scan, a page it keeps pinned is not reused
+  BufferAccessStrategy scan(4);
+  Page *pinned = bpm.FetchPage(4, &scan);
+  ASSERT_NE(nullptr, pinned);
+  for (int i = 5; i < 44; ++i) {
+    Page *page = bpm.FetchPage(i, &scan);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(i, *reinterpret_cast<page_id_t *>(page->GetData()));
+    EXPECT_EQ(true, bpm.UnpinPage(i, false));
+  }
+  EXPECT_EQ(true, bpm.UnpinPage(4, false));
+
+  uint64_t misses = bpm.GetStats().misses;
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_NE(nullptr, bpm.FetchPage(i));
+    EXPECT_EQ(true, bpm.UnpinPage(i, false));
+  }
+  EXPECT_EQ(misses, bpm.GetStats().misses);
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, PageGuardTest) {
+  remove("test.db");
+  remove("test.log");
+  DiskManager *disk_manager = new DiskManager("test.db", TEST_PAGE_SIZE);
+  BufferPoolManagerInstance bpm(4, disk_manager);
+  page_id_t page_id;
+  {
+    WritePageGuard guard = bpm.NewPageGuarded(page_id);
+    ASSERT_TRUE(static_cast<bool>(guard));
+    EXPECT_EQ(1, bpm.CheckPinLeaks());
+    snprintf(guard.GetDataMut(), bpm.GetPageSize(), "guarded");
+  }
+  // released at the end of the scope, and dirty
+  EXPECT_EQ(0, bpm.CheckPinLeaks());
+  EXPECT_EQ(1, bpm.GetStats().dirty_frames);
+
+  // readers share the page
+  {
+    ReadPageGuard first = bpm.FetchPageRead(page_id);
+    ReadPageGuard second = bpm.FetchPageRead(page_id);
+    EXPECT_EQ(0, strcmp(first.GetData(), "guarded"));
+    EXPECT_EQ(2, first.GetPage()->GetPinCount());
+
+    // moving hands over the pin, not takes another one
+    ReadPageGuard moved(std::move(first));
+    EXPECT_FALSE(static_cast<bool>(first));
+    EXPECT_EQ(2, moved.GetPage()->GetPinCount());
+    second.Drop();
+    EXPECT_FALSE(static_cast<bool>(second));
+    EXPECT_EQ(1, moved.GetPage()->GetPinCount());
+  }
+  EXPECT_EQ(0, bpm.CheckPinLeaks());
+
+  // a write guard left untouched does not dirty the page
+  EXPECT_EQ(true, bpm.FlushPage(page_id));
+  {
+    WritePageGuard guard = bpm.FetchPageWrite(page_id);
+    EXPECT_EQ(0, strcmp(guard.GetData(), "guarded"));
+  }
+  EXPECT_EQ(0, bpm.GetStats().dirty_frames);
+
+  // move assignment releases the page held before
+  {
+    BasicPageGuard guard = bpm.FetchPageBasic(page_id);
+    page_id_t other_id;
+    WritePageGuard other = bpm.NewPageGuarded(other_id);
+    EXPECT_EQ(2, bpm.CheckPinLeaks());
+    guard = bpm.FetchPageBasic(other_id);
+    EXPECT_EQ(1, bpm.CheckPinLeaks());
+    EXPECT_EQ(other_id, guard.GetPageId());
+  }
+  EXPECT_EQ(0, bpm.CheckPinLeaks());
+
+  // no guard is handed out when every frame is pinned
+  std::vector<WritePageGuard> guards;
+  for (int i = 0; i < 4; ++i) {
+    guards.push_back(bpm.NewPageGuarded(page_id));
+    ASSERT_TRUE(static_cast<bool>(guards.back()));
+  }
+  EXPECT_FALSE(static_cast<bool>(bpm.NewPageGuarded(page_id)));
+  EXPECT_FALSE(static_cast<bool>(bpm.FetchPageRead(0)));
+  EXPECT_EQ(4, bpm.CheckPinLeaks());
+  guards.clear();
+  EXPECT_EQ(0, bpm.CheckPinLeaks());
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, StatsTest) {
+  remove("test.db");
+  remove("test.log");
+  DiskManager *disk_manager = new DiskManager("test.db", TEST_PAGE_SIZE);
+  BufferPoolManagerInstance bpm(4, disk_manager);
+  page_id_t page_id;
+  for (int i = 0; i < 6; ++i) {
+    ASSERT_NE(nullptr, bpm.NewPage(page_id));
+    EXPECT_EQ(true, bpm.UnpinPage(page_id, true));
+  }
+  // two dirty pages are written back to make room
+  BufferPoolStats stats = bpm.GetStats();
+  EXPECT_EQ(2, stats.evictions);
+  EXPECT_EQ(2, stats.write_backs);
+  EXPECT_EQ(4, stats.dirty_frames);
+  EXPECT_EQ(0, stats.free_frames);
+
+  // 0 and 1 are read back, pushing out others
+  for (int i = 0; i < 6; ++i) {
+    ASSERT_NE(nullptr, bpm.FetchPage(i));
+    if (i % 2 == 0) {
+      EXPECT_EQ(true, bpm.UnpinPage(i, false));
+    }
+  }
+  stats = bpm.GetStats();
+  EXPECT_EQ(4, stats.pool_size);
+  EXPECT_EQ(3, stats.pinned_frames);
+  EXPECT_EQ(6, stats.hits + stats.misses);
+  EXPECT_GE(stats.misses, 2);
+  EXPECT_EQ(stats.misses, stats.disk_reads.count);
+  EXPECT_EQ(stats.write_backs, stats.disk_writes.count);
+  EXPECT_EQ(0, stats.latch_waits);
+  EXPECT_NE(std::string::npos, stats.ToString().find("pinned_frames 3\n"));
+  for (int i = 1; i < 6; i += 2) {
+    EXPECT_EQ(true, bpm.UnpinPage(i, false));
+  }
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, CleanerTest) {
+  remove("test.db");
+  remove("test.log");
+  DiskManager *disk_manager = new DiskManager("test.db", TEST_PAGE_SIZE);
+  BufferPoolManagerInstance bpm(10, disk_manager);
+
+  page_id_t page_id;
+  Page *pages[10];
+  for (int i = 0; i < 10; ++i) {
+    pages[i] = bpm.NewPage(page_id);
+    ASSERT_NE(nullptr, pages[i]);
+    snprintf(pages[i]->GetData(), TEST_PAGE_SIZE, "page %d", page_id);
+  }
+  // only the unpinned pages are candidates
+  for (int i = 0; i < 6; ++i) {
+    EXPECT_EQ(true, bpm.UnpinPage(i, true));
+  }
+
+  bpm.RunCleanerThread(4, 4);
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  bpm.StopCleanerThread();
+
+  // the four coldest pages are written back, the others left alone
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_TRUE(IsOnDisk(disk_manager, pages[i]));
+  }
+  for (int i = 4; i < 10; ++i) {
+    EXPECT_FALSE(IsOnDisk(disk_manager, pages[i]));
+  }
+  for (int i = 6; i < 10; ++i) {
+    EXPECT_EQ(true, bpm.UnpinPage(i, false));
+  }
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, CleanerWALTest) {
+  remove("test.db");
+  remove("test.log");
+  DiskManager *disk_manager = new DiskManager("test.db", TEST_PAGE_SIZE);
+  LogManager *log_manager = new LogManager(disk_manager);
+  BufferPoolManagerInstance bpm(4, disk_manager, log_manager);
+
+  page_id_t page_id;
+  Page *pages[4];
+  for (int i = 0; i < 4; ++i) {
+    pages[i] = bpm.NewPage(page_id);
+    ASSERT_NE(nullptr, pages[i]);
+    snprintf(pages[i]->GetData(), TEST_PAGE_SIZE, "page %d", page_id);
+    pages[i]->SetLSN(i * 10);
+    EXPECT_EQ(true, bpm.UnpinPage(page_id, true));
+  }
+
+  // log records up to lsn 15 are on disk
+  ENABLE_LOGGING = true;
+  log_manager->SetPersistentLSN(15);
+  bpm.RunCleanerThread(4, 4);
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  bpm.StopCleanerThread();
+  ENABLE_LOGGING = false;
+
+  EXPECT_TRUE(IsOnDisk(disk_manager, pages[0]));
+  EXPECT_TRUE(IsOnDisk(disk_manager, pages[1]));
+  EXPECT_FALSE(IsOnDisk(disk_manager, pages[2]));
+  EXPECT_FALSE(IsOnDisk(disk_manager, pages[3]));
+
+  delete log_manager;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BufferPoolManagerTest, EvictionWALTest) {
+  remove("test.db");
+  remove("test.log");
+  DiskManager *disk_manager = new DiskManager("test.db", TEST_PAGE_SIZE);
+  LogManager *log_manager = new LogManager(disk_manager);
+  BufferPoolManagerInstance bpm(1, disk_manager, log_manager);
+  ENABLE_LOGGING = true;
+
+  // a dirty page whose log record is still in the log buffer
+  page_id_t page_id0;
+  Page *page0 = bpm.NewPage(page_id0);
+  ASSERT_NE(nullptr, page0);
+  LogRecord begin0(0, INVALID_LSN, LogRecordType::BEGIN);
+  lsn_t lsn0 = log_manager->AppendLogRecord(begin0);
+  page0->SetLSN(lsn0);
+  EXPECT_EQ(true, bpm.UnpinPage(page_id0, true));
+  EXPECT_LT(log_manager->GetPersistentLSN(), lsn0);
+  EXPECT_EQ(0, disk_manager->GetLogFileSize());
+
+  // evicting it writes the log first
+  page_id_t page_id1;
+  Page *page1 = bpm.NewPage(page_id1);
+  ASSERT_NE(nullptr, page1);
+  EXPECT_GE(log_manager->GetPersistentLSN(), lsn0);
+  EXPECT_LT(0, disk_manager->GetLogFileSize());
+
+  // and so does flushing it
+  LogRecord begin1(1, INVALID_LSN, LogRecordType::BEGIN);
+  lsn_t lsn1 = log_manager->AppendLogRecord(begin1);
+  page1->SetLSN(lsn1);
+  EXPECT_EQ(true, bpm.UnpinPage(page_id1, true));
+  EXPECT_LT(log_manager->GetPersistentLSN(), lsn1);
+  EXPECT_EQ(true, bpm.FlushPage(page_id1));
+  EXPECT_GE(log_manager->GetPersistentLSN(), lsn1);
+  ENABLE_LOGGING = false;
+
+  delete log_manager;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BufferPoolManagerTest, DirtyPageTableTest) {
+  remove("test.db");
+  remove("test.log");
+  DiskManager *disk_manager = new DiskManager("test.db", TEST_PAGE_SIZE);
+  BufferPoolManagerInstance bpm(4, disk_manager);
+  using DirtyPageTable = std::vector<std::pair<page_id_t, lsn_t>>;
+  auto get_table = [&bpm]() {
+    DirtyPageTable table = bpm.GetDirtyPageTable();
+    std::sort(table.begin(), table.end());
+    return table;
+  };
+
+  // 0 and 1 are written back to make room
+  page_id_t page_id;
+  for (int i = 0; i < 6; ++i) {
+    Page *page = bpm.NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    page->SetLSN(10 + i);
+    EXPECT_EQ(true, bpm.UnpinPage(page_id, true));
+  }
+  EXPECT_EQ(DirtyPageTable({{2, 12}, {3, 13}, {4, 14}, {5, 15}}), get_table());
+
+  // recLSN is the first change since the page was written
+  Page *page = bpm.FetchPage(2);
+  page->SetLSN(20);
+  EXPECT_EQ(true, bpm.UnpinPage(2, true));
+  EXPECT_EQ(true, bpm.FlushPage(3));
+  EXPECT_EQ(DirtyPageTable({{2, 12}, {4, 14}, {5, 15}}), get_table());
+
+  // a page pinned while it is written keeps its recLSN, it may be changed
+  page = bpm.FetchPage(4);
+  bpm.FlushAllPages();
+  EXPECT_EQ(DirtyPageTable({{4, 14}}), get_table());
+  page->SetLSN(30);
+  EXPECT_EQ(true, bpm.UnpinPage(4, true));
+  EXPECT_EQ(true, bpm.FlushPage(4));
+  EXPECT_EQ(DirtyPageTable(), get_table());
+
+  // every recLSN of a table was handed out before the table is returned
+  std::atomic<lsn_t> next_lsn(100);
+  std::atomic<bool> done(false);
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < 2; ++tid) {
+    threads.push_back(std::thread([tid, &bpm, &next_lsn, &done]() {
+      std::mt19937 gen(tid);
+      std::uniform_int_distribution<page_id_t> dis(0, 5);
+      while (!done.load()) {
+        WritePageGuard guard = bpm.FetchPageWrite(dis(gen));
+        if (!guard) {
+          // the table may hold the frames pinned
+          continue;
+        }
+        guard.GetPage()->SetLSN(next_lsn++);
+        guard.MarkDirty();
+      }
+    }));
+  }
+  for (int i = 0; i < 1000; ++i) {
+    DirtyPageTable table = bpm.GetDirtyPageTable();
+    lsn_t bound = next_lsn.load();
+    for (auto &entry : table) {
+      EXPECT_LT(entry.second, bound);
+    }
+  }
+  done.store(true);
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  delete disk_manager;
   remove("test.db");
 }
 
@@ -0,0 +1,161 @@
+/**
+ * clock_replacer_test.cpp
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/clock_replacer.h"
+#include "buffer/lru_replacer.h"
+#include "gtest/gtest.h"
+
+namespace scudb {
+
+TEST(ClockReplacerTest, SampleTest) {
+  ClockReplacer<int> clock_replacer(7, [](const int &value) { return value; });
+
+  // push element into replacer
+  clock_replacer.Insert(1);
+  clock_replacer.Insert(2);
+  clock_replacer.Insert(3);
+  clock_replacer.Insert(4);
+  clock_replacer.Insert(5);
+  clock_replacer.Insert(6);
+  clock_replacer.Insert(1);
+  EXPECT_EQ(6, clock_replacer.Size());
+
+  // every frame is referenced, the first sweep clears the bits and the
+  // victims come out in clock order
+  int value;
+  EXPECT_EQ(true, clock_replacer.Victim(value));
+  EXPECT_EQ(1, value);
+  EXPECT_EQ(true, clock_replacer.Victim(value));
+  EXPECT_EQ(2, value);
+  EXPECT_EQ(true, clock_replacer.Victim(value));
+  EXPECT_EQ(3, value);
+
+  // remove element from replacer
+  EXPECT_EQ(false, clock_replacer.Erase(3));
+  EXPECT_EQ(true, clock_replacer.Erase(5));
+  EXPECT_EQ(2, clock_replacer.Size());
+
+  // a re-inserted frame gets a second chance
+  clock_replacer.Insert(4);
+  EXPECT_EQ(true, clock_replacer.Victim(value));
+  EXPECT_EQ(6, value);
+  EXPECT_EQ(true, clock_replacer.Victim(value));
+  EXPECT_EQ(4, value);
+  EXPECT_EQ(false, clock_replacer.Victim(value));
+  EXPECT_EQ(0, clock_replacer.Size());
+}
+
+TEST(ClockReplacerTest, ResizeTest) {
+  ClockReplacer<int> clock_replacer(4, [](const int &value) { return value; });
+  clock_replacer.Insert(0);
+  clock_replacer.Insert(2);
+
+  // kept frames keep their state, new frames can be inserted
+  clock_replacer.Resize(8);
+  clock_replacer.Insert(6);
+  EXPECT_EQ(3, clock_replacer.Size());
+  int value;
+  EXPECT_EQ(true, clock_replacer.Victim(value));
+  EXPECT_EQ(0, value);
+
+  EXPECT_EQ(true, clock_replacer.Erase(6));
+  clock_replacer.Resize(3);
+  EXPECT_EQ(1, clock_replacer.Size());
+  EXPECT_EQ(true, clock_replacer.Victim(value));
+  EXPECT_EQ(2, value);
+  EXPECT_EQ(false, clock_replacer.Victim(value));
+}
+
+TEST(ClockReplacerTest, BufferPoolTest) {
+  remove("test.db");
+  remove("test.log");
+  page_id_t temp_page_id;
+
+  DiskManager *disk_manager = new DiskManager("test.db", TEST_PAGE_SIZE);
+  BufferPoolManagerInstance bpm(10, disk_manager, nullptr, ReplacerType::CLOCK);
+
+  auto page_zero = bpm.NewPage(temp_page_id);
+  ASSERT_NE(nullptr, page_zero);
+  EXPECT_EQ(0, temp_page_id);
+  strcpy(page_zero->GetData(), "Hello");
+
+  for (int i = 1; i < 10; ++i) {
+    EXPECT_NE(nullptr, bpm.NewPage(temp_page_id));
+  }
+  // all the pages are pinned, the buffer pool is full
+  EXPECT_EQ(nullptr, bpm.NewPage(temp_page_id));
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_EQ(true, bpm.UnpinPage(i, true));
+  }
+  for (int i = 10; i < 15; ++i) {
+    EXPECT_NE(nullptr, bpm.NewPage(temp_page_id));
+  }
+  EXPECT_EQ(nullptr, bpm.NewPage(temp_page_id));
+
+  // page zero was written back when it was evicted
+  EXPECT_EQ(true, bpm.UnpinPage(10, false));
+  page_zero = bpm.FetchPage(0);
+  ASSERT_NE(nullptr, page_zero);
+  EXPECT_EQ(0, strcmp(page_zero->GetData(), "Hello"));
+
+  // nothing is left pinned when the pool goes away
+  EXPECT_EQ(true, bpm.UnpinPage(0, false));
+  for (int i = 5; i < 15; ++i) {
+    EXPECT_EQ(i != 10, bpm.UnpinPage(i, false));
+  }
+  EXPECT_EQ(0, bpm.CheckPinLeaks());
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+/*
+ * Unpin/pin/evict cost of LRUReplacer vs. ClockReplacer from 10 to 1M frames.
+ * Run with --gtest_also_run_disabled_tests
+ */
+TEST(ClockReplacerTest, DISABLED_ReplacerBenchmark) {
+  const int num_ops = 2000000;
+  for (int num_frames = 10; num_frames <= 1000000; num_frames *= 10) {
+    LRUReplacer<int> lru_replacer;
+    ClockReplacer<int> clock_replacer(num_frames,
+                                      [](const int &value) { return value; });
+    Replacer<int> *replacers[] = {&lru_replacer, &clock_replacer};
+    const char *names[] = {"lru", "clock"};
+
+    for (int r = 0; r < 2; r++) {
+      Replacer<int> *replacer = replacers[r];
+      for (int i = 0; i < num_frames; i++) {
+        replacer->Insert(i);
+      }
+      std::mt19937 gen(0);
+      std::uniform_int_distribution<int> dis(0, num_frames - 1);
+      auto start = std::chrono::steady_clock::now();
+      int value;
+      for (int i = 0; i < num_ops; i++) {
+        if (i % 10 == 0) {
+          // a miss, evict and reuse the frame
+          replacer->Victim(value);
+          replacer->Insert(value);
+        } else {
+          // a hit, pin and unpin
+          int frame = dis(gen);
+          replacer->Erase(frame);
+          replacer->Insert(frame);
+        }
+      }
+      std::chrono::duration<double> elapsed =
+          std::chrono::steady_clock::now() - start;
+      std::cout << names[r] << " frames: " << num_frames
+                << " ns/op: " << elapsed.count() * 1e9 / num_ops << std::endl;
+    }
+  }
+}
+
+} // namespace scudb
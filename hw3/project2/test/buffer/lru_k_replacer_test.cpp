@@ -0,0 +1,152 @@
+/**
+ * lru_k_replacer_test.cpp
+ */
+
+#include <cstdio>
+#include <cstring>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/lru_k_replacer.h"
+#include "gtest/gtest.h"
+
+namespace scudb {
+
+TEST(LRUKReplacerTest, SampleTest) {
+  LRUKReplacer<int> lru_k_replacer(2);
+
+  // push element into replacer, 1 and 2 are referenced twice
+  lru_k_replacer.Insert(1);
+  lru_k_replacer.Insert(2);
+  lru_k_replacer.Insert(3);
+  lru_k_replacer.Insert(4);
+  lru_k_replacer.Insert(1);
+  lru_k_replacer.Insert(5);
+  lru_k_replacer.Insert(2);
+  EXPECT_EQ(5, lru_k_replacer.Size());
+
+  // frames with a single reference go first, oldest first
+  int value;
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(3, value);
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(4, value);
+
+  // remove element from replacer, its history survives
+  EXPECT_EQ(false, lru_k_replacer.Erase(4));
+  EXPECT_EQ(true, lru_k_replacer.Erase(5));
+  EXPECT_EQ(2, lru_k_replacer.Size());
+  lru_k_replacer.Insert(5);
+
+  // then by the second most recent reference
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(1, value);
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(2, value);
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(5, value);
+  EXPECT_EQ(false, lru_k_replacer.Victim(value));
+}
+
+TEST(LRUKReplacerTest, CorrelatedReferenceTest) {
+  LRUKReplacer<int> lru_k_replacer(2, 2);
+
+  // the second reference of 1 is correlated with the first one
+  lru_k_replacer.Insert(1);
+  lru_k_replacer.Insert(1);
+  lru_k_replacer.Insert(2);
+  lru_k_replacer.Insert(3);
+  lru_k_replacer.Insert(4);
+  lru_k_replacer.Insert(2);
+
+  int value;
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(1, value);
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(3, value);
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(4, value);
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(2, value);
+}
+
+TEST(LRUKReplacerTest, RemoveTest) {
+  LRUKReplacer<int> lru_k_replacer(2);
+
+  lru_k_replacer.Insert(2);
+  lru_k_replacer.Insert(2);
+  lru_k_replacer.Insert(1);
+  lru_k_replacer.Insert(1);
+  lru_k_replacer.Insert(3);
+
+  // the frame of 1 now holds another page, which has one reference only
+  lru_k_replacer.Remove(1);
+  EXPECT_EQ(2, lru_k_replacer.Size());
+  lru_k_replacer.Insert(1);
+
+  int value;
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(3, value);
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(1, value);
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(2, value);
+}
+
+// count how many hot pages stay resident while a scan runs through the pool.
+// a hot page keeps an in-memory marker that never reaches disk, it is lost
+// as soon as the page gets evicted
+static int HotPagesKeptDuringScan(ReplacerType replacer_type) {
+  const int pool_size = 16;
+  const int num_hot = 8;
+  const int num_cold = 100;
+  const char *marker = "hot";
+  DiskManager *disk_manager = new DiskManager("test.db", TEST_PAGE_SIZE);
+  BufferPoolManagerInstance bpm(pool_size, disk_manager,
+                                nullptr, replacer_type);
+
+  page_id_t page_id;
+  for (int i = 0; i < num_hot + num_cold; ++i) {
+    EXPECT_NE(nullptr, bpm.NewPage(page_id));
+    bpm.UnpinPage(page_id, true);
+  }
+  // point lookups make the hot pages hot
+  for (int round = 0; round < 8; ++round) {
+    for (page_id_t id = 0; id < num_hot; ++id) {
+      auto page = bpm.FetchPage(id);
+      if (round == 7) {
+        strcpy(page->GetData(), marker);
+      }
+      bpm.UnpinPage(id, false);
+    }
+  }
+  // sequential scan over the cold pages, interleaved with point lookups
+  for (page_id_t id = num_hot; id < num_hot + num_cold; ++id) {
+    bpm.FetchPage(id);
+    bpm.UnpinPage(id, false);
+    if (id % 2 == 0) {
+      page_id_t hot_id = (id / 2) % num_hot;
+      bpm.FetchPage(hot_id);
+      bpm.UnpinPage(hot_id, false);
+    }
+  }
+
+  int kept = 0;
+  for (page_id_t id = 0; id < num_hot; ++id) {
+    auto page = bpm.FetchPage(id);
+    if (strcmp(page->GetData(), marker) == 0) {
+      kept++;
+    }
+    bpm.UnpinPage(id, false);
+  }
+  delete disk_manager;
+  remove("test.db");
+  return kept;
+}
+
+TEST(LRUKReplacerTest, ScanResistanceTest) {
+  // plain LRU lets the scan flush the hot pages, LRU-K keeps all of them
+  EXPECT_LT(HotPagesKeptDuringScan(ReplacerType::LRU), 8);
+  EXPECT_EQ(8, HotPagesKeptDuringScan(ReplacerType::LRU_K));
+}
+
+} // namespace scudb
@@ -0,0 +1,294 @@
+/**
+ * parallel_buffer_pool_manager_test.cpp
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "gtest/gtest.h"
+#include "vtable/virtual_table.h"
+
+namespace scudb {
+
+TEST(ParallelBufferPoolManagerTest, SampleTest) {
+  remove("test.db");
+  remove("test.log");
+  page_id_t temp_page_id;
+
+  DiskManager *disk_manager = new DiskManager("test.db", TEST_PAGE_SIZE);
+  // 4 instances with 3 frames each
+  ParallelBufferPoolManager bpm(4, 12, disk_manager);
+  EXPECT_EQ(4, bpm.GetNumInstances());
+
+  auto page_zero = bpm.NewPage(temp_page_id);
+  ASSERT_NE(nullptr, page_zero);
+  EXPECT_EQ(0, temp_page_id);
+  strcpy(page_zero->GetData(), "Hello");
+
+  // page ids are spread round robin, so every instance fills up evenly
+  for (int i = 1; i < 12; ++i) {
+    EXPECT_NE(nullptr, bpm.NewPage(temp_page_id));
+    EXPECT_EQ(i, temp_page_id);
+  }
+  // all the frames of all the instances are pinned
+  EXPECT_EQ(nullptr, bpm.NewPage(temp_page_id));
+
+  // a page can only be fetched from the instance that owns it
+  for (int i = 0; i < 12; ++i) {
+    EXPECT_EQ(true, bpm.UnpinPage(i, true));
+  }
+  EXPECT_EQ(false, bpm.UnpinPage(0, false));
+  for (int i = 0; i < 12; ++i) {
+    EXPECT_NE(nullptr, bpm.NewPage(temp_page_id));
+    EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, false));
+  }
+
+  // page zero was evicted and written back, fetch it again
+  page_zero = bpm.FetchPage(0);
+  ASSERT_NE(nullptr, page_zero);
+  EXPECT_EQ(0, strcmp(page_zero->GetData(), "Hello"));
+  EXPECT_EQ(true, bpm.UnpinPage(0, false));
+
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(ParallelBufferPoolManagerTest, ConcurrentFetchTest) {
+  remove("test.db");
+  remove("test.log");
+  const int num_threads = 8;
+  const int num_pages = 64;
+  DiskManager *disk_manager = new DiskManager("test.db", TEST_PAGE_SIZE);
+  ParallelBufferPoolManager bpm(8, num_pages, disk_manager);
+
+  page_id_t page_id;
+  for (int i = 0; i < num_pages; ++i) {
+    auto page = bpm.NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    memcpy(page->GetData(), &page_id, sizeof(page_id));
+    bpm.UnpinPage(page_id, true);
+  }
+
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.push_back(std::thread([tid, &bpm]() {
+      for (int round = 0; round < 100; round++) {
+        for (page_id_t id = tid; id < num_pages; id += num_threads / 2) {
+          auto page = bpm.FetchPage(id);
+          ASSERT_NE(nullptr, page);
+          EXPECT_EQ(id, *reinterpret_cast<page_id_t *>(page->GetData()));
+          EXPECT_TRUE(bpm.UnpinPage(id, false));
+        }
+      }
+    }));
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(ParallelBufferPoolManagerTest, StorageEngineTest) {
+  remove("test.db");
+  remove("test.log");
+  // a single instance unless more are asked for
+  StorageEngine *storage_engine = new StorageEngine("test.db", 8);
+  EXPECT_NE(nullptr, dynamic_cast<BufferPoolManagerInstance *>(
+                         storage_engine->buffer_pool_manager_));
+  delete storage_engine;
+
+  storage_engine = new StorageEngine("test.db", 8, 4);
+  auto bpm = dynamic_cast<ParallelBufferPoolManager *>(
+      storage_engine->buffer_pool_manager_);
+  ASSERT_NE(nullptr, bpm);
+  EXPECT_EQ(4, bpm->GetNumInstances());
+  EXPECT_EQ(8, bpm->GetPoolSize());
+  page_id_t page_id;
+  for (int i = 0; i < 8; ++i) {
+    EXPECT_NE(nullptr, bpm->NewPage(page_id));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+  delete storage_engine;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(ParallelBufferPoolManagerTest, ResizeTest) {
+  remove("test.db");
+  remove("test.log");
+  DiskManager *disk_manager = new DiskManager("test.db", TEST_PAGE_SIZE);
+  ParallelBufferPoolManager bpm(4, 8, disk_manager);
+  page_id_t page_id;
+  for (int i = 0; i < 16; ++i) {
+    Page *page = bpm.NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    memcpy(page->GetData(), &page_id, sizeof(page_id));
+    EXPECT_EQ(true, bpm.UnpinPage(page_id, true));
+  }
+
+  // every instance gets its share of the frames
+  bpm.Resize(16);
+  EXPECT_EQ(16, bpm.GetPoolSize());
+  for (int i = 0; i < 16; ++i) {
+    EXPECT_NE(nullptr, bpm.FetchPage(i));
+  }
+  for (int i = 0; i < 16; ++i) {
+    EXPECT_EQ(true, bpm.UnpinPage(i, false));
+  }
+
+  bpm.Resize(6);
+  EXPECT_EQ(6, bpm.GetPoolSize());
+  ResizeProgress progress = bpm.GetResizeProgress();
+  EXPECT_FALSE(progress.in_progress);
+  EXPECT_EQ(6, progress.target_pool_size);
+  EXPECT_EQ(10, progress.frames_released);
+  for (int i = 0; i < 16; ++i) {
+    Page *page = bpm.FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(i, *reinterpret_cast<page_id_t *>(page->GetData()));
+    EXPECT_EQ(true, bpm.UnpinPage(i, false));
+  }
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(ParallelBufferPoolManagerTest, PageGuardTest) {
+  remove("test.db");
+  remove("test.log");
+  DiskManager *disk_manager = new DiskManager("test.db", TEST_PAGE_SIZE);
+  ParallelBufferPoolManager bpm(4, 8, disk_manager);
+  page_id_t page_id;
+  // guards release their frame in the instance that owns the page
+  {
+    std::vector<WritePageGuard> guards;
+    for (int i = 0; i < 8; ++i) {
+      guards.push_back(bpm.NewPageGuarded(page_id));
+      ASSERT_TRUE(static_cast<bool>(guards.back()));
+      memcpy(guards.back().GetDataMut(), &page_id, sizeof(page_id));
+    }
+    EXPECT_EQ(8, bpm.CheckPinLeaks());
+    EXPECT_FALSE(static_cast<bool>(bpm.NewPageGuarded(page_id)));
+  }
+  EXPECT_EQ(0, bpm.CheckPinLeaks());
+  EXPECT_EQ(8, bpm.GetStats().dirty_frames);
+
+  for (int i = 0; i < 8; ++i) {
+    ReadPageGuard guard = bpm.FetchPageRead(i);
+    ASSERT_TRUE(static_cast<bool>(guard));
+    EXPECT_EQ(i, *guard.As<page_id_t>());
+  }
+  EXPECT_EQ(0, bpm.CheckPinLeaks());
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(ParallelBufferPoolManagerTest, WarmStateTest) {
+  remove("test.db");
+  remove("test.log");
+  remove("test.warm");
+  DiskManager *disk_manager = new DiskManager("test.db", TEST_PAGE_SIZE);
+  ParallelBufferPoolManager *bpm =
+      new ParallelBufferPoolManager(4, 8, disk_manager);
+  page_id_t page_id;
+  for (int i = 0; i < 16; ++i) {
+    Page *page = bpm->NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    memcpy(page->GetData(), &page_id, sizeof(page_id));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+  bpm->FlushAllPages();
+  EXPECT_EQ(true, bpm->DumpWarmState("test.warm"));
+  delete bpm;
+
+  // pages 8 to 15 were resident, each instance restores its own
+  bpm = new ParallelBufferPoolManager(2, 8, disk_manager);
+  EXPECT_EQ(8, bpm->RestoreWarmState("test.warm"));
+  bpm->WaitForWarmRestore();
+  for (int i = 8; i < 16; ++i) {
+    Page *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(i, *reinterpret_cast<page_id_t *>(page->GetData()));
+    EXPECT_EQ(true, bpm->UnpinPage(i, false));
+  }
+  EXPECT_EQ(0, bpm->GetStats().misses);
+  delete bpm;
+
+  delete disk_manager;
+  remove("test.db");
+  remove("test.warm");
+}
+
+/*
+ * Hit path throughput, single latch vs. partitioned pool.
+ * Run with --gtest_also_run_disabled_tests
+ */
+TEST(ParallelBufferPoolManagerTest, DISABLED_HitThroughputBenchmark) {
+  remove("test.db");
+  remove("test.log");
+  const int num_pages = 1024;
+  const int ops_per_thread = 1000000;
+  DiskManager *disk_manager = new DiskManager("test.db", TEST_PAGE_SIZE);
+
+  for (size_t num_instances : {1, 16}) {
+    BufferPoolManager *bpm;
+    if (num_instances == 1) {
+      bpm = new BufferPoolManagerInstance(num_pages, disk_manager);
+    } else {
+      bpm = new ParallelBufferPoolManager(num_instances, num_pages,
+                                          disk_manager);
+    }
+    std::vector<page_id_t> page_ids;
+    page_id_t page_id;
+    for (int i = 0; i < num_pages; ++i) {
+      if (bpm->NewPage(page_id) == nullptr) {
+        break;
+      }
+      bpm->UnpinPage(page_id, false);
+      page_ids.push_back(page_id);
+    }
+
+    for (int num_threads = 1; num_threads <= 32; num_threads *= 2) {
+      std::vector<std::thread> threads;
+      auto start = std::chrono::steady_clock::now();
+      for (int tid = 0; tid < num_threads; tid++) {
+        threads.push_back(std::thread([tid, bpm, &page_ids]() {
+          std::mt19937 gen(tid);
+          std::uniform_int_distribution<size_t> dis(0, page_ids.size() - 1);
+          for (int i = 0; i < ops_per_thread; i++) {
+            page_id_t id = page_ids[dis(gen)];
+            bpm->FetchPage(id);
+            bpm->UnpinPage(id, false);
+          }
+        }));
+      }
+      for (auto &thread : threads) {
+        thread.join();
+      }
+      std::chrono::duration<double> elapsed =
+          std::chrono::steady_clock::now() - start;
+      std::cout << "instances: " << num_instances
+                << " threads: " << num_threads << " ops/sec: "
+                << static_cast<long>(num_threads * ops_per_thread /
+                                     elapsed.count())
+                << std::endl;
+    }
+    delete bpm;
+  }
+
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+} // namespace scudb
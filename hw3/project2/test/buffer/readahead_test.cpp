@@ -0,0 +1,203 @@
+/**
+ * readahead_test.cpp
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "buffer/readahead.h"
+#include "logging/common.h"
+#include "table/table_heap.h"
+#include "vtable/virtual_table.h"
+#include "gtest/gtest.h"
+
+namespace scudb {
+
+// write num_pages pages holding their own page id into test.db
+static void WriteFile(DiskManager *disk_manager, int num_pages,
+                      const char *tag) {
+  char buffer[TEST_PAGE_SIZE];
+  for (int i = 0; i < num_pages; ++i) {
+    memset(buffer, 0, TEST_PAGE_SIZE);
+    snprintf(buffer, TEST_PAGE_SIZE, "%s %d", tag, i);
+    disk_manager->WritePage(disk_manager->AllocatePage(), buffer);
+  }
+}
+
+// a prefetched page still holds the old content after the file is rewritten
+static bool IsResident(BufferPoolManager *bpm, page_id_t page_id) {
+  char expected[TEST_PAGE_SIZE];
+  snprintf(expected, TEST_PAGE_SIZE, "old %d", page_id);
+  Page *page = bpm->FetchPage(page_id);
+  bool resident = strcmp(page->GetData(), expected) == 0;
+  bpm->UnpinPage(page_id, false);
+  return resident;
+}
+
+static void Rewrite(DiskManager *disk_manager, int num_pages) {
+  char buffer[TEST_PAGE_SIZE];
+  for (int i = 0; i < num_pages; ++i) {
+    memset(buffer, 0, TEST_PAGE_SIZE);
+    snprintf(buffer, TEST_PAGE_SIZE, "new %d", i);
+    disk_manager->WritePage(i, buffer);
+  }
+}
+
+TEST(ReadaheadTest, PrefetchPagesTest) {
+  remove("test.db");
+  remove("test.log");
+  DiskManager *disk_manager = new DiskManager("test.db", TEST_PAGE_SIZE);
+  WriteFile(disk_manager, 20, "old");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(40, disk_manager);
+
+  // stops at the end of file
+  EXPECT_EQ(4, bpm->PrefetchPages(16, 10));
+  EXPECT_EQ(0, bpm->PrefetchPages(20, 10));
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  // a quarter of the pool can be queued
+  EXPECT_EQ(10, bpm->PrefetchPages(0, 12));
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  EXPECT_EQ(4, bpm->PrefetchPages(10, 4));
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  Rewrite(disk_manager, 20);
+  for (int i = 0; i < 14; ++i) {
+    EXPECT_TRUE(IsResident(bpm, i)) << i;
+  }
+  EXPECT_FALSE(IsResident(bpm, 14));
+  for (int i = 16; i < 20; ++i) {
+    EXPECT_TRUE(IsResident(bpm, i)) << i;
+  }
+
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(ReadaheadTest, DirtyPageTest) {
+  remove("test.db");
+  remove("test.log");
+  DiskManager *disk_manager = new DiskManager("test.db", TEST_PAGE_SIZE);
+  WriteFile(disk_manager, 10, "old");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(4, disk_manager);
+
+  // fill the pool with dirty pages, readahead must not write them back
+  for (int i = 0; i < 4; ++i) {
+    Page *page = bpm->FetchPage(i);
+    snprintf(page->GetData(), TEST_PAGE_SIZE, "dirty %d", i);
+    bpm->UnpinPage(i, true);
+  }
+  EXPECT_EQ(1, bpm->PrefetchPages(4, 1));
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  for (int i = 0; i < 4; ++i) {
+    char expected[TEST_PAGE_SIZE];
+    snprintf(expected, TEST_PAGE_SIZE, "dirty %d", i);
+    Page *page = bpm->FetchPage(i);
+    EXPECT_EQ(0, strcmp(page->GetData(), expected));
+    bpm->UnpinPage(i, false);
+  }
+
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(ReadaheadTest, WindowTest) {
+  remove("test.db");
+  remove("test.log");
+  DiskManager *disk_manager = new DiskManager("test.db", TEST_PAGE_SIZE);
+  WriteFile(disk_manager, 100, "old");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(400, disk_manager);
+  Readahead readahead(bpm);
+
+  // first sequential move prefetches READAHEAD_MIN_PAGES pages
+  readahead.Advance(0, 1);
+  EXPECT_EQ(READAHEAD_MIN_PAGES, readahead.GetWindow());
+  readahead.Advance(1, 2);
+  EXPECT_EQ(READAHEAD_MIN_PAGES, readahead.GetWindow());
+  // half of the window is consumed, it doubles
+  readahead.Advance(2, 3);
+  readahead.Advance(3, 4);
+  EXPECT_EQ(2 * READAHEAD_MIN_PAGES, readahead.GetWindow());
+  for (page_id_t i = 5; i < 60; ++i) {
+    readahead.Advance(i - 1, i);
+  }
+  EXPECT_EQ(READAHEAD_MAX_PAGES, readahead.GetWindow());
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  Rewrite(disk_manager, 100);
+  for (page_id_t i = 2; i < 60; ++i) {
+    EXPECT_TRUE(IsResident(bpm, i)) << i;
+  }
+
+  // a jump resets the window
+  readahead.Advance(60, 90);
+  EXPECT_EQ(0, readahead.GetWindow());
+
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(ReadaheadTest, ParallelTest) {
+  remove("test.db");
+  remove("test.log");
+  DiskManager *disk_manager = new DiskManager("test.db", TEST_PAGE_SIZE);
+  WriteFile(disk_manager, 20, "old");
+  ParallelBufferPoolManager *bpm =
+      new ParallelBufferPoolManager(4, 40, disk_manager);
+
+  // pages are spread over the instances
+  EXPECT_EQ(8, bpm->PrefetchPages(0, 8));
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  Rewrite(disk_manager, 20);
+  for (int i = 0; i < 8; ++i) {
+    EXPECT_TRUE(IsResident(bpm, i)) << i;
+  }
+
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(ReadaheadTest, TableScanTest) {
+  remove("test.db");
+  remove("test.log");
+  Schema *schema = ParseCreateStatement("a bigint, b varchar(64)");
+  Transaction *transaction = new Transaction(0);
+  DiskManager *disk_manager = new DiskManager("test.db", TEST_PAGE_SIZE);
+  BufferPoolManager *buffer_pool_manager =
+      new BufferPoolManagerInstance(16, disk_manager);
+  LockManager *lock_manager = new LockManager(true);
+  LogManager *log_manager = new LogManager(disk_manager);
+  TableHeap *table = new TableHeap(buffer_pool_manager, lock_manager,
+                                   log_manager, transaction);
+
+  // many more pages than frames, the scan goes through readahead
+  Tuple tuple = ConstructTuple(schema);
+  RID rid;
+  for (int i = 0; i < 2000; ++i) {
+    EXPECT_TRUE(table->InsertTuple(tuple, rid, transaction));
+  }
+  int count = 0;
+  for (auto itr = table->begin(transaction); itr != table->end(); ++itr) {
+    count++;
+  }
+  EXPECT_EQ(2000, count);
+
+  delete table;
+  delete log_manager;
+  delete lock_manager;
+  delete buffer_pool_manager;
+  delete disk_manager;
+  delete transaction;
+  delete schema;
+  remove("test.db");
+  remove("test.log");
+}
+
+} // namespace scudb
@@ -0,0 +1,185 @@
+/**
+ * rwlatch_test.cpp
+ */
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "common/rwlatch.h"
+#include "common/rwmutex.h"
+#include "gtest/gtest.h"
+
+namespace scudb {
+
+template <typename Latch> class LatchedCounter {
+public:
+  LatchedCounter() : count_(0) {}
+  void Add(int num) {
+    latch_.WLock();
+    count_ += num;
+    latch_.WUnlock();
+  }
+  int Read() {
+    int res;
+    latch_.RLock();
+    res = count_;
+    latch_.RUnlock();
+    return res;
+  }
+
+private:
+  int count_;
+  Latch latch_;
+};
+
+TEST(RWLatchTest, BasicTest) {
+  EXPECT_EQ(8, sizeof(RWLatch));
+  int num_threads = 100;
+  LatchedCounter<RWLatch> counter;
+  counter.Add(5);
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    if (tid % 2 == 0) {
+      threads.push_back(std::thread([&counter]() { counter.Read(); }));
+    } else {
+      threads.push_back(std::thread([&counter]() { counter.Add(1); }));
+    }
+  }
+  for (int i = 0; i < num_threads; i++) {
+    threads[i].join();
+  }
+  EXPECT_EQ(counter.Read(), 55);
+}
+
+TEST(RWLatchTest, TryLockTest) {
+  RWLatch latch;
+  EXPECT_TRUE(latch.TryRLock());
+  EXPECT_TRUE(latch.TryRLock());
+  EXPECT_FALSE(latch.TryWLock());
+  latch.RUnlock();
+  latch.RUnlock();
+
+  EXPECT_TRUE(latch.TryWLock());
+  EXPECT_FALSE(latch.TryWLock());
+  EXPECT_FALSE(latch.TryRLock());
+  latch.WUnlock();
+
+  // readers wait behind a waiting writer
+  latch.RLock();
+  std::atomic<bool> written(false);
+  std::thread writer([&latch, &written]() {
+    latch.WLock();
+    written.store(true);
+    latch.WUnlock();
+  });
+  while (latch.TryRLock()) {
+    latch.RUnlock();
+    std::this_thread::yield();
+  }
+  EXPECT_FALSE(written.load());
+  latch.RUnlock();
+  writer.join();
+  EXPECT_TRUE(written.load());
+}
+
+TEST(RWLatchTest, UpgradeTest) {
+  RWLatch latch;
+  latch.RLock();
+  EXPECT_TRUE(latch.TryUpgrade());
+  EXPECT_FALSE(latch.TryRLock());
+  latch.Downgrade();
+  EXPECT_TRUE(latch.TryRLock());
+  // two readers, nobody may upgrade without waiting
+  EXPECT_FALSE(latch.TryUpgrade());
+  latch.RUnlock();
+
+  // the upgrade waits for the other reader, a second upgrade gives up
+  std::atomic<bool> upgraded(false);
+  std::thread upgrader([&latch, &upgraded]() {
+    latch.RLock();
+    EXPECT_TRUE(latch.Upgrade());
+    upgraded.store(true);
+    latch.WUnlock();
+  });
+  while (latch.TryRLock()) {
+    latch.RUnlock();
+    std::this_thread::yield();
+  }
+  EXPECT_FALSE(latch.Upgrade());
+  EXPECT_FALSE(upgraded.load());
+  latch.RUnlock();
+  upgrader.join();
+  EXPECT_TRUE(upgraded.load());
+
+  EXPECT_TRUE(latch.TryWLock());
+  latch.WUnlock();
+}
+
+TEST(RWLatchTest, UpgradeCounterTest) {
+  // read, then upgrade to add, as a page latch is used to look before writing
+  const int num_threads = 16;
+  const int rounds = 1000;
+  RWLatch latch;
+  int count = 0;
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.push_back(std::thread([&latch, &count]() {
+      for (int i = 0; i < rounds; i++) {
+        latch.RLock();
+        while (!latch.Upgrade()) {
+          latch.RUnlock();
+          std::this_thread::yield();
+          latch.RLock();
+        }
+        count++;
+        latch.WUnlock();
+      }
+    }));
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(num_threads * rounds, count);
+}
+
+template <typename Latch> double CounterThroughput(int num_threads) {
+  const int ops_per_thread = 200000;
+  LatchedCounter<Latch> counter;
+  std::vector<std::thread> threads;
+  auto start = std::chrono::steady_clock::now();
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.push_back(std::thread([&counter]() {
+      // mostly reads, like page latches of inner B+ tree pages
+      for (int i = 0; i < ops_per_thread; i++) {
+        if (i % 64 == 0) {
+          counter.Add(1);
+        } else {
+          counter.Read();
+        }
+      }
+    }));
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return num_threads * ops_per_thread / elapsed.count();
+}
+
+TEST(RWLatchTest, DISABLED_CounterBenchmark) {
+  std::cout << "RWMutex " << sizeof(RWMutex) << " bytes, RWLatch "
+            << sizeof(RWLatch) << " bytes" << std::endl;
+  for (int num_threads = 1; num_threads <= 64; num_threads *= 2) {
+    std::cout << "threads: " << num_threads << " RWMutex ops/sec: "
+              << static_cast<long>(CounterThroughput<RWMutex>(num_threads))
+              << " RWLatch ops/sec: "
+              << static_cast<long>(CounterThroughput<RWLatch>(num_threads))
+              << std::endl;
+  }
+}
+
+} // namespace scudb
@@ -0,0 +1,58 @@
+/**
+ * stats_test.cpp
+ */
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "common/stats.h"
+#include "gtest/gtest.h"
+
+namespace scudb {
+
+TEST(StatsTest, CounterTest) {
+  StatCounters<2> counters;
+  std::vector<std::thread> threads;
+  // more threads than shards, some of them share a shard
+  for (int tid = 0; tid < STAT_SHARDS + 4; tid++) {
+    threads.push_back(std::thread([&counters]() {
+      for (int i = 0; i < 1000; i++) {
+        counters.Add(0);
+        counters.Add(1, 2);
+      }
+    }));
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ((STAT_SHARDS + 4) * 1000, counters.Get(0));
+  EXPECT_EQ((STAT_SHARDS + 4) * 2000, counters.Get(1));
+}
+
+TEST(StatsTest, HistogramTest) {
+  LatencyRecorder recorder;
+  for (int i = 0; i < 98; i++) {
+    recorder.Record(std::chrono::microseconds(0));
+  }
+  recorder.Record(std::chrono::microseconds(3));
+  recorder.Record(std::chrono::milliseconds(5));
+
+  LatencyHistogram histogram = recorder.GetHistogram();
+  EXPECT_EQ(100, histogram.count);
+  EXPECT_EQ(5003, histogram.total_us);
+  EXPECT_EQ(98, histogram.buckets[0]);
+  // 3us falls into [2, 4), 5000us into [4096, 8192)
+  EXPECT_EQ(1, histogram.buckets[2]);
+  EXPECT_EQ(1, histogram.buckets[13]);
+  EXPECT_EQ(1, histogram.Percentile(0.5));
+  EXPECT_EQ(4, histogram.Percentile(0.99));
+  EXPECT_EQ(8192, histogram.Percentile(1));
+
+  // far beyond the buckets
+  recorder.Record(std::chrono::seconds(100));
+  histogram = recorder.GetHistogram();
+  EXPECT_EQ(1, histogram.buckets[LatencyHistogram::NUM_BUCKETS - 1]);
+}
+
+} // namespace scudb
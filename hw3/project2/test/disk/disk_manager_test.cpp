@@ -0,0 +1,386 @@
+/**
+ * disk_manager_test.cpp
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "common/exception.h"
+#include "disk/disk_manager.h"
+#include "gtest/gtest.h"
+
+namespace scudb {
+
+TEST(DiskManagerTest, ReadWriteTest) {
+  remove("test.db");
+  remove("test.log");
+  DiskManager *disk_manager = new DiskManager("test.db", TEST_PAGE_SIZE);
+  char buffer[TEST_PAGE_SIZE], data[TEST_PAGE_SIZE];
+  EXPECT_EQ(0, disk_manager->GetNumPages());
+
+  // page written past the end grows the file, the hole reads as zeros
+  memset(data, 0, TEST_PAGE_SIZE);
+  strcpy(data, "page 3");
+  disk_manager->WritePage(3, data);
+  EXPECT_EQ(4, disk_manager->GetNumPages());
+  disk_manager->ReadPage(3, buffer);
+  EXPECT_EQ(0, memcmp(buffer, data, TEST_PAGE_SIZE));
+  memset(buffer, 1, TEST_PAGE_SIZE);
+  disk_manager->ReadPage(1, buffer);
+  for (int i = 0; i < TEST_PAGE_SIZE; ++i) {
+    EXPECT_EQ(0, buffer[i]);
+  }
+  delete disk_manager;
+
+  // file size survives reopen
+  disk_manager = new DiskManager("test.db", TEST_PAGE_SIZE);
+  EXPECT_EQ(4, disk_manager->GetNumPages());
+  disk_manager->ReadPage(3, buffer);
+  EXPECT_EQ(0, memcmp(buffer, data, TEST_PAGE_SIZE));
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(DiskManagerTest, AllocateTest) {
+  remove("test.db");
+  remove("test.log");
+  DiskManager *disk_manager = new DiskManager("test.db", TEST_PAGE_SIZE);
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_EQ(i, disk_manager->AllocatePage());
+  }
+  // freed pages are reused, lowest first
+  disk_manager->DeallocatePage(5);
+  disk_manager->DeallocatePage(3);
+  disk_manager->DeallocatePage(3);
+  EXPECT_FALSE(disk_manager->IsAllocated(3));
+  EXPECT_EQ(3, disk_manager->AllocatePage());
+  EXPECT_TRUE(disk_manager->IsAllocated(3));
+  delete disk_manager;
+
+  // allocation state survives reopen
+  disk_manager = new DiskManager("test.db", TEST_PAGE_SIZE);
+  EXPECT_TRUE(disk_manager->IsAllocated(9));
+  EXPECT_FALSE(disk_manager->IsAllocated(5));
+  EXPECT_EQ(5, disk_manager->AllocatePage());
+  EXPECT_EQ(10, disk_manager->AllocatePage());
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(DiskManagerTest, ExtentTest) {
+  remove("test.db");
+  remove("test.log");
+  DiskManager *disk_manager = new DiskManager("test.db", TEST_PAGE_SIZE);
+  const int pages_per_extent = disk_manager->GetPagesPerExtent();
+  const int num_pages = pages_per_extent + 10;
+  for (int i = 0; i < num_pages; ++i) {
+    EXPECT_EQ(i, disk_manager->AllocatePage());
+  }
+
+  // a batch across the end of the first extent skips its bitmap page
+  std::vector<std::vector<char>> data(20, std::vector<char>(TEST_PAGE_SIZE));
+  std::vector<std::pair<page_id_t, const char *>> pages;
+  for (int i = 0; i < 20; ++i) {
+    page_id_t page_id = pages_per_extent - 10 + i;
+    snprintf(data[i].data(), TEST_PAGE_SIZE, "page %d", page_id);
+    pages.emplace_back(page_id, data[i].data());
+  }
+  disk_manager->WritePages(pages);
+  EXPECT_EQ(num_pages, disk_manager->GetNumPages());
+  delete disk_manager;
+
+  disk_manager = new DiskManager("test.db", TEST_PAGE_SIZE);
+  char buffer[TEST_PAGE_SIZE];
+  for (int i = 0; i < 20; ++i) {
+    disk_manager->ReadPage(pages_per_extent - 10 + i, buffer);
+    EXPECT_EQ(0, memcmp(buffer, data[i].data(), TEST_PAGE_SIZE));
+  }
+  disk_manager->DeallocatePage(pages_per_extent + 1);
+  EXPECT_EQ(pages_per_extent + 1, disk_manager->AllocatePage());
+  EXPECT_EQ(num_pages, disk_manager->AllocatePage());
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(DiskManagerTest, ConcurrentTest) {
+  remove("test.db");
+  remove("test.log");
+  DiskManager *disk_manager = new DiskManager("test.db", TEST_PAGE_SIZE);
+  const int num_threads = 8;
+  const int num_pages = 50;
+
+  // every thread writes and reads back its own pages, interleaved with the
+  // pages of the other threads
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; ++tid) {
+    threads.push_back(std::thread([disk_manager, tid] {
+      char buffer[TEST_PAGE_SIZE], data[TEST_PAGE_SIZE];
+      for (int round = 0; round < 3; ++round) {
+        for (int i = 0; i < num_pages; ++i) {
+          page_id_t page_id = i * num_threads + tid;
+          memset(data, tid + round, TEST_PAGE_SIZE);
+          snprintf(data, TEST_PAGE_SIZE, "page %d", page_id);
+          disk_manager->WritePage(page_id, data);
+          disk_manager->ReadPage(page_id, buffer);
+          EXPECT_EQ(0, memcmp(buffer, data, TEST_PAGE_SIZE));
+        }
+      }
+    }));
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(num_threads * num_pages, disk_manager->GetNumPages());
+
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(DiskManagerTest, AsyncTest) {
+  remove("test.db");
+  remove("test.log");
+  const int num_pages = 200;
+  for (auto type : {AsyncIOType::THREAD_POOL, AsyncIOType::IO_URING}) {
+    DiskManager *disk_manager =
+        new DiskManager("test.db", TEST_PAGE_SIZE, type);
+    std::vector<std::vector<char>> data(num_pages,
+                                        std::vector<char>(TEST_PAGE_SIZE));
+    std::vector<std::future<void>> futures;
+
+    // more requests than the queue depth are in flight at once
+    for (int i = 0; i < num_pages; ++i) {
+      snprintf(data[i].data(), TEST_PAGE_SIZE, "page %d", i);
+      futures.push_back(disk_manager->WritePageAsync(i, data[i].data()));
+    }
+    for (auto &future : futures) {
+      future.wait();
+    }
+    futures.clear();
+    EXPECT_EQ(num_pages, disk_manager->GetNumPages());
+
+    std::vector<std::vector<char>> buffers(
+        num_pages, std::vector<char>(TEST_PAGE_SIZE, 1));
+    for (int i = 0; i < num_pages; ++i) {
+      futures.push_back(disk_manager->ReadPageAsync(i, buffers[i].data()));
+    }
+    for (int i = 0; i < num_pages; ++i) {
+      futures[i].wait();
+      EXPECT_EQ(data[i], buffers[i]);
+    }
+
+    // synchronous and asynchronous I/O see the same file
+    char buffer[TEST_PAGE_SIZE];
+    disk_manager->ReadPage(num_pages - 1, buffer);
+    EXPECT_EQ(0, memcmp(buffer, data[num_pages - 1].data(), TEST_PAGE_SIZE));
+
+    delete disk_manager;
+    remove("test.db");
+    remove("test.log");
+  }
+}
+
+TEST(DiskManagerTest, WritePagesTest) {
+  remove("test.db");
+  remove("test.log");
+  DiskManager *disk_manager = new DiskManager("test.db", TEST_PAGE_SIZE);
+  disk_manager->SetSyncPolicy(SyncPolicy::PER_BATCH);
+  const int num_pages = 10;
+  char data[num_pages][TEST_PAGE_SIZE];
+  char buffer[TEST_PAGE_SIZE];
+
+  // out of order, with a hole at page 5
+  std::vector<std::pair<page_id_t, const char *>> pages;
+  for (int i : {9, 3, 0, 7, 1, 2, 8, 4, 6}) {
+    memset(data[i], 0, TEST_PAGE_SIZE);
+    snprintf(data[i], TEST_PAGE_SIZE, "page %d", i);
+    pages.emplace_back(i, data[i]);
+  }
+  int num_syncs = disk_manager->GetNumSyncs();
+  disk_manager->WritePages(pages);
+  // one sync for the whole batch
+  EXPECT_EQ(num_syncs + 1, disk_manager->GetNumSyncs());
+  EXPECT_EQ(num_pages, disk_manager->GetNumPages());
+  for (int i = 0; i < num_pages; ++i) {
+    disk_manager->ReadPage(i, buffer);
+    if (i == 5) {
+      EXPECT_EQ(0, buffer[0]);
+    } else {
+      EXPECT_EQ(0, memcmp(buffer, data[i], TEST_PAGE_SIZE));
+    }
+  }
+
+  // per commit policy only syncs the log
+  disk_manager->SetSyncPolicy(SyncPolicy::PER_COMMIT);
+  num_syncs = disk_manager->GetNumSyncs();
+  disk_manager->WritePages(pages);
+  EXPECT_EQ(num_syncs, disk_manager->GetNumSyncs());
+  char log_data[] = "log record";
+  disk_manager->WriteLog(log_data, sizeof(log_data));
+  EXPECT_EQ(num_syncs + 1, disk_manager->GetNumSyncs());
+  char log_buffer[sizeof(log_data)];
+  EXPECT_TRUE(disk_manager->ReadLog(log_buffer, sizeof(log_data), 0));
+  EXPECT_STREQ(log_data, log_buffer);
+  EXPECT_FALSE(
+      disk_manager->ReadLog(log_buffer, sizeof(log_data), sizeof(log_data)));
+
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(DiskManagerTest, PageSizeTest) {
+  remove("test.db");
+  DiskManager *disk_manager = new DiskManager("test.db", 8192);
+  EXPECT_EQ(8192, disk_manager->GetPageSize());
+  EXPECT_EQ(8192 * 8, disk_manager->GetPagesPerExtent());
+  std::vector<char> data(8192), buffer(8192);
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(i, disk_manager->AllocatePage());
+  }
+  memset(data.data(), 7, 8192);
+  snprintf(data.data() + 8000, 100, "end of page");
+  disk_manager->WritePage(2, data.data());
+  delete disk_manager;
+
+  // page size of an existing file comes from its header
+  disk_manager = new DiskManager("test.db", TEST_PAGE_SIZE);
+  EXPECT_EQ(8192, disk_manager->GetPageSize());
+  EXPECT_EQ(3, disk_manager->GetNumPages());
+  disk_manager->ReadPage(2, buffer.data());
+  EXPECT_EQ(0, memcmp(buffer.data(), data.data(), 8192));
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+
+  // sizes out of range fall back to the default, only tests go below it
+  for (size_t page_size : {1000, 1024, MAX_PAGE_SIZE * 2}) {
+    disk_manager = new DiskManager("test.db", page_size);
+    EXPECT_EQ(DEFAULT_PAGE_SIZE, disk_manager->GetPageSize());
+    delete disk_manager;
+    remove("test.db");
+    remove("test.log");
+  }
+  disk_manager = new DiskManager("test.db", TEST_PAGE_SIZE);
+  EXPECT_EQ(TEST_PAGE_SIZE, disk_manager->GetPageSize());
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(DiskManagerTest, NoHeaderTest) {
+  remove("test.db");
+  remove("test.log");
+  // a file of the format before extents starts with a data page
+  char data[TEST_PAGE_SIZE], buffer[TEST_PAGE_SIZE];
+  memset(data, 0, TEST_PAGE_SIZE);
+  snprintf(data, TEST_PAGE_SIZE, "page 0 of an old db file");
+  FILE *file = fopen("test.db", "wb");
+  ASSERT_NE(nullptr, file);
+  fwrite(data, 1, TEST_PAGE_SIZE, file);
+  fclose(file);
+
+  // it is refused and left as it is
+  EXPECT_THROW(DiskManager("test.db", TEST_PAGE_SIZE), Exception);
+  file = fopen("test.db", "rb");
+  ASSERT_NE(nullptr, file);
+  EXPECT_EQ(static_cast<size_t>(TEST_PAGE_SIZE),
+            fread(buffer, 1, TEST_PAGE_SIZE, file));
+  fclose(file);
+  EXPECT_EQ(0, memcmp(buffer, data, TEST_PAGE_SIZE));
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(DiskManagerTest, DirectIOTest) {
+  remove("test.db");
+  const size_t page_size = 4096;
+  DiskManager *disk_manager =
+      new DiskManager("test.db", page_size, AsyncIOType::IO_URING, true);
+  if (!disk_manager->IsDirectIO()) {
+    std::cout << "O_DIRECT not supported here, buffered I/O is tested"
+              << std::endl;
+  }
+  for (int i = 0; i < 8; ++i) {
+    EXPECT_EQ(i, disk_manager->AllocatePage());
+  }
+
+  // buffers that are not aligned are copied, aligned ones go to disk as is
+  std::vector<char> storage(9 * page_size);
+  char *unaligned = storage.data() + 1;
+  void *aligned_data = nullptr;
+  ASSERT_EQ(0, posix_memalign(&aligned_data, DIRECT_IO_ALIGNMENT,
+                              8 * page_size));
+  char *aligned = static_cast<char *>(aligned_data);
+  for (int i = 0; i < 8; ++i) {
+    memset(aligned + i * page_size, 'a' + i, page_size);
+  }
+  memset(unaligned, 'x', page_size);
+  disk_manager->WritePage(0, unaligned);
+  std::vector<std::pair<page_id_t, const char *>> pages;
+  for (int i = 1; i < 4; ++i) {
+    pages.emplace_back(i, aligned + i * page_size);
+  }
+  pages.emplace_back(4, unaligned);
+  disk_manager->WritePages(pages);
+  disk_manager->WritePageAsync(5, aligned + 5 * page_size).wait();
+  disk_manager->WritePageAsync(6, unaligned).wait();
+  delete disk_manager;
+
+  disk_manager =
+      new DiskManager("test.db", 512, AsyncIOType::THREAD_POOL, true);
+  EXPECT_EQ(page_size, disk_manager->GetPageSize());
+  std::vector<char> expected(page_size);
+  for (int i = 0; i < 7; ++i) {
+    char fill = (i == 0 || i == 4 || i == 6) ? 'x' : 'a' + i;
+    memset(expected.data(), fill, page_size);
+    if (i % 2 == 0) {
+      disk_manager->ReadPage(i, unaligned);
+    } else {
+      disk_manager->ReadPageAsync(i, unaligned).wait();
+    }
+    EXPECT_EQ(0, memcmp(unaligned, expected.data(), page_size));
+    disk_manager->ReadPageAsync(i, aligned).wait();
+    EXPECT_EQ(0, memcmp(aligned, expected.data(), page_size));
+  }
+  free(aligned);
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(DiskManagerTest, PeriodicSyncTest) {
+  remove("test.db");
+  remove("test.log");
+  auto sync_interval = SYNC_INTERVAL;
+  SYNC_INTERVAL = std::chrono::milliseconds(10);
+  DiskManager *disk_manager = new DiskManager("test.db", TEST_PAGE_SIZE);
+  disk_manager->SetSyncPolicy(SyncPolicy::PERIODIC);
+
+  // log writes are left to the sync thread
+  int num_syncs = disk_manager->GetNumSyncs();
+  char log_data[] = "log record";
+  disk_manager->WriteLog(log_data, sizeof(log_data));
+  EXPECT_EQ(num_syncs, disk_manager->GetNumSyncs());
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  EXPECT_LT(num_syncs, disk_manager->GetNumSyncs());
+
+  // stopping the thread does a last sync, nothing after it
+  disk_manager->SetSyncPolicy(SyncPolicy::PER_COMMIT);
+  num_syncs = disk_manager->GetNumSyncs();
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_EQ(num_syncs, disk_manager->GetNumSyncs());
+
+  SYNC_INTERVAL = sync_interval;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+} // namespace scudb
@@ -0,0 +1,170 @@
+/**
+ * linear_probe_hash_table_test.cpp
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "common/exception.h"
+#include "hash/extendible_hash.h"
+#include "hash/linear_probe_hash_table.h"
+#include "gtest/gtest.h"
+
+namespace scudb {
+
+TEST(LinearProbeHashTableTest, SampleTest) {
+  LinearProbeHashTable<int, int> test(10);
+  EXPECT_EQ(32, test.GetCapacity());
+
+  for (int i = 0; i < 20; ++i) {
+    test.Insert(i, i * 10);
+  }
+  EXPECT_EQ(20, test.GetSize());
+  // overwrite
+  test.Insert(3, 300);
+  EXPECT_EQ(20, test.GetSize());
+
+  int value;
+  EXPECT_TRUE(test.Find(3, value));
+  EXPECT_EQ(300, value);
+  EXPECT_TRUE(test.Find(19, value));
+  EXPECT_EQ(190, value);
+  EXPECT_FALSE(test.Find(20, value));
+
+  EXPECT_TRUE(test.Remove(3));
+  EXPECT_FALSE(test.Remove(3));
+  EXPECT_FALSE(test.Find(3, value));
+  EXPECT_EQ(19, test.GetSize());
+}
+
+TEST(LinearProbeHashTableTest, RemoveTest) {
+  // every slot but one is used, entries of long clusters must stay
+  // reachable after the entries before them are removed
+  LinearProbeHashTable<int, int> test(4);
+  for (int i = 0; i < 7; ++i) {
+    test.Insert(i, i);
+  }
+  EXPECT_THROW(test.Insert(7, 7), Exception);
+
+  std::mt19937 gen(0);
+  std::vector<int> keys = {0, 1, 2, 3, 4, 5, 6};
+  std::shuffle(keys.begin(), keys.end(), gen);
+  int value;
+  for (size_t i = 0; i < keys.size(); ++i) {
+    EXPECT_TRUE(test.Remove(keys[i]));
+    for (size_t j = 0; j < keys.size(); ++j) {
+      EXPECT_EQ(j > i, test.Find(keys[j], value));
+    }
+  }
+
+  // slots are reused
+  for (int round = 0; round < 100; ++round) {
+    for (int i = 0; i < 7; ++i) {
+      test.Insert(round * 7 + i, i);
+    }
+    for (int i = 0; i < 7; ++i) {
+      EXPECT_TRUE(test.Remove(round * 7 + i));
+    }
+  }
+  EXPECT_EQ(0, test.GetSize());
+}
+
+TEST(LinearProbeHashTableTest, ConcurrentFindTest) {
+  const int num_keys = 1000;
+  const int num_threads = 4;
+  LinearProbeHashTable<int, int> test(num_keys);
+  // even keys stay, odd keys come and go
+  for (int i = 0; i < num_keys; i += 2) {
+    test.Insert(i, i);
+  }
+
+  std::atomic<bool> done(false);
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.push_back(std::thread([tid, &test, &done]() {
+      std::mt19937 gen(tid);
+      std::uniform_int_distribution<int> dis(0, num_keys - 1);
+      while (!done.load()) {
+        int key = dis(gen);
+        int value = -1;
+        bool found = test.Find(key, value);
+        if (key % 2 == 0) {
+          EXPECT_TRUE(found);
+        }
+        if (found) {
+          EXPECT_EQ(key, value);
+        }
+      }
+    }));
+  }
+  for (int round = 0; round < 20; ++round) {
+    for (int i = 1; i < num_keys; i += 2) {
+      test.Insert(i, i);
+    }
+    for (int i = 1; i < num_keys; i += 2) {
+      test.Remove(i);
+    }
+  }
+  done.store(true);
+  for (auto &thread : threads) {
+    thread.join();
+  }
+}
+
+TEST(LinearProbeHashTableTest, DISABLED_PageTableBenchmark) {
+  const int num_pages = 1024;
+  const int ops_per_thread = 1000000;
+
+  for (int type = 0; type < 2; ++type) {
+    HashTable<int, int> *table;
+    if (type == 0) {
+      table = new ExtendibleHash<int, int>(50);
+    } else {
+      table = new LinearProbeHashTable<int, int>(num_pages);
+    }
+    for (int i = 0; i < num_pages; ++i) {
+      table->Insert(i, i);
+    }
+
+    // mostly hits like a warm buffer pool, one in 16 operations replaces
+    // a page
+    for (int num_threads = 1; num_threads <= 16; num_threads *= 2) {
+      std::vector<std::thread> threads;
+      auto start = std::chrono::steady_clock::now();
+      for (int tid = 0; tid < num_threads; tid++) {
+        threads.push_back(std::thread([tid, table]() {
+          std::mt19937 gen(tid);
+          std::uniform_int_distribution<int> dis(0, num_pages - 1);
+          int value;
+          for (int i = 0; i < ops_per_thread; i++) {
+            int key = dis(gen);
+            if (i % 16 == 0) {
+              table->Remove(key);
+              table->Insert(key, key);
+            } else {
+              table->Find(key, value);
+            }
+          }
+        }));
+      }
+      for (auto &thread : threads) {
+        thread.join();
+      }
+      std::chrono::duration<double> elapsed =
+          std::chrono::steady_clock::now() - start;
+      std::cout << (type == 0 ? "extendible" : "linear probe")
+                << " threads: " << num_threads << " ops/sec: "
+                << static_cast<long>(num_threads * ops_per_thread /
+                                     elapsed.count())
+                << std::endl;
+    }
+    delete table;
+  }
+}
+
+} // namespace scudb
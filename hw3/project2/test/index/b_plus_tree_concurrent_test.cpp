@@ -3,13 +3,14 @@
  */
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <cstdio>
 #include <functional>
 #include <iostream>
 #include <thread>
 
-#include "buffer/buffer_pool_manager.h"
+#include "buffer/buffer_pool_manager_instance.h"
 #include "common/logger.h"
 #include "index/b_plus_tree.h"
 #include "vtable/virtual_table.h"
@@ -105,8 +106,8 @@ TEST(BPlusTreeConcurrentTest, InsertTest1) {
   Schema *key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema);
 
-  DiskManager *disk_manager = new DiskManager("test.db");
-  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  DiskManager *disk_manager = new DiskManager("test.db", TEST_PAGE_SIZE);
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
   // create b+ tree
   BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm,
                                                            comparator);
@@ -159,8 +160,8 @@ TEST(BPlusTreeConcurrentTest, InsertTest2) {
   // create KeyComparator and index schema
   Schema *key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema);
-  DiskManager *disk_manager = new DiskManager("test.db");
-  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  DiskManager *disk_manager = new DiskManager("test.db", TEST_PAGE_SIZE);
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
   // create b+ tree
   BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm,
                                                            comparator);
@@ -214,8 +215,8 @@ TEST(BPlusTreeConcurrentTest, DeleteTest1) {
   Schema *key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema);
 
-  DiskManager *disk_manager = new DiskManager("test.db");
-  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  DiskManager *disk_manager = new DiskManager("test.db", TEST_PAGE_SIZE);
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
   // create b+ tree
   BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm,
                                                            comparator);
@@ -260,8 +261,8 @@ TEST(BPlusTreeConcurrentTest, DeleteTest2) {
   Schema *key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema);
 
-  DiskManager *disk_manager = new DiskManager("test.db");
-  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  DiskManager *disk_manager = new DiskManager("test.db", TEST_PAGE_SIZE);
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
   // create b+ tree
   BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm,
                                                            comparator);
@@ -301,13 +302,77 @@ TEST(BPlusTreeConcurrentTest, DeleteTest2) {
   remove("test.log");
 }
 
+TEST(BPlusTreeConcurrentTest, OptimisticReadTest) {
+  remove("test.db");
+  remove("test.log");
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db", TEST_PAGE_SIZE);
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  // create b+ tree
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm,
+                                                           comparator);
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(page_id);
+  (void)header_page;
+
+  // odd keys are there from the start, even keys are inserted while
+  // searches run, splitting leaves and changing the root under them
+  std::vector<int64_t> odd_keys, even_keys;
+  for (int64_t key = 1; key < 400; key++) {
+    (key % 2 ? odd_keys : even_keys).push_back(key);
+  }
+  InsertHelper(tree, odd_keys);
+
+  std::atomic<bool> done(false);
+  std::vector<std::thread> readers;
+  for (int tid = 0; tid < 4; tid++) {
+    readers.push_back(std::thread([&tree, &odd_keys, &done]() {
+      GenericKey<8> index_key;
+      std::vector<RID> rids;
+      do {
+        for (auto key : odd_keys) {
+          rids.clear();
+          index_key.SetFromInteger(key);
+          EXPECT_EQ(true, tree.GetValue(index_key, rids));
+          ASSERT_EQ(1, rids.size());
+          EXPECT_EQ(key, rids[0].GetSlotNum());
+        }
+      } while (!done.load());
+    }));
+  }
+  InsertHelper(tree, even_keys);
+  done.store(true);
+  for (auto &reader : readers) {
+    reader.join();
+  }
+
+  std::vector<RID> rids;
+  GenericKey<8> index_key;
+  for (int64_t key = 1; key < 400; key++) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    EXPECT_EQ(true, tree.GetValue(index_key, rids));
+  }
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  EXPECT_EQ(0, bpm->CheckPinLeaks());
+
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
 TEST(BPlusTreeConcurrentTest, MixTest) {
   // create KeyComparator and index schema
   Schema *key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema);
 
-  DiskManager *disk_manager = new DiskManager("test.db");
-  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  DiskManager *disk_manager = new DiskManager("test.db", TEST_PAGE_SIZE);
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
   // create b+ tree
   BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm,
                                                            comparator);
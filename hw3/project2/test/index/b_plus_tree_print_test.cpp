@@ -6,7 +6,7 @@
 #include <iostream>
 #include <sstream>
 
-#include "buffer/buffer_pool_manager.h"
+#include "buffer/buffer_pool_manager_instance.h"
 #include "common/logger.h"
 #include "index/b_plus_tree.h"
 #include "vtable/virtual_table.h"
@@ -46,8 +46,8 @@ TEST(BptTreeTest, UnitTest) {
   Schema *key_schema = ParseCreateStatement(createStmt);
   GenericComparator<8> comparator(key_schema);
 
-  DiskManager *disk_manager = new DiskManager("test.db");
-  BufferPoolManager *bpm = new BufferPoolManager(100, disk_manager);
+  DiskManager *disk_manager = new DiskManager("test.db", TEST_PAGE_SIZE);
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(100, disk_manager);
   // create and fetch header_page
   page_id_t page_id;
   auto header_page = bpm->NewPage(page_id);
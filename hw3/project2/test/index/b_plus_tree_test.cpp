@@ -7,9 +7,10 @@
 #include <iostream>
 #include <sstream>
 
-#include "buffer/buffer_pool_manager.h"
+#include "buffer/buffer_pool_manager_instance.h"
 #include "common/logger.h"
 #include "index/b_plus_tree.h"
+#include "page/header_page.h"
 #include "vtable/virtual_table.h"
 #include "gtest/gtest.h"
 
@@ -20,8 +21,8 @@ TEST(BPlusTreeTests, InsertTest1) {
   Schema *key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema);
 
-  DiskManager *disk_manager = new DiskManager("test.db");
-  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  DiskManager *disk_manager = new DiskManager("test.db", TEST_PAGE_SIZE);
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
   // create b+ tree
   BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm,
                                                            comparator);
@@ -84,8 +85,8 @@ TEST(BPlusTreeTests, InsertTest2) {
   Schema *key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema);
 
-  DiskManager *disk_manager = new DiskManager("test.db");
-  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  DiskManager *disk_manager = new DiskManager("test.db", TEST_PAGE_SIZE);
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
   // create b+ tree
   BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm,
                                                            comparator);
@@ -156,8 +157,8 @@ TEST(BPlusTreeTests, DeleteTest1) {
   Schema *key_schema = ParseCreateStatement(createStmt);
   GenericComparator<8> comparator(key_schema);
 
-  DiskManager *disk_manager = new DiskManager("test.db");
-  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  DiskManager *disk_manager = new DiskManager("test.db", TEST_PAGE_SIZE);
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
   // create b+ tree
   BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm,
                                                            comparator);
@@ -237,8 +238,8 @@ TEST(BPlusTreeTests, DeleteTest2) {
   Schema *key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema);
 
-  DiskManager *disk_manager = new DiskManager("test.db");
-  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  DiskManager *disk_manager = new DiskManager("test.db", TEST_PAGE_SIZE);
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
   // create b+ tree
   BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm,
                                                            comparator);
@@ -313,13 +314,104 @@ TEST(BPlusTreeTests, DeleteTest2) {
   remove("test.log");
 }
 
+TEST(BPlusTreeTests, PageSizeTest) {
+  remove("test.db");
+  remove("test.log");
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  // pages hold far more entries at 4K, enough keys split internal pages too
+  DiskManager *disk_manager = new DiskManager("test.db", 4096);
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  EXPECT_EQ(4096, bpm->GetPageSize());
+  // create b+ tree
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm,
+                                                           comparator);
+  GenericKey<8> index_key;
+  RID rid;
+  // create transaction
+  Transaction *transaction = new Transaction(0);
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(page_id);
+  (void)header_page;
+
+  const int64_t scale = 60000;
+  for (int64_t key = 1; key <= scale; key++) {
+    rid.Set(0, key);
+    index_key.SetFromInteger(key);
+    tree.Insert(index_key, rid, transaction);
+  }
+
+  std::vector<RID> rids;
+  for (int64_t key = 1; key <= scale; key++) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    tree.GetValue(index_key, rids);
+    ASSERT_EQ(rids.size(), 1);
+    EXPECT_EQ(rids[0].GetSlotNum(), key);
+  }
+
+  int64_t current_key = 1;
+  index_key.SetFromInteger(current_key);
+  for (auto iterator = tree.Begin(index_key); iterator.isEnd() == false;
+       ++iterator) {
+    EXPECT_EQ((*iterator).second.GetSlotNum(), current_key);
+    current_key = current_key + 1;
+  }
+  EXPECT_EQ(current_key, scale + 1);
+
+  // the root has split, its first child is an internal page as well
+  page_id_t root_page_id;
+  ASSERT_TRUE(static_cast<HeaderPage *>(header_page)
+                  ->GetRootId("foo_pk", root_page_id));
+  auto root_page = reinterpret_cast<BPlusTreeInternalPage<
+      GenericKey<8>, page_id_t, GenericComparator<8>> *>(
+      bpm->FetchPage(root_page_id)->GetData());
+  ASSERT_FALSE(root_page->IsLeafPage());
+  auto child_page = reinterpret_cast<BPlusTreePage *>(
+      bpm->FetchPage(root_page->ValueAt(0))->GetData());
+  EXPECT_FALSE(child_page->IsLeafPage());
+  bpm->UnpinPage(child_page->GetPageId(), false);
+  bpm->UnpinPage(root_page_id, false);
+
+  // merging internal pages back shrinks the tree again
+  const int64_t remove_scale = scale - 100;
+  for (int64_t key = 1; key <= remove_scale; key++) {
+    index_key.SetFromInteger(key);
+    tree.Remove(index_key, transaction);
+  }
+  current_key = remove_scale + 1;
+  index_key.SetFromInteger(current_key);
+  for (auto iterator = tree.Begin(index_key); iterator.isEnd() == false;
+       ++iterator) {
+    EXPECT_EQ((*iterator).second.GetSlotNum(), current_key);
+    current_key = current_key + 1;
+  }
+  EXPECT_EQ(current_key, scale + 1);
+  for (int64_t key = 1; key <= scale; key++) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    EXPECT_EQ(tree.GetValue(index_key, rids), key > remove_scale);
+  }
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete transaction;
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
 TEST(BPlusTreeTests, ScaleTest) {
   // create KeyComparator and index schema
   Schema *key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema);
 
-  DiskManager *disk_manager = new DiskManager("test.db");
-  BufferPoolManager *bpm = new BufferPoolManager(30, disk_manager);
+  DiskManager *disk_manager = new DiskManager("test.db", TEST_PAGE_SIZE);
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(30, disk_manager);
   // create b+ tree
   BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm,
                                                            comparator);
@@ -1,14 +1,1014 @@
+#include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <cstdio>
-#include <cstdlib>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
 
+#include "common/stats.h"
+#include "logging/checkpoint_manager.h"
 #include "logging/common.h"
 #include "logging/log_recovery.h"
+#include "page/header_page.h"
 #include "vtable/virtual_table.h"
 #include "gtest/gtest.h"
 
 namespace scudb {
 
+// commits of many transactions at once
+double CommitThroughput(TransactionManager *transaction_manager,
+                        int num_threads, int commits_per_thread) {
+  std::vector<std::thread> threads;
+  auto start = std::chrono::steady_clock::now();
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.push_back(
+        std::thread([transaction_manager, commits_per_thread]() {
+          for (int i = 0; i < commits_per_thread; i++) {
+            Transaction *txn = transaction_manager->Begin();
+            transaction_manager->Commit(txn);
+            delete txn;
+          }
+        }));
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return num_threads * commits_per_thread / elapsed.count();
+}
+
+TEST(LogManagerTest, GroupCommitTest) {
+  remove("test.db");
+  remove("test.log");
+  const int num_threads = 16;
+  const int commits_per_thread = 20;
+  DiskManager *disk_manager = new DiskManager("test.db", TEST_PAGE_SIZE);
+  LogManager *log_manager = new LogManager(disk_manager);
+  LockManager lock_manager(false);
+  TransactionManager transaction_manager(&lock_manager, log_manager);
+  log_manager->RunFlushThread();
+  EXPECT_TRUE(ENABLE_LOGGING);
+
+  CommitThroughput(&transaction_manager, num_threads, commits_per_thread);
+  // every commit returned after its record was written, many in one write
+  const int num_records = 2 * num_threads * commits_per_thread;
+  EXPECT_EQ(num_records - 1, log_manager->GetPersistentLSN());
+  EXPECT_GT(num_threads * commits_per_thread,
+            disk_manager->GetNumFlushes());
+
+  log_manager->StopFlushThread();
+  EXPECT_FALSE(ENABLE_LOGGING);
+
+  // records are in the log in lsn order, a commit after its begin
+  std::vector<char> log(num_records * 20);
+  EXPECT_TRUE(disk_manager->ReadLog(log.data(), log.size(), 0));
+  std::vector<lsn_t> begin_lsn(num_threads * commits_per_thread,
+                               INVALID_LSN);
+  for (int i = 0; i < num_records; i++) {
+    int32_t *header = reinterpret_cast<int32_t *>(log.data() + i * 20);
+    EXPECT_EQ(20, header[0]);
+    EXPECT_EQ(i, header[1]);
+    txn_id_t txn_id = header[2];
+    auto type = static_cast<LogRecordType>(header[4]);
+    if (type == LogRecordType::BEGIN) {
+      EXPECT_EQ(INVALID_LSN, header[3]);
+      begin_lsn[txn_id] = i;
+    } else {
+      EXPECT_EQ(LogRecordType::COMMIT, type);
+      EXPECT_EQ(begin_lsn[txn_id], header[3]);
+    }
+  }
+
+  delete log_manager;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(LogManagerTest, DISABLED_GroupCommitBenchmark) {
+  remove("test.db");
+  const int commits_per_thread = 200;
+  for (int num_threads = 1; num_threads <= 64; num_threads *= 4) {
+    remove("test.log");
+    DiskManager *disk_manager = new DiskManager("test.db", TEST_PAGE_SIZE);
+    LogManager *log_manager = new LogManager(disk_manager);
+    LockManager lock_manager(false);
+    TransactionManager transaction_manager(&lock_manager, log_manager);
+    log_manager->RunFlushThread();
+    double throughput = CommitThroughput(&transaction_manager, num_threads,
+                                         commits_per_thread);
+    std::cout << "committers: " << num_threads
+              << " commits/sec: " << static_cast<long>(throughput)
+              << " commits per log write: "
+              << num_threads * commits_per_thread /
+                     std::max(1, disk_manager->GetNumFlushes())
+              << std::endl;
+    log_manager->StopFlushThread();
+    delete log_manager;
+    delete disk_manager;
+  }
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(LogManagerTest, AsyncCommitTest) {
+  remove("test.db");
+  remove("test.log");
+  auto lag = ASYNC_COMMIT_LAG;
+  ASYNC_COMMIT_LAG = std::chrono::milliseconds(50);
+  const int num_commits = 100;
+  DiskManager *disk_manager = new DiskManager("test.db", TEST_PAGE_SIZE);
+  LogManager *log_manager = new LogManager(disk_manager);
+  LockManager lock_manager(false);
+  TransactionManager transaction_manager(&lock_manager, log_manager, true);
+  log_manager->RunFlushThread();
+
+  // commits return before their record is written, they share few writes
+  lsn_t last_lsn = INVALID_LSN;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < num_commits; i++) {
+    Transaction *txn = transaction_manager.Begin();
+    EXPECT_TRUE(txn->IsAsyncCommit());
+    transaction_manager.Commit(txn);
+    last_lsn = txn->GetPrevLSN();
+    delete txn;
+  }
+  // the flush thread writes them within the lag, long before LOG_TIMEOUT
+  while (log_manager->GetPersistentLSN() < last_lsn) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_GT(LOG_TIMEOUT, std::chrono::steady_clock::now() - start);
+
+  // a transaction can still ask for a durable commit
+  Transaction *txn = transaction_manager.Begin();
+  txn->SetAsyncCommit(false);
+  transaction_manager.Commit(txn);
+  EXPECT_LE(txn->GetPrevLSN(), log_manager->GetPersistentLSN());
+  delete txn;
+
+  log_manager->StopFlushThread();
+  EXPECT_GT(num_commits, disk_manager->GetNumFlushes());
+  ASYNC_COMMIT_LAG = lag;
+  delete log_manager;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(LogManagerTest, DISABLED_AsyncCommitBenchmark) {
+  remove("test.db");
+  const int num_commits = 2000;
+  for (int async_commit = 0; async_commit < 2; async_commit++) {
+    remove("test.log");
+    DiskManager *disk_manager = new DiskManager("test.db", TEST_PAGE_SIZE);
+    LogManager *log_manager = new LogManager(disk_manager);
+    LockManager lock_manager(false);
+    TransactionManager transaction_manager(&lock_manager, log_manager,
+                                           async_commit);
+    log_manager->RunFlushThread();
+    LatencyRecorder latency;
+    for (int i = 0; i < num_commits; i++) {
+      Transaction *txn = transaction_manager.Begin();
+      auto start = std::chrono::steady_clock::now();
+      transaction_manager.Commit(txn);
+      latency.Record(std::chrono::steady_clock::now() - start);
+      delete txn;
+    }
+    std::cout << (async_commit ? "async" : "sync") << " commit latency: "
+              << latency.GetHistogram().ToString()
+              << " log writes: " << disk_manager->GetNumFlushes()
+              << std::endl;
+    log_manager->StopFlushThread();
+    delete log_manager;
+    delete disk_manager;
+  }
+  remove("test.db");
+  remove("test.log");
+}
+
+// insert record of txn_id whose tuple is length bytes of value txn_id
+LogRecord MakeInsertRecord(txn_id_t txn_id, int slot_num, int32_t length) {
+  std::vector<char> storage(sizeof(int32_t) + length, static_cast<char>(txn_id));
+  memcpy(storage.data(), &length, sizeof(int32_t));
+  Tuple tuple;
+  tuple.DeserializeFrom(storage.data());
+  return LogRecord(txn_id, INVALID_LSN, LogRecordType::INSERT,
+                   RID(txn_id, slot_num), tuple);
+}
+
+TEST(LogManagerTest, ConcurrentAppendTest) {
+  remove("test.db");
+  remove("test.log");
+  const int num_threads = 8;
+  const int records_per_thread = 500;
+  DiskManager *disk_manager = new DiskManager("test.db", TEST_PAGE_SIZE);
+  LogManager *log_manager = new LogManager(disk_manager);
+
+  // records of varied sizes fill the buffer many times over, appenders
+  // finding it full write it themselves
+  std::atomic<size_t> log_size(0);
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.push_back(std::thread([tid, log_manager, &log_size]() {
+      for (int i = 0; i < records_per_thread; i++) {
+        LogRecord record = MakeInsertRecord(tid, i, (tid * 7 + i) % 200 + 1);
+        log_manager->AppendLogRecord(record);
+        log_size += record.GetSize();
+      }
+    }));
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  const int num_records = num_threads * records_per_thread;
+  log_manager->WaitForFlush(num_records - 1);
+  EXPECT_EQ(num_records - 1, log_manager->GetPersistentLSN());
+
+  // lsn are dense and in log order, every record is intact and the records
+  // of a thread are in the order it appended them
+  const size_t header_size = 20;
+  std::vector<char> log(log_size);
+  EXPECT_TRUE(disk_manager->ReadLog(log.data(), log.size(), 0));
+  std::vector<int> next_slot(num_threads, 0);
+  size_t pos = 0;
+  for (int i = 0; i < num_records; i++) {
+    int32_t *header = reinterpret_cast<int32_t *>(log.data() + pos);
+    EXPECT_EQ(i, header[1]);
+    txn_id_t txn_id = header[2];
+    ASSERT_TRUE(txn_id >= 0 && txn_id < num_threads);
+    EXPECT_EQ(LogRecordType::INSERT, static_cast<LogRecordType>(header[4]));
+    RID rid;
+    memcpy(&rid, log.data() + pos + header_size, sizeof(RID));
+    EXPECT_EQ(txn_id, rid.GetPageId());
+    EXPECT_EQ(next_slot[txn_id], rid.GetSlotNum());
+    int32_t length = (txn_id * 7 + next_slot[txn_id]) % 200 + 1;
+    next_slot[txn_id]++;
+    const char *data =
+        log.data() + pos + header_size + sizeof(RID);
+    EXPECT_EQ(length, *reinterpret_cast<const int32_t *>(data));
+    EXPECT_EQ(header_size + sizeof(RID) + sizeof(int32_t) + length,
+              static_cast<size_t>(header[0]));
+    for (int j = 0; j < length; j++) {
+      EXPECT_EQ(static_cast<char>(txn_id), data[sizeof(int32_t) + j]);
+    }
+    pos += header[0];
+  }
+  EXPECT_EQ(log_size, pos);
+
+  delete log_manager;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+// tuple of length bytes, all of them value
+Tuple MakeTuple(char value, int32_t length) {
+  std::vector<char> storage(sizeof(int32_t) + length, value);
+  memcpy(storage.data(), &length, sizeof(int32_t));
+  Tuple tuple;
+  tuple.DeserializeFrom(storage.data());
+  return tuple;
+}
+
+// changes table pages and logs them the way TablePage does with logging on,
+// without going through the lock manager
+class LoggedTableWriter {
+public:
+  LoggedTableWriter(BufferPoolManager *buffer_pool_manager,
+                    LogManager *log_manager)
+      : buffer_pool_manager_(buffer_pool_manager), log_manager_(log_manager) {}
+
+  void Begin(Transaction *txn) {
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(),
+                         LogRecordType::BEGIN);
+    Append(txn, log_record);
+  }
+
+  void End(Transaction *txn, LogRecordType type) {
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), type);
+    Append(txn, log_record);
+  }
+
+  page_id_t NewPage(Transaction *txn, page_id_t prev_page_id) {
+    page_id_t page_id;
+    WritePageGuard guard = buffer_pool_manager_->NewPageGuarded(page_id);
+    auto page = static_cast<TablePage *>(guard.GetPage());
+    page->Init(page_id, buffer_pool_manager_->GetPageSize(), prev_page_id,
+               nullptr, nullptr);
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(),
+                         LogRecordType::NEWPAGE, prev_page_id, page_id);
+    page->SetLSN(Append(txn, log_record));
+    guard.MarkDirty();
+    if (prev_page_id != INVALID_PAGE_ID) {
+      WritePageGuard prev_guard =
+          buffer_pool_manager_->FetchPageWrite(prev_page_id);
+      auto prev_page = static_cast<TablePage *>(prev_guard.GetPage());
+      prev_page->SetNextPageId(page_id);
+      prev_page->SetLSN(txn->GetPrevLSN());
+      prev_guard.MarkDirty();
+    }
+    return page_id;
+  }
+
+  RID Insert(Transaction *txn, page_id_t page_id, const Tuple &tuple) {
+    WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(page_id);
+    auto page = static_cast<TablePage *>(guard.GetPage());
+    RID rid;
+    EXPECT_TRUE(page->InsertTuple(tuple, rid, nullptr, nullptr, nullptr));
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(),
+                         LogRecordType::INSERT, rid, tuple);
+    page->SetLSN(Append(txn, log_record));
+    guard.MarkDirty();
+    return rid;
+  }
+
+  void Update(Transaction *txn, const RID &rid, const Tuple &tuple) {
+    WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(rid.GetPageId());
+    auto page = static_cast<TablePage *>(guard.GetPage());
+    Tuple old_tuple;
+    EXPECT_TRUE(
+        page->UpdateTuple(tuple, old_tuple, rid, nullptr, nullptr, nullptr));
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(),
+                         LogRecordType::UPDATE, rid, old_tuple, tuple);
+    page->SetLSN(Append(txn, log_record));
+    guard.MarkDirty();
+  }
+
+  // MARKDELETE, APPLYDELETE or ROLLBACKDELETE, tuple is what APPLYDELETE
+  // removes
+  void Delete(Transaction *txn, const RID &rid, LogRecordType type,
+              const Tuple &tuple = Tuple()) {
+    WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(rid.GetPageId());
+    auto page = static_cast<TablePage *>(guard.GetPage());
+    if (type == LogRecordType::MARKDELETE) {
+      EXPECT_TRUE(page->MarkDelete(rid, nullptr, nullptr, nullptr));
+    } else if (type == LogRecordType::APPLYDELETE) {
+      page->ApplyDelete(rid, nullptr, nullptr);
+    } else {
+      page->RollbackDelete(rid, nullptr, nullptr);
+    }
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), type,
+                         rid, tuple);
+    page->SetLSN(Append(txn, log_record));
+    guard.MarkDirty();
+  }
+
+  size_t GetLogSize() const { return log_size_; }
+
+private:
+  lsn_t Append(Transaction *txn, LogRecord &log_record) {
+    log_size_ += log_record.GetSize();
+    txn->SetPrevLSN(log_manager_->AppendLogRecord(log_record));
+    return txn->GetPrevLSN();
+  }
+
+  BufferPoolManager *buffer_pool_manager_;
+  LogManager *log_manager_;
+  size_t log_size_ = 0;
+};
+
+// tuple at rid is length bytes of value
+void CheckTuple(BufferPoolManager *buffer_pool_manager, const RID &rid,
+                char value, int32_t length) {
+  ReadPageGuard guard = buffer_pool_manager->FetchPageRead(rid.GetPageId());
+  auto page = static_cast<TablePage *>(guard.GetPage());
+  Tuple tuple;
+  ASSERT_TRUE(page->GetTuple(rid, tuple, nullptr, nullptr));
+  ASSERT_EQ(length, tuple.GetLength());
+  for (int i = 0; i < length; i++) {
+    EXPECT_EQ(value, tuple.GetData()[i]);
+  }
+}
+
+// page 0, recovery looks for a checkpoint there
+void NewHeaderPage(BufferPoolManager *buffer_pool_manager) {
+  page_id_t page_id;
+  WritePageGuard guard = buffer_pool_manager->NewPageGuarded(page_id);
+  ASSERT_EQ(HEADER_PAGE_ID, page_id);
+  static_cast<HeaderPage *>(guard.GetPage())->Init();
+  guard.MarkDirty();
+}
+
+TEST(LogManagerTest, RecoveryTest) {
+  remove("test.db");
+  remove("test.log");
+  const int num_pages = 8;
+  const int num_tuples = 200;
+  DiskManager *disk_manager = new DiskManager("test.db", 4096);
+  LogManager *log_manager = new LogManager(disk_manager);
+  // a small pool writes some of the pages back before the crash
+  BufferPoolManager *buffer_pool_manager =
+      new BufferPoolManagerInstance(3, disk_manager);
+  LoggedTableWriter writer(buffer_pool_manager, log_manager);
+  NewHeaderPage(buffer_pool_manager);
+
+  // txn 0 creates and fills the table
+  Transaction txn0(0);
+  writer.Begin(&txn0);
+  std::vector<page_id_t> page_ids;
+  page_id_t page_id = INVALID_PAGE_ID;
+  for (int i = 0; i < num_pages; i++) {
+    page_id = writer.NewPage(&txn0, page_id);
+    page_ids.push_back(page_id);
+  }
+  std::vector<RID> rids;
+  std::vector<std::pair<char, int32_t>> expected;
+  for (int i = 0; i < num_tuples; i++) {
+    char value = 'a' + i % 26;
+    int32_t length = 20 + i % 50;
+    rids.push_back(writer.Insert(&txn0, page_ids[i % num_pages],
+                                 MakeTuple(value, length)));
+    expected.push_back(std::make_pair(value, length));
+  }
+  writer.End(&txn0, LogRecordType::COMMIT);
+
+  // txn 1 commits, txn 2 is still running at the crash and txn 3 aborted,
+  // their changes interleave
+  Transaction txn1(1), txn2(2), txn3(3);
+  writer.Begin(&txn1);
+  writer.Begin(&txn2);
+  writer.Begin(&txn3);
+  for (int i = 0; i < 100; i++) {
+    switch (i % 4) {
+    case 0:
+      writer.Update(&txn1, rids[i], MakeTuple('A' + i % 26, 10 + i % 70));
+      expected[i] = std::make_pair('A' + i % 26, 10 + i % 70);
+      break;
+    case 1:
+      writer.Update(&txn2, rids[i], MakeTuple('0' + i % 10, 60));
+      break;
+    case 2:
+      writer.Delete(&txn1, rids[i], LogRecordType::MARKDELETE);
+      writer.Delete(&txn1, rids[i], LogRecordType::APPLYDELETE,
+                    MakeTuple(expected[i].first, expected[i].second));
+      expected[i].second = 0;
+      break;
+    default:
+      writer.Delete(&txn2, rids[i], LogRecordType::MARKDELETE);
+      break;
+    }
+    writer.Delete(&txn3, rids[100 + i], LogRecordType::MARKDELETE);
+  }
+  // may take the slots txn 1 freed
+  std::vector<RID> lost_rids;
+  for (int i = 0; i < 20; i++) {
+    lost_rids.push_back(writer.Insert(&txn2, page_ids[i % num_pages],
+                                      MakeTuple('z', 30)));
+  }
+  writer.End(&txn1, LogRecordType::COMMIT);
+  for (int i = 0; i < 100; i++) {
+    writer.Delete(&txn3, rids[100 + i], LogRecordType::ROLLBACKDELETE);
+  }
+  writer.End(&txn3, LogRecordType::ABORT);
+  log_manager->WaitForFlush(txn3.GetPrevLSN());
+
+  // crash
+  delete buffer_pool_manager;
+  buffer_pool_manager = new BufferPoolManagerInstance(num_pages, disk_manager);
+  LogRecovery *log_recovery =
+      new LogRecovery(disk_manager, buffer_pool_manager, nullptr, 3);
+  log_recovery->Redo();
+  delete log_recovery;
+  // redo again finds every page up to date
+  log_recovery =
+      new LogRecovery(disk_manager, buffer_pool_manager, log_manager);
+  log_recovery->Redo();
+  log_recovery->Undo();
+  delete log_recovery;
+
+  for (int i = 0; i < num_tuples; i++) {
+    if (expected[i].second > 0) {
+      CheckTuple(buffer_pool_manager, rids[i], expected[i].first,
+                 expected[i].second);
+    }
+  }
+  for (int i = 0; i < num_tuples; i++) {
+    if (expected[i].second == 0) {
+      lost_rids.push_back(rids[i]);
+    }
+  }
+  for (auto &rid : lost_rids) {
+    ReadPageGuard guard = buffer_pool_manager->FetchPageRead(rid.GetPageId());
+    Tuple tuple;
+    EXPECT_FALSE(static_cast<TablePage *>(guard.GetPage())
+                     ->GetTuple(rid, tuple, nullptr, nullptr));
+  }
+  // the table is still linked
+  for (int i = 0; i + 1 < num_pages; i++) {
+    ReadPageGuard guard = buffer_pool_manager->FetchPageRead(page_ids[i]);
+    EXPECT_EQ(page_ids[i + 1],
+              static_cast<TablePage *>(guard.GetPage())->GetNextPageId());
+  }
+
+  delete buffer_pool_manager;
+  delete log_manager;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(LogManagerTest, CheckpointTest) {
+  remove("test.db");
+  remove("test.log");
+  const int num_pages = 8;
+  const int num_tuples = 200;
+  DiskManager *disk_manager = new DiskManager("test.db", 4096);
+  LogManager *log_manager = new LogManager(disk_manager);
+  BufferPoolManager *buffer_pool_manager =
+      new BufferPoolManagerInstance(4, disk_manager);
+  LoggedTableWriter writer(buffer_pool_manager, log_manager);
+  NewHeaderPage(buffer_pool_manager);
+  LockManager lock_manager(true);
+  TransactionManager transaction_manager(&lock_manager, log_manager);
+  CheckpointManager checkpoint_manager(&transaction_manager, log_manager,
+                                       buffer_pool_manager, disk_manager);
+  // with logging on TablePage logs by itself and takes locks, so it is only
+  // on for the transaction and checkpoint managers
+  auto begin = [&transaction_manager]() {
+    ENABLE_LOGGING = true;
+    Transaction *txn = transaction_manager.Begin();
+    ENABLE_LOGGING = false;
+    return txn;
+  };
+  auto commit = [&transaction_manager](Transaction *txn) {
+    ENABLE_LOGGING = true;
+    transaction_manager.Commit(txn);
+    ENABLE_LOGGING = false;
+  };
+  auto checkpoint = [&checkpoint_manager]() {
+    ENABLE_LOGGING = true;
+    lsn_t lsn = checkpoint_manager.Checkpoint();
+    ENABLE_LOGGING = false;
+    return lsn;
+  };
+
+  // txn 0 creates and fills the table, it is written back before the
+  // checkpoints
+  Transaction *txn0 = begin();
+  std::vector<page_id_t> page_ids;
+  page_id_t page_id = INVALID_PAGE_ID;
+  for (int i = 0; i < num_pages; i++) {
+    page_id = writer.NewPage(txn0, page_id);
+    page_ids.push_back(page_id);
+  }
+  std::vector<RID> rids;
+  std::vector<std::pair<char, int32_t>> expected;
+  for (int i = 0; i < num_tuples; i++) {
+    rids.push_back(
+        writer.Insert(txn0, page_ids[i % num_pages], MakeTuple('a', 40)));
+    expected.push_back(std::make_pair('a', 40));
+  }
+  commit(txn0);
+  delete txn0;
+  buffer_pool_manager->FlushAllPages();
+
+  // txn 2 is active at every checkpoint and at the crash, txn 1 commits
+  Transaction *txn1 = begin();
+  Transaction *txn2 = begin();
+  lsn_t checkpoint_lsn = INVALID_LSN;
+  for (int round = 0; round < 4; round++) {
+    for (int i = 0; i < 50; i++) {
+      int index = round * 50 + i;
+      if (i % 2 == 0) {
+        char value = 'A' + round;
+        writer.Update(txn1, rids[index], MakeTuple(value, 30 + round));
+        expected[index] = std::make_pair(value, 30 + round);
+      } else {
+        writer.Update(txn2, rids[index], MakeTuple('z', 50));
+      }
+    }
+    lsn_t lsn = checkpoint();
+    EXPECT_LT(checkpoint_lsn, lsn);
+    checkpoint_lsn = lsn;
+  }
+  // after the last checkpoint, on tuples txn 2 left alone
+  for (int i = 0; i < num_tuples; i += 6) {
+    writer.Update(txn1, rids[i], MakeTuple('#', 20));
+    expected[i] = std::make_pair('#', 20);
+  }
+  commit(txn1);
+  lsn_t last_lsn = txn1->GetPrevLSN();
+  delete txn1;
+
+  // the log of txn 0 is given back, only txn 2 needs the log before the
+  // checkpoint
+  off_t log_start;
+  {
+    ReadPageGuard guard = buffer_pool_manager->FetchPageRead(HEADER_PAGE_ID);
+    auto header_page = static_cast<HeaderPage *>(guard.GetPage());
+    EXPECT_EQ(checkpoint_lsn, header_page->GetCheckpointLSN());
+    log_start = header_page->GetLogStart();
+    EXPECT_LT(log_start, header_page->GetCheckpointOffset());
+  }
+  EXPECT_GT(log_start, 0);
+  int32_t size = -1;
+  EXPECT_TRUE(disk_manager->ReadLog(reinterpret_cast<char *>(&size),
+                                    sizeof(int32_t), 0));
+  EXPECT_EQ(0, size);
+
+  // crash
+  delete txn2;
+  delete buffer_pool_manager;
+  buffer_pool_manager = new BufferPoolManagerInstance(num_pages, disk_manager);
+  LogRecovery log_recovery(disk_manager, buffer_pool_manager, log_manager);
+  log_recovery.Redo();
+  EXPECT_EQ(last_lsn + 1, log_recovery.GetNextLSN());
+  log_recovery.Undo();
+  for (int i = 0; i < num_tuples; i++) {
+    CheckTuple(buffer_pool_manager, rids[i], expected[i].first,
+               expected[i].second);
+  }
+
+  delete buffer_pool_manager;
+  delete log_manager;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(LogManagerTest, RecoveryWithoutCheckpointTest) {
+  remove("test.db");
+  remove("test.log");
+  const int num_pages = 2;
+  const int num_tuples = 20;
+  DiskManager *disk_manager = new DiskManager("test.db", 4096);
+  LogManager *log_manager = new LogManager(disk_manager);
+  BufferPoolManager *buffer_pool_manager =
+      new BufferPoolManagerInstance(3, disk_manager);
+  LoggedTableWriter writer(buffer_pool_manager, log_manager);
+  // a fresh db, its header page says there is no checkpoint
+  NewHeaderPage(buffer_pool_manager);
+  {
+    ReadPageGuard guard = buffer_pool_manager->FetchPageRead(HEADER_PAGE_ID);
+    auto header_page = static_cast<HeaderPage *>(guard.GetPage());
+    EXPECT_EQ(0, header_page->GetLogStart());
+    EXPECT_EQ(INVALID_LSN, header_page->GetCheckpointLSN());
+  }
+  buffer_pool_manager->FlushPage(HEADER_PAGE_ID);
+
+  // txn 0 commits, txn 1 is running at the crash
+  Transaction txn0(0), txn1(1);
+  writer.Begin(&txn0);
+  std::vector<page_id_t> page_ids;
+  page_id_t page_id = INVALID_PAGE_ID;
+  for (int i = 0; i < num_pages; i++) {
+    page_id = writer.NewPage(&txn0, page_id);
+    page_ids.push_back(page_id);
+  }
+  std::vector<RID> rids;
+  for (int i = 0; i < num_tuples; i++) {
+    rids.push_back(writer.Insert(&txn0, page_ids[i % num_pages],
+                                 MakeTuple('a' + i, 20 + i)));
+  }
+  writer.End(&txn0, LogRecordType::COMMIT);
+  writer.Begin(&txn1);
+  for (int i = 0; i < num_tuples; i += 2) {
+    writer.Update(&txn1, rids[i], MakeTuple('X', 30));
+  }
+  log_manager->WaitForFlush(txn1.GetPrevLSN());
+  lsn_t last_lsn = txn1.GetPrevLSN();
+
+  // crash, redo reads the whole log
+  delete buffer_pool_manager;
+  buffer_pool_manager =
+      new BufferPoolManagerInstance(num_pages + 1, disk_manager);
+  LogRecovery log_recovery(disk_manager, buffer_pool_manager, log_manager);
+  log_recovery.Redo();
+  EXPECT_EQ(last_lsn + 1, log_recovery.GetNextLSN());
+  log_recovery.Undo();
+  for (int i = 0; i < num_tuples; i++) {
+    CheckTuple(buffer_pool_manager, rids[i], 'a' + i, 20 + i);
+  }
+
+  delete buffer_pool_manager;
+  delete log_manager;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+// whole content of a file
+std::string ReadFile(const char *name) {
+  std::ifstream file(name, std::ios::binary);
+  std::stringstream content;
+  content << file.rdbuf();
+  return content.str();
+}
+
+void WriteFile(const char *name, const std::string &content) {
+  std::ofstream file(name, std::ios::binary | std::ios::trunc);
+  file << content;
+}
+
+TEST(LogManagerTest, RecoverTwiceTest) {
+  const int num_pages = 4;
+  const int num_tuples = 40;
+  // recovery crashes during undo: either before it wrote any page, with half
+  // of the CLRs in the log, or after it wrote all of them, just before the
+  // ABORT record
+  for (int crash = 0; crash < 2; crash++) {
+    remove("test.db");
+    remove("test.log");
+    DiskManager *disk_manager = new DiskManager("test.db", 4096);
+    LogManager *log_manager = new LogManager(disk_manager);
+    BufferPoolManager *buffer_pool_manager =
+        new BufferPoolManagerInstance(3, disk_manager);
+    LoggedTableWriter writer(buffer_pool_manager, log_manager);
+    NewHeaderPage(buffer_pool_manager);
+
+    // txn 0 fills the table, txn 1 is still running at the crash
+    Transaction txn0(0), txn1(1);
+    writer.Begin(&txn0);
+    std::vector<page_id_t> page_ids;
+    page_id_t page_id = INVALID_PAGE_ID;
+    for (int i = 0; i < num_pages; i++) {
+      page_id = writer.NewPage(&txn0, page_id);
+      page_ids.push_back(page_id);
+    }
+    std::vector<RID> rids;
+    for (int i = 0; i < num_tuples; i++) {
+      rids.push_back(writer.Insert(&txn0, page_ids[i % num_pages],
+                                   MakeTuple('a' + i % 26, 20 + i)));
+    }
+    writer.End(&txn0, LogRecordType::COMMIT);
+    writer.Begin(&txn1);
+    for (int i = 0; i < num_tuples; i++) {
+      switch (i % 4) {
+      case 0:
+        writer.Update(&txn1, rids[i], MakeTuple('X', 30));
+        break;
+      case 1:
+        writer.Delete(&txn1, rids[i], LogRecordType::MARKDELETE);
+        break;
+      case 2:
+        writer.Delete(&txn1, rids[i], LogRecordType::MARKDELETE);
+        writer.Delete(&txn1, rids[i], LogRecordType::ROLLBACKDELETE);
+        break;
+      default:
+        // committing, the tuple has to come back at its rid
+        writer.Delete(&txn1, rids[i], LogRecordType::MARKDELETE);
+        writer.Delete(&txn1, rids[i], LogRecordType::APPLYDELETE,
+                      MakeTuple('a' + i % 26, 20 + i));
+        break;
+      }
+    }
+    std::vector<RID> lost_rids;
+    for (int i = 0; i < 10; i++) {
+      lost_rids.push_back(writer.Insert(&txn1, page_ids[i % num_pages],
+                                        MakeTuple('z', 30)));
+    }
+    log_manager->WaitForFlush(txn1.GetPrevLSN());
+
+    // crash, then recovery is run up to the end
+    delete buffer_pool_manager;
+    off_t log_size = disk_manager->GetLogFileSize();
+    std::string db = ReadFile("test.db");
+    // the pool of recovery waits for the CLR of a page before writing it
+    buffer_pool_manager =
+        new BufferPoolManagerInstance(3, disk_manager, log_manager);
+    LogRecovery *log_recovery =
+        new LogRecovery(disk_manager, buffer_pool_manager, log_manager);
+    log_recovery->Redo();
+    log_recovery->Undo();
+    delete log_recovery;
+
+    // the records undo appended, the last one is the ABORT of txn 1
+    std::vector<off_t> offsets;
+    for (off_t offset = log_size; offset < disk_manager->GetLogFileSize();) {
+      int32_t size;
+      ASSERT_TRUE(disk_manager->ReadLog(reinterpret_cast<char *>(&size),
+                                        sizeof(int32_t), offset));
+      offsets.push_back(offset);
+      offset += size;
+    }
+    ASSERT_LT(2u, offsets.size());
+    off_t cut = crash == 0 ? offsets[offsets.size() / 2] : offsets.back();
+    delete buffer_pool_manager;
+    delete log_manager;
+    delete disk_manager;
+    if (crash == 0) {
+      WriteFile("test.db", db);
+    }
+    ASSERT_EQ(0, truncate("test.log", cut));
+
+    // recovery again
+    disk_manager = new DiskManager("test.db", 4096);
+    log_manager = new LogManager(disk_manager);
+    buffer_pool_manager =
+        new BufferPoolManagerInstance(3, disk_manager, log_manager);
+    log_recovery =
+        new LogRecovery(disk_manager, buffer_pool_manager, log_manager);
+    log_recovery->Redo();
+    log_recovery->Undo();
+    delete log_recovery;
+    if (crash == 1) {
+      // every record was compensated, only the ABORT record is added
+      int32_t size;
+      ASSERT_TRUE(disk_manager->ReadLog(reinterpret_cast<char *>(&size),
+                                        sizeof(int32_t), cut));
+      EXPECT_EQ(cut + size, disk_manager->GetLogFileSize());
+    }
+
+    for (int i = 0; i < num_tuples; i++) {
+      CheckTuple(buffer_pool_manager, rids[i], 'a' + i % 26, 20 + i);
+    }
+    for (auto &rid : lost_rids) {
+      if (std::find(rids.begin(), rids.end(), rid) != rids.end()) {
+        // the slot of an applied delete, its tuple is back
+        continue;
+      }
+      ReadPageGuard guard =
+          buffer_pool_manager->FetchPageRead(rid.GetPageId());
+      Tuple tuple;
+      EXPECT_FALSE(static_cast<TablePage *>(guard.GetPage())
+                       ->GetTuple(rid, tuple, nullptr, nullptr));
+    }
+
+    delete buffer_pool_manager;
+    delete log_manager;
+    delete disk_manager;
+    remove("test.db");
+    remove("test.log");
+  }
+}
+
+TEST(LogManagerTest, CheckpointCrashTest) {
+  const int num_pages = 4;
+  const int num_tuples = 40;
+  // crash once the header page points at the checkpoint: before the log is
+  // truncated, and halfway through truncating it
+  for (int crash = 0; crash < 2; crash++) {
+    remove("test.db");
+    remove("test.log");
+    DiskManager *disk_manager = new DiskManager("test.db", 4096);
+    LogManager *log_manager = new LogManager(disk_manager);
+    BufferPoolManager *buffer_pool_manager =
+        new BufferPoolManagerInstance(3, disk_manager);
+    LoggedTableWriter writer(buffer_pool_manager, log_manager);
+    NewHeaderPage(buffer_pool_manager);
+    LockManager lock_manager(true);
+    TransactionManager transaction_manager(&lock_manager, log_manager);
+    CheckpointManager checkpoint_manager(&transaction_manager, log_manager,
+                                         buffer_pool_manager, disk_manager);
+
+    // txn 0 fills the table and is written back, txn 1 commits after the
+    // checkpoint and txn 2 is running at the crash
+    ENABLE_LOGGING = true;
+    Transaction *txn0 = transaction_manager.Begin();
+    ENABLE_LOGGING = false;
+    std::vector<page_id_t> page_ids;
+    page_id_t page_id = INVALID_PAGE_ID;
+    for (int i = 0; i < num_pages; i++) {
+      page_id = writer.NewPage(txn0, page_id);
+      page_ids.push_back(page_id);
+    }
+    std::vector<RID> rids;
+    std::vector<std::pair<char, int32_t>> expected;
+    for (int i = 0; i < num_tuples; i++) {
+      rids.push_back(
+          writer.Insert(txn0, page_ids[i % num_pages], MakeTuple('a', 40)));
+      expected.push_back(std::make_pair('a', 40));
+    }
+    ENABLE_LOGGING = true;
+    transaction_manager.Commit(txn0);
+    Transaction *txn1 = transaction_manager.Begin();
+    Transaction *txn2 = transaction_manager.Begin();
+    ENABLE_LOGGING = false;
+    delete txn0;
+    buffer_pool_manager->FlushAllPages();
+    for (int i = 0; i < num_tuples; i++) {
+      if (i % 2 == 0) {
+        writer.Update(txn1, rids[i], MakeTuple('B', 30));
+        expected[i] = std::make_pair('B', 30);
+      } else {
+        writer.Update(txn2, rids[i], MakeTuple('z', 50));
+      }
+    }
+    log_manager->WaitForFlush(txn2->GetPrevLSN());
+    std::string log = ReadFile("test.log");
+
+    ENABLE_LOGGING = true;
+    EXPECT_NE(INVALID_LSN, checkpoint_manager.Checkpoint());
+    transaction_manager.Commit(txn1);
+    ENABLE_LOGGING = false;
+    lsn_t last_lsn = txn1->GetPrevLSN();
+    off_t log_start;
+    {
+      ReadPageGuard guard =
+          buffer_pool_manager->FetchPageRead(HEADER_PAGE_ID);
+      log_start = static_cast<HeaderPage *>(guard.GetPage())->GetLogStart();
+    }
+    ASSERT_GT(log_start, 0);
+
+    // crash, the log before the log start is back as it was, or half of it
+    // is
+    delete txn1;
+    delete txn2;
+    delete buffer_pool_manager;
+    delete log_manager;
+    delete disk_manager;
+    std::string truncated = ReadFile("test.log");
+    ASSERT_LE(log.size(), truncated.size());
+    log += truncated.substr(log.size());
+    if (crash == 1) {
+      std::fill(log.begin(), log.begin() + log_start / 2, '\0');
+    }
+    WriteFile("test.log", log);
+
+    // recovery starts at the log start
+    disk_manager = new DiskManager("test.db", 4096);
+    log_manager = new LogManager(disk_manager);
+    buffer_pool_manager =
+        new BufferPoolManagerInstance(num_pages + 1, disk_manager);
+    LogRecovery log_recovery(disk_manager, buffer_pool_manager, log_manager);
+    log_recovery.Redo();
+    EXPECT_EQ(last_lsn + 1, log_recovery.GetNextLSN());
+    log_recovery.Undo();
+    for (int i = 0; i < num_tuples; i++) {
+      CheckTuple(buffer_pool_manager, rids[i], expected[i].first,
+                 expected[i].second);
+    }
+
+    delete buffer_pool_manager;
+    delete log_manager;
+    delete disk_manager;
+    remove("test.db");
+    remove("test.log");
+  }
+}
+
+TEST(LogManagerTest, DISABLED_RedoBenchmark) {
+  remove("test.db");
+  remove("test.log");
+  const size_t log_size = size_t(2) << 30;
+  const int num_pages = 1024;
+  const int tuples_per_page = 16;
+  DiskManager *disk_manager = new DiskManager("test.db", 4096);
+  disk_manager->SetSyncPolicy(SyncPolicy::PERIODIC);
+  LogManager *log_manager = new LogManager(disk_manager);
+  BufferPoolManager *buffer_pool_manager =
+      new BufferPoolManagerInstance(num_pages, disk_manager);
+
+  // a table of 1024 pages, then updates all over it until the log is large
+  LoggedTableWriter writer(buffer_pool_manager, log_manager);
+  Transaction txn(0);
+  writer.Begin(&txn);
+  std::vector<RID> rids;
+  page_id_t page_id = INVALID_PAGE_ID;
+  for (int i = 0; i < num_pages; i++) {
+    page_id = writer.NewPage(&txn, page_id);
+    for (int j = 0; j < tuples_per_page; j++) {
+      rids.push_back(writer.Insert(&txn, page_id, MakeTuple('a', 100)));
+    }
+  }
+  writer.End(&txn, LogRecordType::COMMIT);
+  std::mt19937 gen(0);
+  std::uniform_int_distribution<size_t> dis(0, rids.size() - 1);
+  txn_id_t txn_id = 1;
+  lsn_t last_lsn = txn.GetPrevLSN();
+  while (writer.GetLogSize() < log_size) {
+    Transaction update_txn(txn_id++);
+    writer.Begin(&update_txn);
+    for (int i = 0; i < 100; i++) {
+      writer.Update(&update_txn, rids[dis(gen)],
+                    MakeTuple('a' + i % 26, 100));
+    }
+    writer.End(&update_txn, LogRecordType::COMMIT);
+    last_lsn = update_txn.GetPrevLSN();
+  }
+  log_manager->WaitForFlush(last_lsn);
+  delete log_manager;
+  delete buffer_pool_manager;
+
+  for (size_t num_workers = 1; num_workers <= 8; num_workers *= 2) {
+    buffer_pool_manager =
+        new BufferPoolManagerInstance(num_pages, disk_manager);
+    LogRecovery log_recovery(disk_manager, buffer_pool_manager, nullptr,
+                             num_workers);
+    auto start = std::chrono::steady_clock::now();
+    log_recovery.Redo();
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    std::cout << "redo workers: " << num_workers << " log MB/sec: "
+              << static_cast<long>(writer.GetLogSize() / elapsed.count() /
+                                   (1 << 20))
+              << std::endl;
+    delete buffer_pool_manager;
+  }
+
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
 TEST(LogManagerTest, BasicLogging) {
   StorageEngine *storage_engine = new StorageEngine("test.db");
 
@@ -41,8 +1041,10 @@ TEST(LogManagerTest, BasicLogging) {
   LOG_DEBUG("Turning off flushing thread");
 
   // some basic manually checking here
-  char buffer[PAGE_SIZE];
-  storage_engine->disk_manager_->ReadLog(buffer, PAGE_SIZE, 0);
+  size_t page_size = storage_engine->disk_manager_->GetPageSize();
+  std::vector<char> log(page_size);
+  char *buffer = log.data();
+  storage_engine->disk_manager_->ReadLog(buffer, page_size, 0);
   int32_t size = *reinterpret_cast<int32_t *>(buffer);
   LOG_DEBUG("size  = %d", size);
   size = *reinterpret_cast<int32_t *>(buffer + 20);
@@ -1,7 +1,7 @@
 #include <cstdio>
 #include <cstdlib>
 
-#include "buffer/buffer_pool_manager.h"
+#include "buffer/buffer_pool_manager_instance.h"
 #include "page/header_page.h"
 #include "gtest/gtest.h"
 
@@ -10,9 +10,9 @@
 namespace scudb {
 
 TEST(HeaderPageTest, UnitTest) {
-  DiskManager *disk_manager = new DiskManager("test.db");
+  DiskManager *disk_manager = new DiskManager("test.db", 4096);
   BufferPoolManager *buffer_pool_manager =
-      new BufferPoolManager(20, disk_manager);
+      new BufferPoolManagerInstance(20, disk_manager);
   page_id_t header_page_id;
   HeaderPage *page =
       static_cast<HeaderPage *>(buffer_pool_manager->NewPage(header_page_id));
@@ -50,6 +50,7 @@ TEST(HeaderPageTest, UnitTest) {
 
   EXPECT_EQ(page->GetRecordCount(), 0);
 
+  buffer_pool_manager->UnpinPage(header_page_id, true);
   delete buffer_pool_manager;
   delete disk_manager;
   remove("test.db");
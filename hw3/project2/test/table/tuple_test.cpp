@@ -8,7 +8,7 @@
 #include <string>
 #include <vector>
 
-#include "buffer/buffer_pool_manager.h"
+#include "buffer/buffer_pool_manager_instance.h"
 #include "logging/common.h"
 #include "table/table_heap.h"
 #include "table/tuple.h"
@@ -25,9 +25,9 @@ TEST(TupleTest, TableHeapTest) {
 
   // create transaction
   Transaction *transaction = new Transaction(0);
-  DiskManager *disk_manager = new DiskManager("test.db");
+  DiskManager *disk_manager = new DiskManager("test.db", TEST_PAGE_SIZE);
   BufferPoolManager *buffer_pool_manager =
-      new BufferPoolManager(50, disk_manager);
+      new BufferPoolManagerInstance(50, disk_manager);
   LockManager *lock_manager = new LockManager(true);
   LogManager *log_manager = new LogManager(disk_manager);
   TableHeap *table = new TableHeap(buffer_pool_manager, lock_manager,
@@ -61,4 +61,59 @@ TEST(TupleTest, TableHeapTest) {
   delete disk_manager;
 }
 
+TEST(TupleTest, AccessStrategyTest) {
+  remove("test.db");
+  Schema *schema = ParseCreateStatement("a varchar, b bigint");
+  Tuple tuple = ConstructTuple(schema);
+
+  Transaction *transaction = new Transaction(0);
+  DiskManager *disk_manager = new DiskManager("test.db", 4096);
+  BufferPoolManager *buffer_pool_manager =
+      new BufferPoolManagerInstance(20, disk_manager);
+  LockManager *lock_manager = new LockManager(true);
+  LogManager *log_manager = new LogManager(disk_manager);
+  page_id_t hot_page_id;
+  ASSERT_NE(nullptr, buffer_pool_manager->NewPage(hot_page_id));
+  buffer_pool_manager->UnpinPage(hot_page_id, true);
+
+  // load through the transaction, scan through the iterator
+  BufferAccessStrategy load(4);
+  transaction->SetBufferAccessStrategy(&load);
+  TableHeap *table = new TableHeap(buffer_pool_manager, lock_manager,
+                                   log_manager, transaction);
+  RID rid;
+  for (int i = 0; i < 2000; ++i) {
+    EXPECT_TRUE(table->InsertTuple(tuple, rid, transaction));
+  }
+  transaction->SetBufferAccessStrategy(nullptr);
+
+  BufferAccessStrategy scan(4);
+  int count = 0;
+  for (auto itr = table->begin(transaction, &scan); itr != table->end();
+       ++itr) {
+    count++;
+  }
+  EXPECT_EQ(2000, count);
+  BufferPoolStats stats = buffer_pool_manager->GetStats();
+  EXPECT_GT(stats.ring_reuses, 0);
+  // the hot page, the two rings and at most the readahead queue, a quarter
+  // of the pool
+  EXPECT_GE(stats.free_frames, 20 - 1 - 4 - 4 - 5);
+
+  // the rest of the pool was left alone
+  ASSERT_NE(nullptr, buffer_pool_manager->FetchPage(hot_page_id));
+  buffer_pool_manager->UnpinPage(hot_page_id, false);
+  EXPECT_EQ(stats.misses, buffer_pool_manager->GetStats().misses);
+
+  delete table;
+  delete buffer_pool_manager;
+  delete lock_manager;
+  delete log_manager;
+  delete disk_manager;
+  delete transaction;
+  delete schema;
+  remove("test.db");
+  remove("test.log");
+}
+
 } // namespace scudb